@@ -1,12 +1,16 @@
 #include "Aircraft.hpp"
 #include "CommandQueue.hpp"
 #include "DataTables.hpp"
+#ifdef SCOUT_STATIC_TABLES
+#include "StaticTables.hpp"
+#endif
 #include "NetworkNode.hpp"
 #include "Pickup.hpp"
 #include "ResourceHolder.hpp"
 #include "SoundNode.hpp"
 #include "StringUtils.hpp"
 #include "TextNode.hpp"
+#include "TextureAtlas.hpp"
 #include "MathUtils.hpp"
 #include "WindowUtils.hpp"
 
@@ -17,13 +21,17 @@
 
 namespace
 {
-  const std::vector<AircraftData> Table = initializeAircraftData();
+  // Looked up on every use, DataTables swaps its tables on reload
+  const std::vector<AircraftData>& table()
+  {
+    return DataTables::getInstance().getAircraftData();
+  }
 }
 
 Aircraft::Aircraft(Type type, const TextureHolder& textures, const FontHolder& fonts) :
-  Entity(Table[type].hitpoints),
+  Entity(table()[type].hitpoints),
   type(type),
-  sprite(textures.get(Table[type].texture), Table[type].textureRect),
+  sprite(textures.get(table()[type].texture), TextureAtlas::getInstance().getRect(table()[type].texture, table()[type].textureRect)),
   explosion(textures.get(Textures::Explosion)),
   fireCommand(),
   missileCommand(),
@@ -44,6 +52,7 @@ Aircraft::Aircraft(Type type, const TextureHolder& textures, const FontHolder& f
   directionIndex(0),
   identifier(0)
 {
+  explosion.setTextureArea(TextureAtlas::getInstance().getArea(Textures::Explosion, textures.get(Textures::Explosion)));
   explosion.setFrameSize(sf::Vector2i(256, 256));
   explosion.setNumFrames(16);
   explosion.setDuration(sf::seconds(1));
@@ -189,7 +198,11 @@ bool Aircraft::isAllied() const
 
 float Aircraft::getMaxSpeed() const
 {
-  return Table[type].speed;
+#ifdef SCOUT_STATIC_TABLES
+  return StaticTables::AircraftTable[type].speed;
+#else
+  return table()[type].speed;
+#endif
 }
 
 void Aircraft::increaseFireRate()
@@ -212,7 +225,11 @@ void Aircraft::collectMissiles(unsigned int count)
 void Aircraft::fire()
 {
   // Only ships with fire interval != 0 are able to fire
-  if(Table[type].fireInterval != sf::Time::Zero)
+#ifdef SCOUT_STATIC_TABLES
+  if(StaticTables::AircraftTable[type].fireInterval != 0.f)
+#else
+  if(table()[type].fireInterval != sf::Time::Zero)
+#endif
     isFiring = true;
 }
 
@@ -253,9 +270,13 @@ void Aircraft::setIdentifier(int identifier)
 void Aircraft::updateMovementPattern(sf::Time dt)
 {
   // Enemy airplane: Movement pattern
-  const std::vector<Direction>& directions = Table[type].directions;
+  const std::vector<Direction>& directions = table()[type].directions;
   if(!directions.empty())
   {
+    // A reloaded table may have fewer directions than the one this
+    // aircraft started with
+    directionIndex %= directions.size();
+
     // Moved long enough in current direction: Change direction
     if(travelledDistance > directions[directionIndex].distance)
     {
@@ -385,9 +406,9 @@ void Aircraft::updateTexts()
 
 void Aircraft::updateRollAnimation()
 {
-  if(Table[type].hasRollAnimation)
+  if(table()[type].hasRollAnimation)
   {
-    sf::IntRect textureRect = Table[type].textureRect;
+    sf::IntRect textureRect = table()[type].textureRect;
 
     // Roll left: Texture rect offset once
     if(getVelocity().x < 0.f)
@@ -397,6 +418,6 @@ void Aircraft::updateRollAnimation()
     if(getVelocity().x > 0.f)
       textureRect.left += 2 * textureRect.width;
 
-    sprite.setTextureRect(textureRect);
+    sprite.setTextureRect(TextureAtlas::getInstance().getRect(table()[type].texture, textureRect));
   }
 }
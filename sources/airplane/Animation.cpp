@@ -5,6 +5,7 @@
 
 Animation::Animation() :
     sprite(),
+    textureArea(),
     frameSize(),
     numFrames(0),
     currentFrame(0),
@@ -16,6 +17,7 @@ Animation::Animation() :
 
 Animation::Animation(const sf::Texture& texture) :
     sprite(texture),
+    textureArea(),
     frameSize(),
     numFrames(0),
     currentFrame(0),
@@ -35,6 +37,11 @@ const sf::Texture* Animation::getTexture() const
   return sprite.getTexture();
 }
 
+void Animation::setTextureArea(const sf::IntRect& area)
+{
+  textureArea = area;
+}
+
 void Animation::setFrameSize(sf::Vector2i frameSize)
 {
   this->frameSize = frameSize;
@@ -100,11 +107,14 @@ void Animation::update(sf::Time dt)
   sf::Time timePerFrame = duration / static_cast<float>(numFrames);
   elapsedTime += dt;
 
-  sf::Vector2i textureBounds(sprite.getTexture()->getSize());
+  sf::IntRect area = textureArea;
+  if(area.width == 0)
+    area = sf::IntRect(sf::Vector2i(), sf::Vector2i(sprite.getTexture()->getSize()));
+
   sf::IntRect textureRect = sprite.getTextureRect();
 
   if(currentFrame == 0)
-    textureRect = sf::IntRect(0, 0, frameSize.x, frameSize.y);
+    textureRect = sf::IntRect(area.left, area.top, frameSize.x, frameSize.y);
 
   // While we have a frame to process
   while(elapsedTime >= timePerFrame && (currentFrame <= numFrames || repeat))
@@ -113,10 +123,10 @@ void Animation::update(sf::Time dt)
     textureRect.left += textureRect.width;
 
     // If we reach the end of the texture
-    if(textureRect.left + textureRect.width > textureBounds.x)
+    if(textureRect.left + textureRect.width > area.left + area.width)
     {
       // Move it down on line
-      textureRect.left = 0;
+      textureRect.left = area.left;
       textureRect.top += textureRect.height;
     }
 
@@ -126,7 +136,7 @@ void Animation::update(sf::Time dt)
     {
       currentFrame = (currentFrame + 1) % numFrames;
       if(currentFrame == 0)
-        textureRect = sf::IntRect(0, 0, frameSize.x, frameSize.y);
+        textureRect = sf::IntRect(area.left, area.top, frameSize.x, frameSize.y);
     }
     else
     {
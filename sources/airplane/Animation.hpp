@@ -13,6 +13,9 @@ class Animation : public sf::Drawable, public sf::Transformable
     void setTexture(const sf::Texture& texture);
     const sf::Texture* getTexture() const;
 
+    // Part of the texture holding the frames, the whole texture by default
+    void setTextureArea(const sf::IntRect& area);
+
     void setFrameSize(sf::Vector2i frameSize);
     sf::Vector2i getFrameSize() const;
 
@@ -35,6 +38,7 @@ class Animation : public sf::Drawable, public sf::Transformable
 
   private:
     sf::Sprite sprite;
+    sf::IntRect textureArea;
     sf::Vector2i frameSize;
     std::size_t numFrames;
     std::size_t currentFrame;
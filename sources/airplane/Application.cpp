@@ -1,17 +1,38 @@
 #include "Application.hpp"
+#include "AssetLoader.hpp"
+#include "AssetPack.hpp"
+#include "DataTables.hpp"
 #include "State.hpp"
 #include "StateIdentifiers.hpp"
 #include "StringUtils.hpp"
 #include "GameOverState.hpp"
 #include "GameState.hpp"
+#include "LoadingState.hpp"
 #include "MenuState.hpp"
 #include "MultiplayerGameState.hpp"
 #include "PauseState.hpp"
 #include "SettingsState.hpp"
+#include "TextureAtlas.hpp"
 #include "TitleState.hpp"
+#include "World.hpp"
 
 const sf::Time Application::TimePerFrame = sf::seconds(1.f / 60.f);
 
+namespace
+{
+  // Part of each frame spent uploading decoded assets
+  const sf::Time AssetUploadBudget = sf::milliseconds(4);
+
+  // Built with the assetpack tool, loose files are used without it
+  const std::string AssetPackFile = "assets.pack";
+
+  // Built with the atlaspack tool, textures stay separate without it
+  const std::string AtlasTableFile = "assets/textures/Atlas.txt";
+
+  // Built with the tablec tool, the built-in tables are used without it
+  const std::string DataTablesFile = "assets/data/Tables.data";
+}
+
 Application::Application() :
   window(sf::VideoMode(1024, 768), "Scout", sf::Style::Close),
   fonts(),
@@ -27,21 +48,40 @@ Application::Application() :
 {
   window.setKeyRepeatEnabled(false);
 
+  // Opened before anything is loaded, the resources loaded from it may
+  // point into it until the end
+  AssetPack::getInstance().open(AssetPackFile);
+  TextureAtlas::getInstance().loadFromFile(AtlasTableFile);
+  DataTables::getInstance().loadFromFile(DataTablesFile);
+
+  // The loading screen needs the font right away, everything else is
+  // decoded in the background while it shows
   fonts.load(Fonts::Main, "assets/fonts/Sansation.ttf");
 
-  textures.load(Textures::TitleScreen, "assets/textures/TitleScreen.png");
-  textures.load(Textures::Buttons, "assets/textures/Buttons.png");
+  textures.loadAsync(Textures::TitleScreen, "assets/textures/TitleScreen.png");
+  textures.loadAsync(Textures::Buttons, "assets/textures/Buttons.png");
+  World::prefetchResources();
 
   statisticsText.setFont(fonts.get(Fonts::Main));
   statisticsText.setPosition(5.f, 5.f);
   statisticsText.setCharacterSize(10u);
 
   registerStates();
-  stateStack.pushState(States::Title);
+  stateStack.pushState(States::Loading);
 
   music.setVolume(25.f);
 }
 
+Application::~Application()
+{
+  // The caches are destroyed with the program, after the window and the
+  // audio device; what the holders still hold goes with them before
+  ResourceCache<sf::Font>::getInstance().clear();
+  ResourceCache<sf::Shader>::getInstance().clear();
+  ResourceCache<sf::SoundBuffer>::getInstance().clear();
+  ResourceCache<sf::Texture>::getInstance().clear();
+}
+
 void Application::run()
 {
   sf::Clock clock;
@@ -85,6 +125,10 @@ void Application::processInput()
 
 void Application::update(sf::Time dt)
 {
+  AssetLoader::getInstance().update(AssetUploadBudget);
+
+  // Between two frames, no entity is in the middle of reading the tables
+  DataTables::getInstance().reloadIfChanged();
   stateStack.update(dt);
 }
 
@@ -115,11 +159,13 @@ void Application::updateStatistics(sf::Time dt)
 
 void Application::registerStates()
 {
+  stateStack.registerState<LoadingState>(States::Loading, States::Title);
   stateStack.registerState<TitleState>(States::Title);
   stateStack.registerState<MenuState>(States::Menu);
   stateStack.registerState<GameState>(States::Game);
-  stateStack.registerState<MultiplayerGameState>(States::HostGame, true);
-  stateStack.registerState<MultiplayerGameState>(States::JoinGame, false);
+  stateStack.registerState<MultiplayerGameState>(States::HostGame, MultiplayerGameState::Hosting);
+  stateStack.registerState<MultiplayerGameState>(States::JoinGame, MultiplayerGameState::Joining);
+  stateStack.registerState<MultiplayerGameState>(States::SpectateGame, MultiplayerGameState::Spectating);
   stateStack.registerState<PauseState>(States::Pause);
   stateStack.registerState<PauseState>(States::NetworkPause, true);
   stateStack.registerState<SettingsState>(States::Settings);
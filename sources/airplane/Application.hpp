@@ -17,6 +17,7 @@ class Application : private sf::NonCopyable
 {
   public:
     Application();
+    ~Application();
 
     void run();
 
@@ -0,0 +1,101 @@
+#include "AssetDecoder.hpp"
+#include "AssetPack.hpp"
+
+#include <SFML/Audio/InputSoundFile.hpp>
+
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+  bool readFile(const std::string& filename, std::string& contents)
+  {
+    const void* data;
+    std::size_t size;
+    if(AssetPack::getInstance().find(filename, data, size))
+    {
+      contents.assign(static_cast<const char*>(data), size);
+      return true;
+    }
+
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if(!file)
+      return false;
+
+    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+  }
+}
+
+bool AssetDecoder<sf::Font>::decode(Staged& staged, const std::string& filename)
+{
+  staged.filename = filename;
+  if(!AssetPack::getInstance().find(filename, staged.data, staged.size))
+    staged.data = nullptr;
+  return true;
+}
+
+bool AssetDecoder<sf::Font>::upload(sf::Font& font, Staged& staged)
+{
+  if(staged.data)
+    return font.loadFromMemory(staged.data, staged.size);
+  return font.loadFromFile(staged.filename);
+}
+
+bool AssetDecoder<sf::Texture>::decode(Staged& staged, const std::string& filename)
+{
+  const void* data;
+  std::size_t size;
+  if(AssetPack::getInstance().find(filename, data, size))
+    return staged.image.loadFromMemory(data, size);
+  return staged.image.loadFromFile(filename);
+}
+
+bool AssetDecoder<sf::Texture>::upload(sf::Texture& texture, Staged& staged)
+{
+  return texture.loadFromImage(staged.image);
+}
+
+bool AssetDecoder<sf::SoundBuffer>::decode(Staged& staged, const std::string& filename)
+{
+  const void* data;
+  std::size_t size;
+  bool packed = AssetPack::getInstance().find(filename, data, size);
+
+  sf::InputSoundFile file;
+  if(!(packed ? file.openFromMemory(data, size) : file.openFromFile(filename)))
+    return false;
+
+  staged.samples.resize(static_cast<std::size_t>(file.getSampleCount()));
+  staged.samples.resize(static_cast<std::size_t>(file.read(staged.samples.data(), staged.samples.size())));
+  staged.channelCount = file.getChannelCount();
+  staged.sampleRate = file.getSampleRate();
+  return !staged.samples.empty();
+}
+
+bool AssetDecoder<sf::SoundBuffer>::upload(sf::SoundBuffer& buffer, Staged& staged)
+{
+  return buffer.loadFromSamples(staged.samples.data(), staged.samples.size(),
+      staged.channelCount, staged.sampleRate);
+}
+
+bool AssetDecoder<sf::Shader>::decode(Staged& staged, const std::string& vertexFile, const std::string& fragmentFile)
+{
+  staged.twoSources = true;
+  staged.type = sf::Shader::Vertex;
+  return readFile(vertexFile, staged.source) && readFile(fragmentFile, staged.secondSource);
+}
+
+bool AssetDecoder<sf::Shader>::decode(Staged& staged, const std::string& filename, sf::Shader::Type type)
+{
+  staged.twoSources = false;
+  staged.type = type;
+  return readFile(filename, staged.source);
+}
+
+bool AssetDecoder<sf::Shader>::upload(sf::Shader& shader, Staged& staged)
+{
+  if(staged.twoSources)
+    return shader.loadFromMemory(staged.source, staged.secondSource);
+  return shader.loadFromMemory(staged.source, staged.type);
+}
@@ -0,0 +1,116 @@
+#ifndef SOURCES_SCOUT_ASSETDECODER_HPP_
+#define SOURCES_SCOUT_ASSETDECODER_HPP_
+
+#include <SFML/Audio/SoundBuffer.hpp>
+#include <SFML/Config.hpp>
+#include <SFML/Graphics/Font.hpp>
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/Shader.hpp>
+#include <SFML/Graphics/Texture.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Splits the loading of a resource type for the AssetLoader: decode() runs
+// on a worker thread and fills Staged, upload() creates the resource from
+// it on the main thread.
+//
+// By default everything happens in upload(); types whose loading does real
+// work before touching the device have a specialization below. These read
+// their files from the AssetPack when it has them.
+template <typename Resource>
+struct AssetDecoder
+{
+  struct Staged
+  {
+    std::function<bool(Resource&)> load;
+  };
+
+  static bool decode(Staged& staged, const std::string& filename)
+  {
+    staged.load = [filename] (Resource& resource)
+    {
+      return resource.loadFromFile(filename);
+    };
+    return true;
+  }
+
+  template <typename Parameter>
+  static bool decode(Staged& staged, const std::string& filename, const Parameter& secondParam)
+  {
+    staged.load = [filename, secondParam] (Resource& resource)
+    {
+      return resource.loadFromFile(filename, secondParam);
+    };
+    return true;
+  }
+
+  static bool upload(Resource& resource, Staged& staged)
+  {
+    return staged.load(resource);
+  }
+};
+
+// Nothing to decode, but the font keeps reading from its memory while in
+// use, which the pack mapping allows
+template <>
+struct AssetDecoder<sf::Font>
+{
+  struct Staged
+  {
+    std::string filename;
+    const void* data;
+    std::size_t size;
+  };
+
+  static bool decode(Staged& staged, const std::string& filename);
+  static bool upload(sf::Font& font, Staged& staged);
+};
+
+// Image decoded on the worker, only the texture upload is left
+template <>
+struct AssetDecoder<sf::Texture>
+{
+  struct Staged
+  {
+    sf::Image image;
+  };
+
+  static bool decode(Staged& staged, const std::string& filename);
+  static bool upload(sf::Texture& texture, Staged& staged);
+};
+
+// Samples decoded on the worker, only the buffer upload is left
+template <>
+struct AssetDecoder<sf::SoundBuffer>
+{
+  struct Staged
+  {
+    std::vector<sf::Int16> samples;
+    unsigned int channelCount;
+    unsigned int sampleRate;
+  };
+
+  static bool decode(Staged& staged, const std::string& filename);
+  static bool upload(sf::SoundBuffer& buffer, Staged& staged);
+};
+
+// Sources read on the worker, only the compilation is left
+template <>
+struct AssetDecoder<sf::Shader>
+{
+  struct Staged
+  {
+    std::string source;
+    std::string secondSource; // fragment source when there are two files
+    sf::Shader::Type type;
+    bool twoSources;
+  };
+
+  static bool decode(Staged& staged, const std::string& vertexFile, const std::string& fragmentFile);
+  static bool decode(Staged& staged, const std::string& filename, sf::Shader::Type type);
+  static bool upload(sf::Shader& shader, Staged& staged);
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include "AssetLoader.hpp"
+#include "Foreach.hpp"
+
+#include <SFML/System/Clock.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+  // Decoding is mostly disk and inflate work, a few threads are plenty
+  const unsigned MaxWorkers = 4;
+
+  // Longest a waiting main thread sleeps before checking its handle again
+  const std::chrono::milliseconds UploadPollTime(10);
+}
+
+AssetLoader& AssetLoader::getInstance()
+{
+  static AssetLoader instance;
+  return instance;
+}
+
+AssetLoader::AssetLoader() :
+  workers(),
+  mutex(),
+  decodeReady(),
+  uploadReady(),
+  decodeQueue(),
+  uploadQueue(),
+  scheduledCount(0),
+  finishedCount(0),
+  stopping(false)
+{
+  // Leave a core to the main thread
+  unsigned cores = std::thread::hardware_concurrency();
+  unsigned count = std::max(1u, std::min(MaxWorkers, (cores > 1) ? cores - 1 : 1u));
+
+  for(unsigned i=0; i<count; ++i)
+  {
+    workers.push_back(std::unique_ptr<sf::Thread>(new sf::Thread(&AssetLoader::workerLoop, this)));
+    workers.back()->launch();
+  }
+}
+
+AssetLoader::~AssetLoader()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  decodeReady.notify_all();
+
+  FOREACH(std::unique_ptr<sf::Thread>& worker, workers)
+    worker->wait();
+}
+
+void AssetLoader::enqueue(DecodeTask decode, UploadTask upload)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    decodeQueue.push_back(std::make_pair(decode, upload));
+    scheduledCount++;
+  }
+  decodeReady.notify_one();
+}
+
+void AssetLoader::update(sf::Time budget)
+{
+  sf::Clock clock;
+  while(runUpload(false) && clock.getElapsedTime() < budget)
+  {
+  }
+}
+
+std::size_t AssetLoader::getScheduledCount() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return scheduledCount;
+}
+
+std::size_t AssetLoader::getFinishedCount() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return finishedCount;
+}
+
+bool AssetLoader::isIdle() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return scheduledCount == finishedCount;
+}
+
+void AssetLoader::workerLoop()
+{
+  while(true)
+  {
+    std::pair<DecodeTask, UploadTask> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      decodeReady.wait(lock, [this] ()
+      {
+        return stopping || !decodeQueue.empty();
+      });
+
+      if(stopping)
+        return;
+
+      task = decodeQueue.front();
+      decodeQueue.pop_front();
+    }
+
+    // A decoder that throws failed like one that returns false
+    bool decoded = false;
+    try
+    {
+      decoded = task.first();
+    }
+    catch (std::exception&)
+    {
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      Upload upload;
+      upload.task = task.second;
+      upload.decoded = decoded;
+      uploadQueue.push_back(upload);
+    }
+    uploadReady.notify_one();
+  }
+}
+
+bool AssetLoader::runUpload(bool waitForOne)
+{
+  Upload upload;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    if(uploadQueue.empty() && waitForOne)
+      uploadReady.wait_for(lock, UploadPollTime);
+
+    if(uploadQueue.empty())
+      return false;
+
+    upload = uploadQueue.front();
+    uploadQueue.pop_front();
+  }
+
+  upload.task(upload.decoded);
+
+  std::lock_guard<std::mutex> lock(mutex);
+  finishedCount++;
+
+  // Progress is counted per batch, start over once everything is done
+  if(finishedCount == scheduledCount)
+  {
+    scheduledCount = 0;
+    finishedCount = 0;
+  }
+  return true;
+}
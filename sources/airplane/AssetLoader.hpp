@@ -0,0 +1,77 @@
+#ifndef SOURCES_SCOUT_ASSETLOADER_HPP_
+#define SOURCES_SCOUT_ASSETLOADER_HPP_
+
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Thread.hpp>
+#include <SFML/System/Time.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Loads assets in two steps: decoding (reading and uncompressing the file)
+// runs on a pool of worker threads, while the upload to the graphics or
+// audio device runs on the main thread from update(), so the main thread
+// keeps drawing while the files are decoded.
+class AssetLoader : private sf::NonCopyable
+{
+  public:
+    typedef std::function<bool()> DecodeTask;
+    typedef std::function<void(bool)> UploadTask;
+
+    static AssetLoader& getInstance();
+
+    ~AssetLoader();
+
+    // decode runs on a worker, upload on the main thread with its result
+    void enqueue(DecodeTask decode, UploadTask upload);
+
+    // Main thread only: runs the uploads ready so far, spending roughly
+    // budget on them but always at least one
+    void update(sf::Time budget);
+
+    // Main thread only: runs uploads until the handle is ready
+    template <typename Result>
+    void wait(const std::shared_future<Result>& handle);
+
+    // Assets enqueued and finished since the loader was last idle
+    std::size_t getScheduledCount() const;
+    std::size_t getFinishedCount() const;
+    bool isIdle() const;
+
+  private:
+    struct Upload
+    {
+      UploadTask task;
+      bool decoded;
+    };
+
+    AssetLoader();
+
+    void workerLoop();
+    bool runUpload(bool waitForOne);
+
+    std::vector<std::unique_ptr<sf::Thread> > workers;
+    mutable std::mutex mutex;
+    std::condition_variable decodeReady;
+    std::condition_variable uploadReady;
+    std::deque<std::pair<DecodeTask, UploadTask> > decodeQueue;
+    std::deque<Upload> uploadQueue;
+    std::size_t scheduledCount;
+    std::size_t finishedCount;
+    bool stopping;
+};
+
+template <typename Result>
+void AssetLoader::wait(const std::shared_future<Result>& handle)
+{
+  while(handle.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    runUpload(true);
+}
+
+#endif
@@ -0,0 +1,259 @@
+#include "AssetPack.hpp"
+#include "Compression.hpp"
+
+#include <SFML/System/Lock.hpp>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+  // Reads little endian values off the index, false past its end
+  class IndexReader
+  {
+    public:
+      IndexReader(const char* data, std::size_t size) :
+        data(data),
+        size(size),
+        position(0)
+      {
+      }
+
+      bool read(sf::Uint32& value, std::size_t bytes)
+      {
+        if(position + bytes > size)
+          return false;
+
+        value = 0;
+        for(std::size_t i=0; i<bytes; ++i)
+          value |= static_cast<sf::Uint32>(static_cast<unsigned char>(data[position + i])) << (8 * i);
+        position += bytes;
+        return true;
+      }
+
+      bool read(std::string& value, std::size_t length)
+      {
+        if(position + length > size)
+          return false;
+
+        value.assign(data + position, length);
+        position += length;
+        return true;
+      }
+
+    private:
+      const char* data;
+      std::size_t size;
+      std::size_t position;
+  };
+}
+
+// The platform side of mapping the file
+struct AssetPack::Mapping
+{
+  Mapping() :
+#ifdef _WIN32
+    file(INVALID_HANDLE_VALUE),
+    view(NULL),
+#else
+    descriptor(-1),
+#endif
+    data(nullptr),
+    size(0)
+  {
+  }
+
+  ~Mapping()
+  {
+#ifdef _WIN32
+    if(data)
+      UnmapViewOfFile(data);
+    if(view)
+      CloseHandle(view);
+    if(file != INVALID_HANDLE_VALUE)
+      CloseHandle(file);
+#else
+    if(data)
+      munmap(const_cast<char*>(data), size);
+    if(descriptor >= 0)
+      ::close(descriptor);
+#endif
+  }
+
+  bool map(const std::string& filename)
+  {
+#ifdef _WIN32
+    file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE)
+      return false;
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+      return false;
+    size = static_cast<std::size_t>(fileSize.QuadPart);
+
+    view = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(!view)
+      return false;
+
+    data = static_cast<const char*>(MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0));
+#else
+    descriptor = ::open(filename.c_str(), O_RDONLY);
+    if(descriptor < 0)
+      return false;
+
+    struct stat status;
+    if(fstat(descriptor, &status) != 0 || status.st_size == 0)
+      return false;
+    size = static_cast<std::size_t>(status.st_size);
+
+    void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if(address == MAP_FAILED)
+      return false;
+    data = static_cast<const char*>(address);
+#endif
+    return data != nullptr;
+  }
+
+#ifdef _WIN32
+  HANDLE file;
+  HANDLE view;
+#else
+  int descriptor;
+#endif
+  const char* data;
+  std::size_t size;
+};
+
+const char AssetPack::Magic[4] = { 'S', 'C', 'P', 'K' };
+
+AssetPack& AssetPack::getInstance()
+{
+  static AssetPack instance;
+  return instance;
+}
+
+AssetPack::AssetPack() :
+  mapping(),
+  entries(),
+  inflateMutex(),
+  inflated()
+{
+}
+
+AssetPack::~AssetPack()
+{
+}
+
+bool AssetPack::open(const std::string& filename)
+{
+  close();
+
+  mapping.reset(new Mapping());
+  if(!mapping->map(filename) || !readIndex())
+  {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+void AssetPack::close()
+{
+  sf::Lock lock(inflateMutex);
+  inflated.clear();
+  entries.clear();
+  mapping.reset();
+}
+
+bool AssetPack::isOpen() const
+{
+  return mapping != nullptr;
+}
+
+bool AssetPack::find(const std::string& name, const void*& data, std::size_t& size) const
+{
+  auto found = entries.find(name);
+  if(found == entries.end())
+    return false;
+
+  const Entry& entry = found->second;
+  if(!(entry.flags & Compressed))
+  {
+    data = mapping->data + entry.offset;
+    size = entry.rawSize;
+    return true;
+  }
+
+  sf::Lock lock(inflateMutex);
+  auto buffer = inflated.find(name);
+  if(buffer == inflated.end())
+  {
+    std::vector<char> compressed(mapping->data + entry.offset, mapping->data + entry.offset + entry.storedSize);
+    std::vector<char> raw;
+    if(!Compression::decompress(compressed, entry.rawSize, raw))
+      return false;
+
+    buffer = inflated.insert(std::make_pair(name, std::vector<char>())).first;
+    buffer->second.swap(raw);
+  }
+
+  data = buffer->second.data();
+  size = buffer->second.size();
+  return true;
+}
+
+std::size_t AssetPack::getEntryCount() const
+{
+  return entries.size();
+}
+
+bool AssetPack::readIndex()
+{
+  IndexReader reader(mapping->data, mapping->size);
+
+  std::string magic;
+  sf::Uint32 version;
+  sf::Uint32 entryCount;
+  if(!reader.read(magic, sizeof(Magic)) || magic != std::string(Magic, sizeof(Magic)) ||
+      !reader.read(version, 1) || version != Version || !reader.read(entryCount, 4))
+    return false;
+
+  for(sf::Uint32 i=0; i<entryCount; ++i)
+  {
+    sf::Uint32 nameLength;
+    std::string name;
+    sf::Uint32 offset;
+    sf::Uint32 storedSize;
+    sf::Uint32 rawSize;
+    sf::Uint32 flags;
+    if(!reader.read(nameLength, 2) || !reader.read(name, nameLength) ||
+        !reader.read(offset, 4) || !reader.read(storedSize, 4) ||
+        !reader.read(rawSize, 4) || !reader.read(flags, 1))
+      return false;
+
+    // Entries must lie inside the file
+    if(offset > mapping->size || storedSize > mapping->size - offset)
+      return false;
+
+    Entry entry;
+    entry.offset = offset;
+    entry.storedSize = storedSize;
+    entry.rawSize = rawSize;
+    entry.flags = static_cast<sf::Uint8>(flags);
+    if(!(entry.flags & Compressed) && rawSize != storedSize)
+      return false;
+
+    entries[name] = entry;
+  }
+
+  return true;
+}
@@ -0,0 +1,70 @@
+#ifndef SOURCES_SCOUT_ASSETPACK_HPP_
+#define SOURCES_SCOUT_ASSETPACK_HPP_
+
+#include <SFML/Config.hpp>
+#include <SFML/System/Mutex.hpp>
+#include <SFML/System/NonCopyable.hpp>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Read-only archive of the asset files, built by the assetpack tool and
+// memory-mapped whole, so loading an asset from it needs no file access and
+// stored entries are handed out as pointers into the mapping.
+//
+// File layout, little endian:
+//   "SCPK" [Uint8:version] [Uint32:entryCount]
+//   entryCount times: [Uint16:nameLength] [name] [Uint32:offset]
+//                     [Uint32:storedSize] [Uint32:rawSize] [Uint8:flags]
+//   entry data, each entry starting at a multiple of Alignment
+// Names are the paths the game loads, like "assets/textures/Jungle.png".
+// Compressed entries (see Compression.hpp) are inflated on first use and
+// kept until the pack is closed.
+class AssetPack : private sf::NonCopyable
+{
+  public:
+    static const char Magic[4];
+    static const sf::Uint8 Version = 1;
+    static const std::size_t Alignment = 16;
+
+    enum Flags
+    {
+      Compressed = 1 << 0,
+    };
+
+    // The pack the game loads its assets from if one was opened
+    static AssetPack& getInstance();
+
+    AssetPack();
+    ~AssetPack();
+
+    bool open(const std::string& filename);
+    void close();
+    bool isOpen() const;
+
+    // The data stays valid until the pack is closed; safe from any thread
+    bool find(const std::string& name, const void*& data, std::size_t& size) const;
+    std::size_t getEntryCount() const;
+
+  private:
+    struct Entry
+    {
+      std::size_t offset;
+      std::size_t storedSize;
+      std::size_t rawSize;
+      sf::Uint8 flags;
+    };
+
+    struct Mapping;
+
+    std::unique_ptr<Mapping> mapping;
+    std::map<std::string, Entry> entries;
+    mutable sf::Mutex inflateMutex;
+    mutable std::map<std::string, std::vector<char> > inflated;
+
+    bool readIndex();
+};
+
+#endif
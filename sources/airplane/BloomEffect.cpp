@@ -1,15 +1,42 @@
 #include "BloomEffect.hpp"
 
+namespace
+{
+  const std::string VertexShader = "assets/shaders/Fullpass.vert";
+
+  struct ShaderFile
+  {
+    Shaders::ID id;
+    const char* fragmentFile;
+  };
+
+  const ShaderFile BloomShaders[] =
+  {
+    { Shaders::BrightnessPass, "assets/shaders/Brightness.frag" },
+    { Shaders::DownSamplePass, "assets/shaders/DownSample.frag" },
+    { Shaders::GaussianBlurPass, "assets/shaders/GuassianBlur.frag" },
+    { Shaders::AddPass, "assets/shaders/Add.frag" }
+  };
+
+  const std::size_t BloomShaderCount = sizeof(BloomShaders) / sizeof(BloomShaders[0]);
+}
+
 BloomEffect::BloomEffect() :
   shaders(),
   brightnessTexture(),
   firstPassTextures(),
   secondPassTextures()
 {
-  shaders.load(Shaders::BrightnessPass, "assets/shaders/Fullpass.vert", "assets/shaders/Brightness.frag");
-  shaders.load(Shaders::DownSamplePass, "assets/shaders/Fullpass.vert", "assets/shaders/DownSample.frag");
-  shaders.load(Shaders::GaussianBlurPass, "assets/shaders/Fullpass.vert", "assets/shaders/GuassianBlur.frag");
-  shaders.load(Shaders::AddPass, "assets/shaders/Fullpass.vert", "assets/shaders/Add.frag");
+  // Source files are read in the background, the shaders are compiled on
+  // their first use at the latest
+  for(std::size_t i=0; i<BloomShaderCount; ++i)
+    shaders.loadAsync(BloomShaders[i].id, VertexShader, std::string(BloomShaders[i].fragmentFile));
+}
+
+void BloomEffect::prefetchShaders()
+{
+  for(std::size_t i=0; i<BloomShaderCount; ++i)
+    ResourceCache<sf::Shader>::getInstance().acquireAsync(VertexShader, std::string(BloomShaders[i].fragmentFile), true);
 }
 
 void BloomEffect::apply(const sf::RenderTexture& input, sf::RenderTarget& output)
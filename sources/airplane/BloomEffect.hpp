@@ -15,6 +15,8 @@ class BloomEffect : public PostEffect
   public:
     BloomEffect();
 
+    static void prefetchShaders();
+
     virtual void apply(const sf::RenderTexture& input, sf::RenderTarget& output);
 
   private:
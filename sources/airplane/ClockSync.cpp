@@ -0,0 +1,83 @@
+#include "ClockSync.hpp"
+#include "Foreach.hpp"
+
+namespace
+{
+  // Number of samples kept to pick the best estimate from
+  const std::size_t SampleWindow = 8;
+
+  // Request quickly until the window is filled, then only to track drift
+  const sf::Time FastRequestInterval = sf::seconds(0.25f);
+  const sf::Time SlowRequestInterval = sf::seconds(2.f);
+}
+
+ClockSync::ClockSync() :
+  samples(),
+  sampleCount(0),
+  roundTripTime(sf::Time::Zero),
+  offset(sf::Time::Zero)
+{
+}
+
+void ClockSync::reset(sf::Time serverTime, sf::Time localTime)
+{
+  // Coarse estimate (assumes zero latency) until real samples arrive
+  samples.clear();
+  sampleCount = 0;
+  roundTripTime = sf::Time::Zero;
+  offset = serverTime - localTime;
+}
+
+void ClockSync::addSample(sf::Time clientSendTime, sf::Time serverTime, sf::Time clientReceiveTime)
+{
+  // The server answers immediately, so its receive and send times are equal
+  // and the whole round trip is network (and queuing) delay
+  Sample sample;
+  sample.roundTripTime = clientReceiveTime - clientSendTime;
+  sample.offset = serverTime - (clientSendTime + sample.roundTripTime / 2.f);
+
+  // Ignore samples from before a reset or with a broken local clock
+  if(sample.roundTripTime < sf::Time::Zero)
+    return;
+
+  samples.push_back(sample);
+  if(samples.size() > SampleWindow)
+    samples.pop_front();
+  ++sampleCount;
+
+  // Trust the sample that spent the least time in queues
+  const Sample* best = &samples.front();
+  FOREACH(const Sample& candidate, samples)
+  {
+    if(candidate.roundTripTime < best->roundTripTime)
+      best = &candidate;
+  }
+
+  roundTripTime = best->roundTripTime;
+  offset = best->offset;
+}
+
+bool ClockSync::isSynchronized() const
+{
+  return sampleCount > 0;
+}
+
+sf::Time ClockSync::getRoundTripTime() const
+{
+  return roundTripTime;
+}
+
+sf::Time ClockSync::getOffset() const
+{
+  return offset;
+}
+
+sf::Time ClockSync::getServerTime(sf::Time localTime) const
+{
+  return localTime + offset;
+}
+
+sf::Time ClockSync::getRequestInterval() const
+{
+  return (sampleCount < SampleWindow) ? FastRequestInterval : SlowRequestInterval;
+}
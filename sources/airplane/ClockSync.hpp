@@ -0,0 +1,39 @@
+#ifndef SOURCES_SCOUT_CLOCKSYNC_HPP_
+#define SOURCES_SCOUT_CLOCKSYNC_HPP_
+
+#include <SFML/System/Time.hpp>
+
+#include <deque>
+
+// Estimates the round trip time and clock offset to the server using an
+// NTP-style request/response exchange. The sample with the smallest round
+// trip time in a sliding window is trusted most, since it suffered the least
+// queuing delay.
+class ClockSync
+{
+  public:
+    ClockSync();
+
+    void reset(sf::Time serverTime, sf::Time localTime);
+    void addSample(sf::Time clientSendTime, sf::Time serverTime, sf::Time clientReceiveTime);
+
+    bool isSynchronized() const;
+    sf::Time getRoundTripTime() const;
+    sf::Time getOffset() const;
+    sf::Time getServerTime(sf::Time localTime) const;
+    sf::Time getRequestInterval() const;
+
+  private:
+    struct Sample
+    {
+      sf::Time roundTripTime;
+      sf::Time offset;
+    };
+
+    std::deque<Sample> samples;
+    std::size_t sampleCount;
+    sf::Time roundTripTime;
+    sf::Time offset;
+};
+
+#endif
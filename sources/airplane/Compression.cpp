@@ -0,0 +1,116 @@
+#include "Compression.hpp"
+
+#include <algorithm>
+
+namespace
+{
+  const std::size_t MinMatch = 3;
+  const std::size_t MaxMatch = 0x7f + MinMatch;
+  const std::size_t MaxLiterals = 0x80;
+  const std::size_t MaxOffset = 0xffff;
+  const std::size_t HashBits = 12;
+
+  std::size_t hashAt(const unsigned char* data)
+  {
+    unsigned int value = data[0] | (data[1] << 8) | (data[2] << 16);
+    return (value * 2654435761u) >> (32 - HashBits);
+  }
+
+  void flushLiterals(std::vector<char>& output, const unsigned char* begin, const unsigned char* end)
+  {
+    while(begin < end)
+    {
+      std::size_t count = std::min<std::size_t>(end - begin, MaxLiterals);
+      output.push_back(static_cast<char>(count - 1));
+      output.insert(output.end(), begin, begin + count);
+      begin += count;
+    }
+  }
+}
+
+std::vector<char> Compression::compress(const void* data, std::size_t size)
+{
+  const unsigned char* input = static_cast<const unsigned char*>(data);
+  std::vector<char> output;
+  output.reserve(size / 2 + 16);
+
+  // Last position seen for each hash of three bytes, greedy matching
+  std::vector<std::size_t> table(std::size_t(1) << HashBits, size);
+
+  std::size_t literalStart = 0;
+  std::size_t position = 0;
+  while(position + MinMatch <= size)
+  {
+    std::size_t& candidate = table[hashAt(input + position)];
+    std::size_t match = candidate;
+    candidate = position;
+
+    std::size_t length = 0;
+    if(match < position && position - match <= MaxOffset)
+    {
+      std::size_t limit = std::min(MaxMatch, size - position);
+      while(length < limit && input[match + length] == input[position + length])
+        ++length;
+    }
+
+    if(length < MinMatch)
+    {
+      ++position;
+      continue;
+    }
+
+    flushLiterals(output, input + literalStart, input + position);
+
+    std::size_t offset = position - match;
+    output.push_back(static_cast<char>(0x80 | (length - MinMatch)));
+    output.push_back(static_cast<char>(offset & 0xff));
+    output.push_back(static_cast<char>(offset >> 8));
+
+    position += length;
+    literalStart = position;
+  }
+
+  flushLiterals(output, input + literalStart, input + size);
+  return output;
+}
+
+bool Compression::decompress(const std::vector<char>& compressed, std::size_t rawSize, std::vector<char>& output)
+{
+  output.clear();
+  output.reserve(rawSize);
+
+  std::size_t position = 0;
+  while(position < compressed.size())
+  {
+    unsigned char token = static_cast<unsigned char>(compressed[position++]);
+    if(token < 0x80)
+    {
+      std::size_t count = token + 1u;
+      if(position + count > compressed.size() || output.size() + count > rawSize)
+        return false;
+
+      output.insert(output.end(), compressed.begin() + position, compressed.begin() + position + count);
+      position += count;
+    }
+    else
+    {
+      if(position + 2 > compressed.size())
+        return false;
+
+      std::size_t length = (token & 0x7f) + MinMatch;
+      std::size_t offset = static_cast<unsigned char>(compressed[position]) |
+        (static_cast<unsigned char>(compressed[position + 1]) << 8);
+      position += 2;
+
+      if(offset == 0 || offset > output.size() || output.size() + length > rawSize)
+        return false;
+
+      // Byte by byte, the source may overlap what is being written
+      std::size_t from = output.size() - offset;
+      for(std::size_t i=0; i<length; ++i)
+        output.push_back(output[from + i]);
+    }
+  }
+
+  return output.size() == rawSize;
+}
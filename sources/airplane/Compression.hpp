@@ -0,0 +1,21 @@
+#ifndef SOURCES_SCOUT_COMPRESSION_HPP_
+#define SOURCES_SCOUT_COMPRESSION_HPP_
+
+#include <cstddef>
+#include <vector>
+
+// Small LZ77 byte compressor for network payloads, no external dependency.
+//
+// Stream of tokens:
+//   [0x00-0x7f]                  literal run of (token + 1) bytes follows
+//   [0x80-0xff] [offset:2 bytes] copy (token & 0x7f) + 3 bytes from offset
+//                                bytes back in the output (little endian)
+namespace Compression
+{
+  std::vector<char> compress(const void* data, std::size_t size);
+
+  // Fails on corrupt input or if the result is not exactly rawSize bytes
+  bool decompress(const std::vector<char>& compressed, std::size_t rawSize, std::vector<char>& output);
+}
+
+#endif
@@ -0,0 +1,83 @@
+#include "Compression.hpp"
+#include "TestUtils.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+// Compresses inputs of different shapes and checks they decompress to the
+// same bytes; damaged or truncated streams have to be rejected.
+namespace
+{
+  bool roundTrips(const std::vector<char>& input)
+  {
+    std::vector<char> compressed = Compression::compress(input.data(), input.size());
+    std::vector<char> output;
+    return Compression::decompress(compressed, input.size(), output) && output == input;
+  }
+
+  std::vector<char> randomBytes(std::size_t size, std::mt19937& random)
+  {
+    std::vector<char> bytes(size);
+    for(std::size_t i=0; i<size; ++i)
+      bytes[i] = static_cast<char>(random() & 0xff);
+    return bytes;
+  }
+
+  // Few distinct bytes, like the floats and identifiers of a game state
+  std::vector<char> repetitiveBytes(std::size_t size, std::mt19937& random)
+  {
+    std::vector<char> bytes(size);
+    for(std::size_t i=0; i<size; ++i)
+      bytes[i] = static_cast<char>((i % 16 < 8) ? i % 7 : random() % 4);
+    return bytes;
+  }
+}
+
+int main()
+{
+  std::mt19937 random(1234);
+
+  check(roundTrips(std::vector<char>()), "empty input");
+  check(roundTrips(std::vector<char>(1, 'x')), "single byte");
+  check(roundTrips(std::vector<char>(100000, 0)), "one long run");
+
+  // Sizes around the literal run and match length limits
+  for(std::size_t size=1; size<300; ++size)
+  {
+    check(roundTrips(randomBytes(size, random)), ("random bytes of size " + std::to_string(size)).c_str());
+    check(roundTrips(repetitiveBytes(size, random)), ("repetitive bytes of size " + std::to_string(size)).c_str());
+  }
+
+  // Longer than the largest match offset
+  std::vector<char> large = repetitiveBytes(200000, random);
+  check(roundTrips(large), "input beyond the largest offset");
+  check(roundTrips(randomBytes(200000, random)), "large random input");
+
+  std::vector<char> compressed = Compression::compress(large.data(), large.size());
+  check(compressed.size() < large.size(), "repetitive input gets smaller");
+
+  std::vector<char> output;
+  check(!Compression::decompress(compressed, large.size() - 1, output), "too small a raw size is rejected");
+  check(!Compression::decompress(compressed, large.size() + 1, output), "too large a raw size is rejected");
+
+  std::vector<char> small = repetitiveBytes(1000, random);
+  std::vector<char> smallCompressed = Compression::compress(small.data(), small.size());
+  bool rejectsTruncated = true;
+  for(std::size_t size=0; size<smallCompressed.size(); ++size)
+  {
+    std::vector<char> truncated(smallCompressed.begin(), smallCompressed.begin() + size);
+    if(Compression::decompress(truncated, small.size(), output))
+      rejectsTruncated = false;
+  }
+  check(rejectsTruncated, "truncated streams are rejected");
+
+  // A copy reaching back before the start of the output
+  std::vector<char> corrupt;
+  corrupt.push_back(static_cast<char>(0x80));
+  corrupt.push_back(5);
+  corrupt.push_back(0);
+  check(!Compression::decompress(corrupt, 3, output), "copies from before the output are rejected");
+
+  return testResult();
+}
@@ -0,0 +1,55 @@
+#include "Connection.hpp"
+#include "PacketLog.hpp"
+
+#include <SFML/Network/Packet.hpp>
+
+Connection::Connection() :
+  stats(),
+  recorder(nullptr),
+  recorderChannel(0)
+{
+}
+
+Connection::~Connection()
+{
+}
+
+sf::Socket::Status Connection::send(sf::Packet& packet)
+{
+  sf::Socket::Status status = sendPacket(packet);
+
+  stats.recordMessage(NetworkStats::Outgoing, packet);
+  stats.recordSendStatus(status);
+  if(recorder)
+    recorder->record(recorderChannel, NetworkStats::Outgoing, packet);
+  return status;
+}
+
+sf::Socket::Status Connection::receive(sf::Packet& packet)
+{
+  sf::Socket::Status status = receivePacket(packet);
+
+  if(status == sf::Socket::Done)
+  {
+    stats.recordMessage(NetworkStats::Incoming, packet);
+    if(recorder)
+      recorder->record(recorderChannel, NetworkStats::Incoming, packet);
+  }
+  return status;
+}
+
+void Connection::setRecorder(PacketRecorder* recorder, sf::Uint32 channel)
+{
+  this->recorder = recorder;
+  recorderChannel = channel;
+}
+
+NetworkStats& Connection::getStats()
+{
+  return stats;
+}
+
+const NetworkStats& Connection::getStats() const
+{
+  return stats;
+}
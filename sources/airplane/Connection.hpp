@@ -0,0 +1,43 @@
+#ifndef SOURCES_SCOUT_CONNECTION_HPP_
+#define SOURCES_SCOUT_CONNECTION_HPP_
+
+#include "NetworkStats.hpp"
+
+#include <SFML/Network/Socket.hpp>
+#include <SFML/System/NonCopyable.hpp>
+
+namespace sf
+{
+  class Packet;
+}
+
+class PacketRecorder;
+
+// A message transport that keeps traffic statistics for every message passing
+// through. Derived classes only move the packets (see TcpConnection and
+// LoopbackConnection), so both ends of the game never know which one they use
+class Connection : private sf::NonCopyable
+{
+  public:
+    Connection();
+    virtual ~Connection();
+
+    sf::Socket::Status send(sf::Packet& packet);
+    sf::Socket::Status receive(sf::Packet& packet);
+
+    void setRecorder(PacketRecorder* recorder, sf::Uint32 channel);
+
+    NetworkStats& getStats();
+    const NetworkStats& getStats() const;
+
+  protected:
+    virtual sf::Socket::Status sendPacket(sf::Packet& packet) = 0;
+    virtual sf::Socket::Status receivePacket(sf::Packet& packet) = 0;
+
+  private:
+    NetworkStats stats;
+    PacketRecorder* recorder;
+    sf::Uint32 recorderChannel;
+};
+
+#endif
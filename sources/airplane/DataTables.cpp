@@ -1,102 +1,220 @@
 #include "DataTables.hpp"
 #include "Aircraft.hpp"
+#include "AssetPack.hpp"
+#include "Foreach.hpp"
 #include "Particle.hpp"
 #include "Pickup.hpp"
 #include "Projectile.hpp"
 
+#ifdef SCOUT_STATIC_TABLES
+#include "StaticTables.hpp"
+#endif
+
+#include <sys/stat.h>
+
+#include <fstream>
+#include <iterator>
+
 // For std::bind() placeholders _1, _2, ...
 using namespace std::placeholders;
 
-std::vector<AircraftData> initializeAircraftData()
+namespace
 {
-  std::vector<AircraftData> data(Aircraft::TypeCount);
-
-  data[Aircraft::Eagle].hitpoints = 100;
-  data[Aircraft::Eagle].speed = 200.f;
-  data[Aircraft::Eagle].texture = Textures::Entities;
-  data[Aircraft::Eagle].textureRect = sf::IntRect(0, 0, 48, 64);
-  data[Aircraft::Eagle].fireInterval = sf::seconds(1);
-  data[Aircraft::Eagle].hasRollAnimation = true;
-
-  data[Aircraft::Raptor].hitpoints = 20;
-  data[Aircraft::Raptor].speed = 80.f;
-  data[Aircraft::Raptor].texture = Textures::Entities;
-  data[Aircraft::Raptor].textureRect = sf::IntRect(144, 0, 84, 64);
-  data[Aircraft::Raptor].directions.push_back(Direction(45,80));
-  data[Aircraft::Raptor].directions.push_back(Direction(-45,160));
-  data[Aircraft::Raptor].directions.push_back(Direction(45,80));
-  data[Aircraft::Raptor].fireInterval = sf::Time::Zero;
-  data[Aircraft::Raptor].hasRollAnimation = false;
-
-  data[Aircraft::Avenger].hitpoints = 40;
-  data[Aircraft::Avenger].speed = 50.f;
-  data[Aircraft::Avenger].texture = Textures::Entities;
-  data[Aircraft::Avenger].textureRect = sf::IntRect(228, 0, 60, 59);
-  data[Aircraft::Avenger].directions.push_back(Direction(45,50));
-  data[Aircraft::Avenger].directions.push_back(Direction(0,50));
-  data[Aircraft::Avenger].directions.push_back(Direction(-45,100));
-  data[Aircraft::Avenger].directions.push_back(Direction(0,50));
-  data[Aircraft::Avenger].directions.push_back(Direction(45,50));
-  data[Aircraft::Avenger].fireInterval = sf::seconds(2);
-  data[Aircraft::Avenger].hasRollAnimation = false;
-
-  return data;
+  // Tables files are only looked at again after this long
+  const sf::Time ReloadCheckInterval = sf::seconds(1.f);
+
+#ifdef SCOUT_STATIC_TABLES
+  static_assert(sizeof(StaticTables::AircraftTable) / sizeof(StaticTables::AircraftTable[0]) == Aircraft::TypeCount,
+      "StaticTables.hpp does not match the entity types");
+  static_assert(sizeof(StaticTables::ProjectileTable) / sizeof(StaticTables::ProjectileTable[0]) == Projectile::TypeCount,
+      "StaticTables.hpp does not match the entity types");
+  static_assert(sizeof(StaticTables::PickupTable) / sizeof(StaticTables::PickupTable[0]) == Pickup::TypeCount,
+      "StaticTables.hpp does not match the entity types");
+  static_assert(sizeof(StaticTables::ParticleTable) / sizeof(StaticTables::ParticleTable[0]) == Particle::ParticleCount,
+      "StaticTables.hpp does not match the entity types");
+
+  sf::IntRect toRect(const int (&rect)[4])
+  {
+    return sf::IntRect(rect[0], rect[1], rect[2], rect[3]);
+  }
+#endif
+
+  // The value is all a file says about a pickup, its action is code
+  std::function<void(Aircraft&)> makePickupAction(Pickup::Type type, int value)
+  {
+    switch(type)
+    {
+      case Pickup::HealthRefill:
+        return [value] (Aircraft& a) { a.repair(value); };
+      case Pickup::MissileRefill:
+        return std::bind(&Aircraft::collectMissiles, _1, static_cast<unsigned int>(value));
+      case Pickup::FireSpread:
+        return std::bind(&Aircraft::increaseSpread, _1);
+      case Pickup::FireRate:
+        return std::bind(&Aircraft::increaseFireRate, _1);
+      default:
+        return [] (Aircraft&) {};
+    }
+  }
+
+  // The format only holds the values, the actions are attached here
+  void attachPickupActions(std::vector<PickupData>& pickups)
+  {
+    for(std::size_t i=0; i<pickups.size(); ++i)
+      pickups[i].action = makePickupAction(static_cast<Pickup::Type>(i), pickups[i].value);
+  }
+
+  bool getModificationTime(const std::string& filename, std::time_t& time)
+  {
+    struct stat status;
+    if(stat(filename.c_str(), &status) != 0)
+      return false;
+
+    time = status.st_mtime;
+    return true;
+  }
 }
 
-std::vector<ProjectileData> initializeProjectileData()
-{
-  std::vector<ProjectileData> data(Projectile::TypeCount);
-
-  data[Projectile::AlliedBullet].damage = 10;
-  data[Projectile::AlliedBullet].speed = 300.f;
-  data[Projectile::AlliedBullet].texture = Textures::Entities;
-  data[Projectile::AlliedBullet].textureRect = sf::IntRect(175, 64, 3, 14);
 
-  data[Projectile::EnemyBullet].damage = 10;
-  data[Projectile::EnemyBullet].speed = 300.f;
-  data[Projectile::EnemyBullet].texture = Textures::Entities;
-  data[Projectile::EnemyBullet].textureRect = sf::IntRect(178, 64, 3, 14);
-
-  data[Projectile::Missile].damage = 200;
-  data[Projectile::Missile].speed = 150.f;
-  data[Projectile::Missile].texture = Textures::Entities;
-  data[Projectile::Missile].textureRect = sf::IntRect(160, 64, 15, 32);
-
-  return data;
+DataTables& DataTables::getInstance()
+{
+  static DataTables instance;
+  return instance;
 }
 
-std::vector<PickupData> initializePickupData()
+DataTables::DataTables() :
+  tables(),
+  watchedFile(),
+  modificationTime(0),
+  checkClock()
 {
-  std::vector<PickupData> data(Pickup::TypeCount);
-
-  data[Pickup::HealthRefill].texture = Textures::Entities;
-  data[Pickup::HealthRefill].textureRect = sf::IntRect(0, 64, 40, 40);
-  data[Pickup::HealthRefill].action = [] (Aircraft& a) { a.repair(25); };
+  std::unique_ptr<GameTables> builtIn(new GameTables());
+#ifdef SCOUT_STATIC_TABLES
+  // Same data as the constants the hot paths read, for everything else
+  using namespace StaticTables;
+  for(std::size_t i=0; i<Aircraft::TypeCount; ++i)
+  {
+    const AircraftEntry& entry = AircraftTable[i];
+    AircraftData data;
+    data.hitpoints = entry.hitpoints;
+    data.speed = entry.speed;
+    data.texture = static_cast<Textures::ID>(entry.texture);
+    data.textureRect = toRect(entry.textureRect);
+    data.fireInterval = sf::seconds(entry.fireInterval);
+    for(int j=0; j<entry.directionCount; ++j)
+    {
+      const DirectionEntry& direction = DirectionTable[entry.firstDirection + j];
+      data.directions.push_back(Direction(direction.angle, direction.distance));
+    }
+    data.hasRollAnimation = entry.hasRollAnimation;
+    builtIn->aircraft.push_back(data);
+  }
+
+  for(std::size_t i=0; i<Projectile::TypeCount; ++i)
+  {
+    ProjectileData data;
+    data.damage = ProjectileTable[i].damage;
+    data.speed = ProjectileTable[i].speed;
+    data.texture = static_cast<Textures::ID>(ProjectileTable[i].texture);
+    data.textureRect = toRect(ProjectileTable[i].textureRect);
+    builtIn->projectiles.push_back(data);
+  }
+
+  for(std::size_t i=0; i<Pickup::TypeCount; ++i)
+  {
+    PickupData data;
+    data.value = PickupTable[i].value;
+    data.texture = static_cast<Textures::ID>(PickupTable[i].texture);
+    data.textureRect = toRect(PickupTable[i].textureRect);
+    builtIn->pickups.push_back(data);
+  }
+
+  for(std::size_t i=0; i<Particle::ParticleCount; ++i)
+  {
+    const int (&color)[4] = ParticleTable[i].color;
+    ParticleData data;
+    data.color = sf::Color(static_cast<sf::Uint8>(color[0]), static_cast<sf::Uint8>(color[1]),
+        static_cast<sf::Uint8>(color[2]), static_cast<sf::Uint8>(color[3]));
+    data.lifetime = sf::seconds(ParticleTable[i].lifetime);
+    builtIn->particles.push_back(data);
+  }
+#else
+  builtIn->aircraft = initializeAircraftData();
+  builtIn->projectiles = initializeProjectileData();
+  builtIn->pickups = initializePickupData();
+  builtIn->particles = initializeParticleData();
+#endif
+  attachPickupActions(builtIn->pickups);
+  tables = std::move(builtIn);
+}
 
-  data[Pickup::MissileRefill].texture = Textures::Entities;
-  data[Pickup::MissileRefill].textureRect = sf::IntRect(40, 64, 40, 40);
-  data[Pickup::MissileRefill].action = std::bind(&Aircraft::collectMissiles, _1, 3);
+bool DataTables::loadFromFile(const std::string& filename)
+{
+#ifdef SCOUT_STATIC_TABLES
+  // The tables are compiled in
+  (void)filename;
+  return false;
+#else
+  std::unique_ptr<GameTables> loaded(new GameTables());
+
+  std::time_t time;
+  if(getModificationTime(filename, time))
+  {
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if(!decode(contents.data(), contents.size(), *loaded))
+      return false;
+
+    watchedFile = filename;
+    modificationTime = time;
+    checkClock.restart();
+  }
+  else
+  {
+    const void* data;
+    std::size_t size;
+    if(!AssetPack::getInstance().find(filename, data, size) ||
+        !decode(static_cast<const char*>(data), size, *loaded))
+      return false;
+  }
+
+  attachPickupActions(loaded->pickups);
+  tables = std::move(loaded);
+  return true;
+#endif
+}
 
-  data[Pickup::FireSpread].texture = Textures::Entities;
-  data[Pickup::FireSpread].textureRect = sf::IntRect(80, 64, 40, 40);
-  data[Pickup::FireSpread].action = std::bind(&Aircraft::increaseSpread, _1);
+bool DataTables::reloadIfChanged()
+{
+  if(watchedFile.empty() || checkClock.getElapsedTime() < ReloadCheckInterval)
+    return false;
+  checkClock.restart();
 
-  data[Pickup::FireRate].texture = Textures::Entities;
-  data[Pickup::FireRate].textureRect = sf::IntRect(120, 64, 40, 40);
-  data[Pickup::FireRate].action = std::bind(&Aircraft::increaseFireRate, _1);
+  // A file caught halfway written does not decode, and is tried again on
+  // the next check
+  std::time_t time;
+  if(!getModificationTime(watchedFile, time) || time == modificationTime)
+    return false;
 
-  return data;
+  return loadFromFile(watchedFile);
 }
 
-std::vector<ParticleData> initializeParticleData()
+const std::vector<AircraftData>& DataTables::getAircraftData() const
 {
-  std::vector<ParticleData> data(Particle::ParticleCount);
+  return tables->aircraft;
+}
 
-  data[Particle::Propellant].color = sf::Color(255, 255, 50);
-  data[Particle::Propellant].lifetime = sf::seconds(0.6f);
+const std::vector<ProjectileData>& DataTables::getProjectileData() const
+{
+  return tables->projectiles;
+}
 
-  data[Particle::Smoke].color = sf::Color(50, 50, 50);
-  data[Particle::Smoke].lifetime = sf::seconds(4.f);
+const std::vector<PickupData>& DataTables::getPickupData() const
+{
+  return tables->pickups;
+}
 
-  return data;
+const std::vector<ParticleData>& DataTables::getParticleData() const
+{
+  return tables->particles;
 }
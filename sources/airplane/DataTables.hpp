@@ -3,11 +3,17 @@
 
 #include "ResourceIdentifiers.hpp"
 
+#include <SFML/Config.hpp>
 #include <SFML/Graphics/Color.hpp>
 #include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/NonCopyable.hpp>
 #include <SFML/System/Time.hpp>
 
+#include <ctime>
 #include <functional>
+#include <memory>
+#include <string>
 #include <vector>
 
 class Aircraft;
@@ -46,6 +52,7 @@ struct ProjectileData
 struct PickupData
 {
   std::function<void(Aircraft&)> action;
+  int value; // repaired hitpoints, collected missiles
   Textures::ID texture;
   sf::IntRect textureRect;
 };
@@ -56,9 +63,71 @@ struct ParticleData
   sf::Time lifetime;
 };
 
+// Built-in tables; pickup actions are code, DataTables attaches them
 std::vector<AircraftData> initializeAircraftData();
 std::vector<ProjectileData> initializeProjectileData();
 std::vector<PickupData> initializePickupData();
 std::vector<ParticleData> initializeParticleData();
 
+struct GameTables
+{
+  std::vector<AircraftData> aircraft;
+  std::vector<ProjectileData> projectiles;
+  std::vector<PickupData> pickups;
+  std::vector<ParticleData> particles;
+};
+
+// The tables entities read their data from: the built-in ones above, or
+// the ones of a file compiled by the tablec tool from a text source.
+//
+// A loaded file is watched; when it changes on disk it is read again and
+// the tables are swapped as a whole, keeping the previous ones if the new
+// file does not decode. Swaps only happen in reloadIfChanged(), which the
+// application calls between frames.
+//
+// File layout, little endian, floats stored as their bits:
+//   "SCDT" [Uint8:version]
+//   [Uint8:count] aircraft: [Int32:hitpoints] [float:speed] [Uint8:texture]
+//     [Int32 x4:textureRect] [float:fireInterval seconds]
+//     [Uint8:count] directions: [float:angle] [float:distance]
+//     [Uint8:hasRollAnimation]
+//   [Uint8:count] projectiles: [Int32:damage] [float:speed] [Uint8:texture]
+//     [Int32 x4:textureRect]
+//   [Uint8:count] pickups: [Int32:value] [Uint8:texture] [Int32 x4:textureRect]
+//   [Uint8:count] particles: [Uint8 x4:color] [float:lifetime seconds]
+// Each count must match the type count of its entity.
+//
+// SCOUT_STATIC_TABLES builds take the tables from StaticTables.hpp instead,
+// which the build generates from the tables source with tablec, and load no
+// files; hot paths read those constants directly.
+class DataTables : private sf::NonCopyable
+{
+  public:
+    static const char Magic[4];
+    static const sf::Uint8 Version = 1;
+
+    static DataTables& getInstance();
+
+    DataTables();
+
+    // From disk, else from the AssetPack (which is not watched)
+    bool loadFromFile(const std::string& filename);
+    bool reloadIfChanged();
+
+    const std::vector<AircraftData>& getAircraftData() const;
+    const std::vector<ProjectileData>& getProjectileData() const;
+    const std::vector<PickupData>& getPickupData() const;
+    const std::vector<ParticleData>& getParticleData() const;
+
+    // Decoded pickups have no action yet
+    static void encode(const GameTables& tables, std::vector<char>& output);
+    static bool decode(const char* data, std::size_t size, GameTables& tables);
+
+  private:
+    std::unique_ptr<const GameTables> tables;
+    std::string watchedFile;
+    std::time_t modificationTime;
+    sf::Clock checkClock;
+};
+
 #endif
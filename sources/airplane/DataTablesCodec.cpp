@@ -0,0 +1,331 @@
+#include "DataTables.hpp"
+#include "Aircraft.hpp"
+#include "Foreach.hpp"
+#include "Particle.hpp"
+#include "Pickup.hpp"
+#include "Projectile.hpp"
+
+#include <cstring>
+
+// The built-in tables and the file format; no game code, so the tablec tool
+// links this without the rest of the game
+namespace
+{
+  void write(std::vector<char>& output, sf::Uint32 value, std::size_t bytes)
+  {
+    for(std::size_t i=0; i<bytes; ++i)
+      output.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+
+  void write(std::vector<char>& output, float value)
+  {
+    sf::Uint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    write(output, bits, 4);
+  }
+
+  void write(std::vector<char>& output, const sf::IntRect& rect)
+  {
+    write(output, static_cast<sf::Uint32>(rect.left), 4);
+    write(output, static_cast<sf::Uint32>(rect.top), 4);
+    write(output, static_cast<sf::Uint32>(rect.width), 4);
+    write(output, static_cast<sf::Uint32>(rect.height), 4);
+  }
+
+  // Reads little endian values off the file, false past its end
+  class TableReader
+  {
+    public:
+      TableReader(const char* data, std::size_t size) :
+        data(data),
+        size(size),
+        position(0)
+      {
+      }
+
+      bool read(sf::Uint32& value, std::size_t bytes)
+      {
+        if(position + bytes > size)
+          return false;
+
+        value = 0;
+        for(std::size_t i=0; i<bytes; ++i)
+          value |= static_cast<sf::Uint32>(static_cast<unsigned char>(data[position + i])) << (8 * i);
+        position += bytes;
+        return true;
+      }
+
+      bool read(int& value)
+      {
+        sf::Uint32 bits;
+        if(!read(bits, 4))
+          return false;
+
+        value = static_cast<sf::Int32>(bits);
+        return true;
+      }
+
+      bool read(float& value)
+      {
+        sf::Uint32 bits;
+        if(!read(bits, 4))
+          return false;
+
+        std::memcpy(&value, &bits, sizeof(value));
+        return true;
+      }
+
+      bool read(sf::IntRect& rect)
+      {
+        return read(rect.left) && read(rect.top) && read(rect.width) && read(rect.height);
+      }
+
+      bool read(Textures::ID& texture)
+      {
+        sf::Uint32 value;
+        if(!read(value, 1) || value >= Textures::TextureCount)
+          return false;
+
+        texture = static_cast<Textures::ID>(value);
+        return true;
+      }
+
+      bool readCount(std::size_t expected)
+      {
+        sf::Uint32 count;
+        return read(count, 1) && count == expected;
+      }
+
+      bool atEnd() const
+      {
+        return position == size;
+      }
+
+    private:
+      const char* data;
+      std::size_t size;
+      std::size_t position;
+  };
+}
+
+std::vector<AircraftData> initializeAircraftData()
+{
+  std::vector<AircraftData> data(Aircraft::TypeCount);
+
+  data[Aircraft::Eagle].hitpoints = 100;
+  data[Aircraft::Eagle].speed = 200.f;
+  data[Aircraft::Eagle].texture = Textures::Entities;
+  data[Aircraft::Eagle].textureRect = sf::IntRect(0, 0, 48, 64);
+  data[Aircraft::Eagle].fireInterval = sf::seconds(1);
+  data[Aircraft::Eagle].hasRollAnimation = true;
+
+  data[Aircraft::Raptor].hitpoints = 20;
+  data[Aircraft::Raptor].speed = 80.f;
+  data[Aircraft::Raptor].texture = Textures::Entities;
+  data[Aircraft::Raptor].textureRect = sf::IntRect(144, 0, 84, 64);
+  data[Aircraft::Raptor].directions.push_back(Direction(45,80));
+  data[Aircraft::Raptor].directions.push_back(Direction(-45,160));
+  data[Aircraft::Raptor].directions.push_back(Direction(45,80));
+  data[Aircraft::Raptor].fireInterval = sf::Time::Zero;
+  data[Aircraft::Raptor].hasRollAnimation = false;
+
+  data[Aircraft::Avenger].hitpoints = 40;
+  data[Aircraft::Avenger].speed = 50.f;
+  data[Aircraft::Avenger].texture = Textures::Entities;
+  data[Aircraft::Avenger].textureRect = sf::IntRect(228, 0, 60, 59);
+  data[Aircraft::Avenger].directions.push_back(Direction(45,50));
+  data[Aircraft::Avenger].directions.push_back(Direction(0,50));
+  data[Aircraft::Avenger].directions.push_back(Direction(-45,100));
+  data[Aircraft::Avenger].directions.push_back(Direction(0,50));
+  data[Aircraft::Avenger].directions.push_back(Direction(45,50));
+  data[Aircraft::Avenger].fireInterval = sf::seconds(2);
+  data[Aircraft::Avenger].hasRollAnimation = false;
+
+  return data;
+}
+
+std::vector<ProjectileData> initializeProjectileData()
+{
+  std::vector<ProjectileData> data(Projectile::TypeCount);
+
+  data[Projectile::AlliedBullet].damage = 10;
+  data[Projectile::AlliedBullet].speed = 300.f;
+  data[Projectile::AlliedBullet].texture = Textures::Entities;
+  data[Projectile::AlliedBullet].textureRect = sf::IntRect(175, 64, 3, 14);
+
+  data[Projectile::EnemyBullet].damage = 10;
+  data[Projectile::EnemyBullet].speed = 300.f;
+  data[Projectile::EnemyBullet].texture = Textures::Entities;
+  data[Projectile::EnemyBullet].textureRect = sf::IntRect(178, 64, 3, 14);
+
+  data[Projectile::Missile].damage = 200;
+  data[Projectile::Missile].speed = 150.f;
+  data[Projectile::Missile].texture = Textures::Entities;
+  data[Projectile::Missile].textureRect = sf::IntRect(160, 64, 15, 32);
+
+  return data;
+}
+
+std::vector<PickupData> initializePickupData()
+{
+  std::vector<PickupData> data(Pickup::TypeCount);
+
+  data[Pickup::HealthRefill].texture = Textures::Entities;
+  data[Pickup::HealthRefill].textureRect = sf::IntRect(0, 64, 40, 40);
+  data[Pickup::HealthRefill].value = 25;
+
+  data[Pickup::MissileRefill].texture = Textures::Entities;
+  data[Pickup::MissileRefill].textureRect = sf::IntRect(40, 64, 40, 40);
+  data[Pickup::MissileRefill].value = 3;
+
+  data[Pickup::FireSpread].texture = Textures::Entities;
+  data[Pickup::FireSpread].textureRect = sf::IntRect(80, 64, 40, 40);
+  data[Pickup::FireSpread].value = 0;
+
+  data[Pickup::FireRate].texture = Textures::Entities;
+  data[Pickup::FireRate].textureRect = sf::IntRect(120, 64, 40, 40);
+  data[Pickup::FireRate].value = 0;
+
+  return data;
+}
+
+std::vector<ParticleData> initializeParticleData()
+{
+  std::vector<ParticleData> data(Particle::ParticleCount);
+
+  data[Particle::Propellant].color = sf::Color(255, 255, 50);
+  data[Particle::Propellant].lifetime = sf::seconds(0.6f);
+
+  data[Particle::Smoke].color = sf::Color(50, 50, 50);
+  data[Particle::Smoke].lifetime = sf::seconds(4.f);
+
+  return data;
+}
+
+const char DataTables::Magic[4] = { 'S', 'C', 'D', 'T' };
+
+void DataTables::encode(const GameTables& tables, std::vector<char>& output)
+{
+  output.assign(Magic, Magic + sizeof(Magic));
+  write(output, Version, 1);
+
+  write(output, static_cast<sf::Uint32>(tables.aircraft.size()), 1);
+  FOREACH(const AircraftData& data, tables.aircraft)
+  {
+    write(output, static_cast<sf::Uint32>(data.hitpoints), 4);
+    write(output, data.speed);
+    write(output, data.texture, 1);
+    write(output, data.textureRect);
+    write(output, data.fireInterval.asSeconds());
+    write(output, static_cast<sf::Uint32>(data.directions.size()), 1);
+    FOREACH(const Direction& direction, data.directions)
+    {
+      write(output, direction.angle);
+      write(output, direction.distance);
+    }
+    write(output, data.hasRollAnimation ? 1 : 0, 1);
+  }
+
+  write(output, static_cast<sf::Uint32>(tables.projectiles.size()), 1);
+  FOREACH(const ProjectileData& data, tables.projectiles)
+  {
+    write(output, static_cast<sf::Uint32>(data.damage), 4);
+    write(output, data.speed);
+    write(output, data.texture, 1);
+    write(output, data.textureRect);
+  }
+
+  write(output, static_cast<sf::Uint32>(tables.pickups.size()), 1);
+  FOREACH(const PickupData& data, tables.pickups)
+  {
+    write(output, static_cast<sf::Uint32>(data.value), 4);
+    write(output, data.texture, 1);
+    write(output, data.textureRect);
+  }
+
+  write(output, static_cast<sf::Uint32>(tables.particles.size()), 1);
+  FOREACH(const ParticleData& data, tables.particles)
+  {
+    write(output, data.color.r, 1);
+    write(output, data.color.g, 1);
+    write(output, data.color.b, 1);
+    write(output, data.color.a, 1);
+    write(output, data.lifetime.asSeconds());
+  }
+}
+
+bool DataTables::decode(const char* data, std::size_t size, GameTables& tables)
+{
+  if(size < sizeof(Magic) || std::memcmp(data, Magic, sizeof(Magic)) != 0)
+    return false;
+
+  TableReader reader(data + sizeof(Magic), size - sizeof(Magic));
+  sf::Uint32 version;
+  if(!reader.read(version, 1) || version != Version)
+    return false;
+
+  tables.aircraft.assign(Aircraft::TypeCount, AircraftData());
+  if(!reader.readCount(tables.aircraft.size()))
+    return false;
+  FOREACH(AircraftData& aircraft, tables.aircraft)
+  {
+    float fireInterval;
+    sf::Uint32 directionCount;
+    sf::Uint32 hasRollAnimation;
+    if(!reader.read(aircraft.hitpoints) || !reader.read(aircraft.speed) ||
+        !reader.read(aircraft.texture) || !reader.read(aircraft.textureRect) ||
+        !reader.read(fireInterval) || !reader.read(directionCount, 1))
+      return false;
+
+    aircraft.fireInterval = sf::seconds(fireInterval);
+    for(sf::Uint32 i=0; i<directionCount; ++i)
+    {
+      Direction direction(0.f, 0.f);
+      if(!reader.read(direction.angle) || !reader.read(direction.distance))
+        return false;
+      aircraft.directions.push_back(direction);
+    }
+
+    if(!reader.read(hasRollAnimation, 1))
+      return false;
+    aircraft.hasRollAnimation = hasRollAnimation != 0;
+  }
+
+  tables.projectiles.assign(Projectile::TypeCount, ProjectileData());
+  if(!reader.readCount(tables.projectiles.size()))
+    return false;
+  FOREACH(ProjectileData& projectile, tables.projectiles)
+  {
+    if(!reader.read(projectile.damage) || !reader.read(projectile.speed) ||
+        !reader.read(projectile.texture) || !reader.read(projectile.textureRect))
+      return false;
+  }
+
+  tables.pickups.assign(Pickup::TypeCount, PickupData());
+  if(!reader.readCount(tables.pickups.size()))
+    return false;
+  FOREACH(PickupData& pickup, tables.pickups)
+  {
+    if(!reader.read(pickup.value) || !reader.read(pickup.texture) || !reader.read(pickup.textureRect))
+      return false;
+  }
+
+  tables.particles.assign(Particle::ParticleCount, ParticleData());
+  if(!reader.readCount(tables.particles.size()))
+    return false;
+  FOREACH(ParticleData& particle, tables.particles)
+  {
+    sf::Uint32 r, g, b, a;
+    float lifetime;
+    if(!reader.read(r, 1) || !reader.read(g, 1) || !reader.read(b, 1) || !reader.read(a, 1) ||
+        !reader.read(lifetime))
+      return false;
+
+    particle.color = sf::Color(static_cast<sf::Uint8>(r), static_cast<sf::Uint8>(g),
+        static_cast<sf::Uint8>(b), static_cast<sf::Uint8>(a));
+    particle.lifetime = sf::seconds(lifetime);
+  }
+
+  // Trailing bytes mean a file of another layout
+  return reader.atEnd();
+}
@@ -0,0 +1,108 @@
+#include "DataTables.hpp"
+#include "TestUtils.hpp"
+
+#include <vector>
+
+// Encodes the built-in tables, decodes them again and compares; every
+// truncated or extended file has to be rejected.
+namespace
+{
+  GameTables builtInTables()
+  {
+    GameTables tables;
+    tables.aircraft = initializeAircraftData();
+    tables.projectiles = initializeProjectileData();
+    tables.pickups = initializePickupData();
+    tables.particles = initializeParticleData();
+    return tables;
+  }
+
+  bool equal(const AircraftData& lhs, const AircraftData& rhs)
+  {
+    if(lhs.directions.size() != rhs.directions.size())
+      return false;
+
+    for(std::size_t i=0; i<lhs.directions.size(); ++i)
+    {
+      if(lhs.directions[i].angle != rhs.directions[i].angle ||
+          lhs.directions[i].distance != rhs.directions[i].distance)
+        return false;
+    }
+
+    return lhs.hitpoints == rhs.hitpoints && lhs.speed == rhs.speed &&
+      lhs.texture == rhs.texture && lhs.textureRect == rhs.textureRect &&
+      lhs.fireInterval == rhs.fireInterval && lhs.hasRollAnimation == rhs.hasRollAnimation;
+  }
+
+  bool equal(const ProjectileData& lhs, const ProjectileData& rhs)
+  {
+    return lhs.damage == rhs.damage && lhs.speed == rhs.speed &&
+      lhs.texture == rhs.texture && lhs.textureRect == rhs.textureRect;
+  }
+
+  // Actions are attached by DataTables, the format holds only the value
+  bool equal(const PickupData& lhs, const PickupData& rhs)
+  {
+    return lhs.value == rhs.value && lhs.texture == rhs.texture &&
+      lhs.textureRect == rhs.textureRect;
+  }
+
+  bool equal(const ParticleData& lhs, const ParticleData& rhs)
+  {
+    return lhs.color == rhs.color && lhs.lifetime == rhs.lifetime;
+  }
+
+  template <typename Data>
+  bool equal(const std::vector<Data>& lhs, const std::vector<Data>& rhs)
+  {
+    if(lhs.size() != rhs.size())
+      return false;
+
+    for(std::size_t i=0; i<lhs.size(); ++i)
+    {
+      if(!equal(lhs[i], rhs[i]))
+        return false;
+    }
+    return true;
+  }
+}
+
+int main()
+{
+  GameTables tables = builtInTables();
+  std::vector<char> encoded;
+  DataTables::encode(tables, encoded);
+
+  GameTables decoded;
+  check(DataTables::decode(encoded.data(), encoded.size(), decoded), "encoded tables decode");
+  check(equal(tables.aircraft, decoded.aircraft), "aircraft data survives the round trip");
+  check(equal(tables.projectiles, decoded.projectiles), "projectile data survives the round trip");
+  check(equal(tables.pickups, decoded.pickups), "pickup data survives the round trip");
+  check(equal(tables.particles, decoded.particles), "particle data survives the round trip");
+
+  std::vector<char> reencoded;
+  DataTables::encode(decoded, reencoded);
+  check(reencoded == encoded, "decoded tables encode to the same bytes");
+
+  // Every prefix of the file is missing something
+  bool rejectsTruncated = true;
+  for(std::size_t size=0; size<encoded.size(); ++size)
+  {
+    GameTables truncated;
+    if(DataTables::decode(encoded.data(), size, truncated))
+      rejectsTruncated = false;
+  }
+  check(rejectsTruncated, "truncated tables are rejected");
+
+  std::vector<char> extended(encoded);
+  extended.push_back(0);
+  GameTables trailing;
+  check(!DataTables::decode(extended.data(), extended.size(), trailing), "trailing bytes are rejected");
+
+  std::vector<char> wrongVersion(encoded);
+  wrongVersion[sizeof(DataTables::Magic)] = static_cast<char>(DataTables::Version + 1);
+  GameTables versioned;
+  check(!DataTables::decode(wrongVersion.data(), wrongVersion.size(), versioned), "other versions are rejected");
+
+  return testResult();
+}
@@ -0,0 +1,230 @@
+#ifndef SOURCES_SCOUT_ENTITYTABLE_HPP_
+#define SOURCES_SCOUT_ENTITYTABLE_HPP_
+
+#include <SFML/Config.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Dense storage for server entities addressed by generational identifiers.
+//
+// Values are packed in one array (iterate with size()/getValue(i)) and
+// removal moves the last value into the hole. An identifier encodes a slot
+// index and that slot's generation, so a lookup is two array accesses and an
+// identifier of a removed entity never resolves to its slot's next owner.
+// Identifiers are always positive, they can go on the wire as they are.
+template <typename T>
+class EntityTable
+{
+  public:
+    EntityTable();
+
+    sf::Int32 insert(const T& value = T());
+
+    // Inserts under an identifier handed out before, e.g. by another
+    // process; fails if the identifier is invalid or its slot is taken
+    bool restore(sf::Int32 identifier, const T& value);
+    bool erase(sf::Int32 identifier);
+    void eraseAt(std::size_t position);
+
+    T* find(sf::Int32 identifier);
+    const T* find(sf::Int32 identifier) const;
+
+    std::size_t size() const;
+    bool empty() const;
+    sf::Int32 getIdentifier(std::size_t position) const;
+    T& getValue(std::size_t position);
+    const T& getValue(std::size_t position) const;
+
+  private:
+    struct Slot
+    {
+      sf::Uint32 position;
+      sf::Uint32 generation;
+    };
+
+    // 16 bits of slot index, 15 bits of generation (sign bit stays clear)
+    static const sf::Uint32 IndexBits = 16;
+    static const sf::Uint32 IndexMask = (1u << IndexBits) - 1;
+    static const sf::Uint32 GenerationMask = 0x7fff;
+
+    std::vector<Slot> slots;
+    std::vector<sf::Uint32> freeSlots;
+    std::vector<sf::Int32> identifiers;
+    std::vector<T> values;
+
+    Slot* findSlot(sf::Int32 identifier);
+    const Slot* findSlot(sf::Int32 identifier) const;
+};
+
+template <typename T>
+EntityTable<T>::EntityTable() :
+  slots(),
+  freeSlots(),
+  identifiers(),
+  values()
+{
+}
+
+template <typename T>
+sf::Int32 EntityTable<T>::insert(const T& value)
+{
+  sf::Uint32 index;
+  if(!freeSlots.empty())
+  {
+    index = freeSlots.back();
+    freeSlots.pop_back();
+  }
+  else
+  {
+    if(slots.size() > IndexMask)
+      throw std::runtime_error("EntityTable::insert - Out of slots");
+
+    // Generation starts at 1 so that no identifier is ever 0
+    index = static_cast<sf::Uint32>(slots.size());
+    Slot slot = { 0, 1 };
+    slots.push_back(slot);
+  }
+
+  Slot& slot = slots[index];
+  slot.position = static_cast<sf::Uint32>(values.size());
+
+  sf::Int32 identifier = static_cast<sf::Int32>((slot.generation << IndexBits) | index);
+  identifiers.push_back(identifier);
+  values.push_back(value);
+  return identifier;
+}
+
+template <typename T>
+bool EntityTable<T>::restore(sf::Int32 identifier, const T& value)
+{
+  sf::Uint32 index = static_cast<sf::Uint32>(identifier) & IndexMask;
+  sf::Uint32 generation = static_cast<sf::Uint32>(identifier) >> IndexBits;
+  if(identifier <= 0 || generation == 0 || generation > GenerationMask)
+    return false;
+
+  // Grow up to the slot, the ones in between are free
+  while(slots.size() <= index)
+  {
+    Slot slot = { 0, 1 };
+    freeSlots.push_back(static_cast<sf::Uint32>(slots.size()));
+    slots.push_back(slot);
+  }
+
+  auto freeSlot = std::find(freeSlots.begin(), freeSlots.end(), index);
+  if(freeSlot == freeSlots.end())
+    return false;
+  freeSlots.erase(freeSlot);
+
+  Slot& slot = slots[index];
+  slot.generation = generation;
+  slot.position = static_cast<sf::Uint32>(values.size());
+  identifiers.push_back(identifier);
+  values.push_back(value);
+  return true;
+}
+
+template <typename T>
+bool EntityTable<T>::erase(sf::Int32 identifier)
+{
+  Slot* slot = findSlot(identifier);
+  if(!slot)
+    return false;
+
+  eraseAt(slot->position);
+  return true;
+}
+
+template <typename T>
+void EntityTable<T>::eraseAt(std::size_t position)
+{
+  sf::Uint32 index = static_cast<sf::Uint32>(identifiers[position]) & IndexMask;
+
+  // Fill the hole with the last value
+  std::size_t last = values.size() - 1;
+  if(position != last)
+  {
+    values[position] = std::move(values[last]);
+    identifiers[position] = identifiers[last];
+    slots[static_cast<sf::Uint32>(identifiers[position]) & IndexMask].position =
+      static_cast<sf::Uint32>(position);
+  }
+  values.pop_back();
+  identifiers.pop_back();
+
+  // Stale identifiers of this slot stop resolving
+  Slot& slot = slots[index];
+  slot.generation = (slot.generation % GenerationMask) + 1;
+  freeSlots.push_back(index);
+}
+
+template <typename T>
+T* EntityTable<T>::find(sf::Int32 identifier)
+{
+  Slot* slot = findSlot(identifier);
+  return slot ? &values[slot->position] : nullptr;
+}
+
+template <typename T>
+const T* EntityTable<T>::find(sf::Int32 identifier) const
+{
+  const Slot* slot = findSlot(identifier);
+  return slot ? &values[slot->position] : nullptr;
+}
+
+template <typename T>
+std::size_t EntityTable<T>::size() const
+{
+  return values.size();
+}
+
+template <typename T>
+bool EntityTable<T>::empty() const
+{
+  return values.empty();
+}
+
+template <typename T>
+sf::Int32 EntityTable<T>::getIdentifier(std::size_t position) const
+{
+  return identifiers[position];
+}
+
+template <typename T>
+T& EntityTable<T>::getValue(std::size_t position)
+{
+  return values[position];
+}
+
+template <typename T>
+const T& EntityTable<T>::getValue(std::size_t position) const
+{
+  return values[position];
+}
+
+template <typename T>
+typename EntityTable<T>::Slot* EntityTable<T>::findSlot(sf::Int32 identifier)
+{
+  return const_cast<Slot*>(static_cast<const EntityTable*>(this)->findSlot(identifier));
+}
+
+template <typename T>
+const typename EntityTable<T>::Slot* EntityTable<T>::findSlot(sf::Int32 identifier) const
+{
+  if(identifier <= 0)
+    return nullptr;
+
+  sf::Uint32 index = static_cast<sf::Uint32>(identifier) & IndexMask;
+  sf::Uint32 generation = static_cast<sf::Uint32>(identifier) >> IndexBits;
+  if(index >= slots.size() || slots[index].generation != generation ||
+      slots[index].position >= identifiers.size() ||
+      identifiers[slots[index].position] != identifier)
+    return nullptr;
+
+  return &slots[index];
+}
+
+#endif
@@ -1,38 +1,188 @@
 #include "GameServer.hpp"
 #include "Aircraft.hpp"
 #include "Foreach.hpp"
+#include "LoopbackConnection.hpp"
 #include "MathUtils.hpp"
 #include "NetworkProtocol.hpp"
 #include "Pickup.hpp"
 
 #include <SFML/Network/Packet.hpp>
+#include <SFML/System/Lock.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+
+// For std::bind() placeholders _1, _2, ...
+using namespace std::placeholders;
+
+namespace
+{
+  // Per message type limits, on top of the overall per peer limit. Types
+  // not listed (Quit, PlayerRealtimeChange) are only bound by the latter,
+  // realtime changes are coalesced instead
+  struct MessageLimit
+  {
+    Client::PacketType type;
+    float rate;
+    float burst;
+  };
+
+  // How long the sessions of a resumed match stay reserved, and how long a
+  // new connection may take to say hello or present its token
+  const sf::Time ReservationTime = sf::seconds(5.f);
+  const sf::Time HandshakeWaitTime = sf::seconds(1.f);
+
+  // Load reports to the gateway, and how long to wait before trying to
+  // reach a gateway again
+  const sf::Time LoadReportInterval = sf::seconds(1.f);
+  const sf::Time GatewayRetryInterval = sf::seconds(5.f);
+  const sf::Time GatewayConnectTimeout = sf::seconds(1.f);
+
+  // Aircraft state updates: [Int32:id] [float:x] [float:y] each, after the
+  // type and count
+  const std::size_t StateHeaderSize = 2 * sizeof(sf::Int32);
+  const std::size_t StateEntrySize = sizeof(sf::Int32) + 2 * sizeof(float);
+
+  // Priority an aircraft gains per update; the peer's interest halves at
+  // StateDistanceScale pixels from its nearest aircraft, and maneuvering or
+  // firing aircraft count double
+  const float StateDistanceScale = 400.f;
+  const float ActiveAircraftWeight = 2.f;
+  const float IdleAircraftWeight = 1.f;
+
+  const MessageLimit MessageLimits[] =
+  {
+    { Client::PlayerEvent,        10.f, 10.f },
+    { Client::RequestCoopPartner, 0.2f, 1.f },
+    { Client::PositionUpdate,     40.f, 20.f },
+    { Client::GameEvent,          30.f, 30.f },
+    { Client::ClockSyncRequest,   10.f, 10.f },
+    { Client::Pong,               5.f,  5.f }
+  };
+
+  std::vector<TokenBucket> createTypeBuckets()
+  {
+    std::vector<TokenBucket> buckets(Client::PacketTypeCount);
+    for(std::size_t i=0; i<sizeof(MessageLimits) / sizeof(MessageLimits[0]); ++i)
+      buckets[MessageLimits[i].type] = TokenBucket(MessageLimits[i].rate, MessageLimits[i].burst);
+    return buckets;
+  }
+}
 
 GameServer::RemotePeer::RemotePeer() :
+  connection(),
+  joinStream(),
+  messageBucket(),
+  typeBuckets(),
+  stateScheduler(),
+  pendingRealtimeChanges(0),
+  sessionToken(0),
   ready(false),
   timedOut(false)
 {
-  socket.setBlocking(false);
 }
 
-GameServer::GameServer(sf::Vector2f battlefieldSize) :
+GameServer::Settings::Settings() :
+  battlefieldSize(1024.f, 768.f),
+  port(serverPort),
+  maxPlayers(10),
+  tickInterval(sf::seconds(1.f / 20.f)),
+  updateInterval(sf::seconds(1.f / 20.f)),
+  pingInterval(sf::seconds(1.f)),
+  idleTime(sf::milliseconds(100)),
+  clientTimeout(sf::seconds(3.f)),
+  statsDumpInterval(sf::Time::Zero),
+  joinBytesPerTick(4096),
+  stateBytesPerUpdate(1024),
+  peerMessageRate(200.f),
+  peerMessageBurst(100.f),
+  messageBudget(256),
+  spectatorPort(::spectatorPort),
+  maxSpectators(32),
+  captureFile(),
+  resumeFile(),
+  gatewayAddress(),
+  gatewayPort(::gatewayPort)
+{
+}
+
+GameServer::GameServer(const Settings& settings) :
     thread(&GameServer::executionThread, this),
     clock(),
+    timeOffset(sf::Time::Zero),
     listenerSocket(),
+    port(settings.port),
     listeningState(false),
-    clientTimeoutTime(sf::seconds(3.f)),
-    maxConnectedPlayers(10),
+    clientTimeoutTime(settings.clientTimeout),
+    maxConnectedPlayers(settings.maxPlayers),
     connectedPlayers(0),
     worldHeight(5000.f),
-    battleFieldRect(0.f, worldHeight - battlefieldSize.y, battlefieldSize.x, battlefieldSize.y),
-    battleFieldScrollSpeed(-50.f),
-    aircraftCount(0),
+    battleFieldRect(0.f, worldHeight - settings.battlefieldSize.y,
+        settings.battlefieldSize.x, settings.battlefieldSize.y),
     aircraftInfo(),
     peers(1),
-    aircraftIdentifierCounter(1),
     waitingThreadEnd(false),
+    idleTime(settings.idleTime),
+    pendingConnection(new TcpConnection()),
+    pendingLocalConnection(),
+    localConnectionMutex(),
     lastSpawnTime(sf::Time::Zero),
-    timeForNextSpawn(sf::seconds(5.f))
+    timeForNextSpawn(sf::seconds(5.f)),
+    tickInterval(settings.tickInterval),
+    updateInterval(settings.updateInterval),
+    lastUpdateTime(sf::Time::Zero),
+    pingInterval(settings.pingInterval),
+    lastPingTime(sf::Time::Zero),
+    joinBytesPerTick(settings.joinBytesPerTick),
+    stateBytesPerUpdate(settings.stateBytesPerUpdate),
+    peerMessageRate(settings.peerMessageRate),
+    peerMessageBurst(settings.peerMessageBurst),
+    messageBudget(settings.messageBudget),
+    statsMutex(),
+    peerStats(),
+    budgetFilledPasses(0),
+    statsDumpInterval(settings.statsDumpInterval),
+    lastStatsDumpTime(sf::Time::Zero),
+    recorder(),
+    dispatcher(),
+    spectatorHub(),
+    spectatorFrame(),
+    tokenGenerator(std::random_device()()),
+    reservedSessions(),
+    reservationDeadline(sf::Time::Zero),
+    handshakingConnections(),
+    migrationMutex(),
+    migrationRequested(false),
+    migrationFile(),
+    migrationPort(0),
+    migrated(false),
+    gatewayAddress(settings.gatewayAddress),
+    gatewayPort(settings.gatewayPort),
+    gatewaySocket(),
+    gatewayConnected(false),
+    gatewayConnectDeadline(sf::Time::Zero),
+    nextLoadReportTime(sf::Time::Zero)
 {
+  // Continue a match handed over by another server process
+  if(!settings.resumeFile.empty())
+    resume(settings.resumeFile);
+
+  // Optional capture of all traffic, one channel per peer
+  if(!settings.captureFile.empty())
+  {
+    recorder.reset(new PacketRecorder());
+    if(!recorder->open(settings.captureFile, PacketLog::ServerSide))
+      throw std::runtime_error("GameServer - Failed to open capture file " + settings.captureFile);
+  }
+
+  // Read-only spectators are served from their own thread
+  if(settings.maxSpectators > 0)
+    spectatorHub.reset(new SpectatorHub(settings.spectatorPort, settings.maxSpectators, clock, timeOffset));
+
+  registerHandlers();
+
   listenerSocket.setBlocking(false);
   peers[0].reset(new RemotePeer());
   thread.launch();
@@ -44,54 +194,72 @@ GameServer::~GameServer()
   thread.wait();
 }
 
+std::unique_ptr<Connection> GameServer::connectLocal()
+{
+  std::unique_ptr<Connection> clientEnd;
+  std::unique_ptr<Connection> serverEnd;
+  LoopbackConnection::createPair(clientEnd, serverEnd);
+
+  // Picked up by the server thread in handleIncomingConnections()
+  sf::Lock lock(localConnectionMutex);
+  pendingLocalConnection = std::move(serverEnd);
+  return clientEnd;
+}
+
 void GameServer::notifyPlayerRealtimeChange(sf::Int32 aircraftIdentifier, sf::Int32 action, bool actionEnabled)
 {
-  for(std::size_t i=0; i<connectedPlayers; ++i)
-  {
-    if(peers[i]->ready)
-    {
-      sf::Packet packet;
-      packet << static_cast<sf::Int32>(Server::PlayerRealtimeChange);
-      packet << aircraftIdentifier;
-      packet << action;
-      packet << actionEnabled;
+  sf::Packet packet;
+  packet << static_cast<sf::Int32>(Server::PlayerRealtimeChange);
+  packet << aircraftIdentifier;
+  packet << action;
+  packet << actionEnabled;
 
-      peers[i]->socket.send(packet);
-    }
-  }
+  sendToAll(packet);
 }
 
 void GameServer::notifyPlayerEvent(sf::Int32 aircraftIdentifier, sf::Int32 action)
 {
-  for(std::size_t i=0; i<connectedPlayers; ++i)
-  {
-    if(peers[i]->ready)
-    {
-      sf::Packet packet;
-      packet << static_cast<sf::Int32>(Server::PlayerEvent);
-      packet << aircraftIdentifier;
-      packet << action;
+  sf::Packet packet;
+  packet << static_cast<sf::Int32>(Server::PlayerEvent);
+  packet << aircraftIdentifier;
+  packet << action;
 
-      peers[i]->socket.send(packet);
-    }
-  }
+  sendToAll(packet);
 }
 
 void GameServer::notifyPlayerSpawn(sf::Int32 aircraftIdentifier)
 {
-  for(std::size_t i=0; i<connectedPlayers; ++i)
-  {
-    if(peers[i]->ready)
-    {
-      sf::Packet packet;
-      packet << static_cast<sf::Int32>(Server::PlayerConnect);
-      packet << aircraftIdentifier;
-      packet << aircraftInfo[aircraftIdentifier].position.x;
-      packet << aircraftInfo[aircraftIdentifier].position.y;
+  sf::Packet packet;
+  packet << static_cast<sf::Int32>(Server::PlayerConnect);
+  packet << aircraftIdentifier;
+  packet << aircraftInfo.find(aircraftIdentifier)->position.x;
+  packet << aircraftInfo.find(aircraftIdentifier)->position.y;
 
-      peers[i]->socket.send(packet);
-    }
-  }
+  sendToAll(packet);
+}
+
+std::vector<GameServer::PeerStats> GameServer::getPeerStats() const
+{
+  sf::Lock lock(statsMutex);
+  return peerStats;
+}
+
+sf::Uint64 GameServer::getBudgetFilledPasses() const
+{
+  return budgetFilledPasses;
+}
+
+void GameServer::requestMigration(const std::string& checkpointFile, unsigned short port)
+{
+  sf::Lock lock(migrationMutex);
+  migrationRequested = true;
+  migrationFile = checkpointFile;
+  migrationPort = port;
+}
+
+bool GameServer::isMigrated() const
+{
+  return migrated;
 }
 
 void GameServer::setListening(bool enable)
@@ -100,7 +268,7 @@ void GameServer::setListening(bool enable)
   if(enable)
   {
     if(!listeningState)
-      listeningState = (listenerSocket.listen(serverPort) == sf::TcpListener::Done);
+      listeningState = (listenerSocket.listen(port) == sf::TcpListener::Done);
   }
   else
   {
@@ -113,29 +281,21 @@ void GameServer::executionThread()
 {
   setListening(true);
 
-  sf::Time stepInterval = sf::seconds(1.f / 60.f);
-  sf::Time stepTime = sf::Time::Zero;
-  sf::Time tickInterval = sf::seconds(1.f / 20.f);
   sf::Time tickTime = sf::Time::Zero;
-  sf::Clock stepClock, tickClock;
+  sf::Clock tickClock;
 
   while(!waitingThreadEnd)
   {
     handleIncomingPackets();
     handleIncomingConnections();
 
-    stepTime += stepClock.getElapsedTime();
-    stepClock.restart();
-
     tickTime += tickClock.getElapsedTime();
     tickClock.restart();
 
-    // Fixed update step
-    while(stepTime >= stepInterval)
-    {
-      battleFieldRect.top += battleFieldScrollSpeed * stepInterval.asSeconds();
-      stepTime -= stepInterval;
-    }
+    // The battlefield position is a pure function of the server time, so
+    // clients with a synchronized clock compute exactly the same position
+    battleFieldRect.top = worldHeight - battleFieldRect.height +
+      battleFieldScrollSpeed * now().asSeconds();
 
     // Fixed tick step
     while(tickTime >= tickInterval)
@@ -144,25 +304,40 @@ void GameServer::executionThread()
       tickTime -= tickInterval;
     }
 
+    // Handed over to another process, the clients reconnect there
+    if(migrate())
+      break;
+
     // Sleep to prevent server from consuming 100% CPU
-    sf::sleep(sf::milliseconds(100));
+    sf::sleep(idleTime);
   }
 }
 
 void GameServer::tick()
 {
-  updateClientState();
+  expireReservedSessions();
+
+  if(now() >= lastUpdateTime + updateInterval)
+  {
+    updateClientState();
+    lastUpdateTime = now();
+  }
+  sendJoinStreams();
+  sendPings();
+  publishStats();
+  dumpStats();
+  reportLoad();
 
   // Check for mission success = all planes with position.y < offset
   bool allAircraftsDone = true;
-  FOREACH(auto pair, aircraftInfo)
+  for(std::size_t i=0; i<aircraftInfo.size(); ++i)
   {
     // As long as one player has not crossed the finish line yet, set variable
     // to false
-    if(pair.second.position.y > 0.f)
+    if(aircraftInfo.getValue(i).position.y > 0.f)
       allAircraftsDone = false;
   }
-  if(allAircraftsDone && aircraftInfo.size() > 0)
+  if(allAircraftsDone && !aircraftInfo.empty())
   {
     sf::Packet missionSuccessPacket;
     missionSuccessPacket << static_cast<sf::Int32>(Server::MissionSuccess);
@@ -170,13 +345,11 @@ void GameServer::tick()
   }
 
   // Remove ID's of aircraft that have been destroyed (relevant if a client
-  // has two, and loses one)
-  for(auto itr = aircraftInfo.begin(); itr != aircraftInfo.end();)
+  // has two, and loses one); backwards, erasing moves the last one in place
+  for(std::size_t i=aircraftInfo.size(); i-- > 0;)
   {
-    if(itr->second.hitpoints <= 0)
-      aircraftInfo.erase(itr++);
-    else
-      ++itr;
+    if(aircraftInfo.getValue(i).hitpoints <= 0)
+      aircraftInfo.eraseAt(i);
   }
 
   // Check if its time to attempt to spawn enemies
@@ -219,33 +392,51 @@ void GameServer::tick()
       timeForNextSpawn = sf::milliseconds(2000 + randomInt(6000));
     }
   }
+
+  // Everything this tick sent to all peers, for the spectators
+  publishSpectatorFrame();
 }
 
 sf::Time GameServer::now() const
 {
-  return clock.getElapsedTime();
+  return clock.getElapsedTime() + timeOffset;
 }
 
 void GameServer::handleIncomingPackets()
 {
   bool detectedTimeout = false;
 
+  // Every peer gets an equal share of the budget per pass; what is left
+  // stays in the socket for the next one, so a flooding client only delays
+  // itself
+  std::size_t peerBudget = std::max<std::size_t>(1, messageBudget / std::max<std::size_t>(1, connectedPlayers));
+
   FOREACH(PeerPtr& peer, peers)
   {
     if(peer->ready)
     {
       sf::Packet packet;
-      while(peer->socket.receive(packet) == sf::Socket::Done)
+      std::size_t processed = 0;
+      while(processed < peerBudget && peer->connection->receive(packet) == sf::Socket::Done)
       {
+        peer->connection->getStats().recordSilence(now() - peer->lastPacketTime, clientTimeoutTime);
+
         // Interpret packet and react to it
-        handleIncomingPacket(packet, *peer, detectedTimeout);
+        if(admitPacket(*peer, packet))
+          dispatcher.dispatch(packet, *peer);
 
         // Packet was indeed received, update the ping timer
         peer->lastPacketTime = now();
         packet.clear();
+        processed++;
       }
 
-      if(now() >= peer->lastPacketTime + clientTimeoutTime)
+      // Whether more was waiting is not known without receiving it
+      if(processed == peerBudget)
+        budgetFilledPasses++;
+
+      // Quit marks the peer as timed out as well
+      if(peer->timedOut || now() >= peer->lastPacketTime + clientTimeoutTime)
       {
         peer->timedOut = true;
         detectedTimeout = true;
@@ -253,185 +444,653 @@ void GameServer::handleIncomingPackets()
     }
   }
 
+  // One broadcast per changed action, however often it was toggled
+  flushRealtimeChanges();
+
   if(detectedTimeout)
     handleDisconnections();
 }
 
-void GameServer::handleIncomingPacket(sf::Packet& packet, RemotePeer& receivingPeer, bool& detectedTimeout)
+bool GameServer::admitPacket(RemotePeer& peer, const sf::Packet& packet)
 {
-  sf::Int32 packetType;
-  packet >> packetType;
+  sf::Int32 packetType = NetworkStats::getPacketType(packet);
+
+  // Leaving is always allowed
+  if(packetType == Client::Quit)
+    return true;
 
-  switch (packetType)
+  if(!peer.messageBucket.consume(now()) ||
+      (packetType >= 0 && packetType < Client::PacketTypeCount &&
+       !peer.typeBuckets[packetType].consume(now())))
   {
-    case Client::Quit:
-      {
-        receivingPeer.timedOut = true;
-        detectedTimeout = true;
-      }
-      break;
+    peer.connection->getStats().recordDrop(packet);
+    return false;
+  }
 
-    case Client::PlayerEvent:
-      {
-        sf::Int32 aircraftIdentifier;
-        sf::Int32 action;
-        packet >> aircraftIdentifier >> action;
+  return true;
+}
 
-        notifyPlayerEvent(aircraftIdentifier, action);
-      }
-      break;
+bool GameServer::ownsAircraft(const RemotePeer& peer, sf::Int32 aircraftIdentifier) const
+{
+  return std::find(peer.aircraftIdentifiers.begin(), peer.aircraftIdentifiers.end(),
+      aircraftIdentifier) != peer.aircraftIdentifiers.end();
+}
 
-    case Client::PlayerRealtimeChange:
-      {
-        sf::Int32 aircraftIdentifier;
-        sf::Int32 action;
-        bool actionEnabled;
-        packet >> aircraftIdentifier >> action >> actionEnabled;
-        aircraftInfo[aircraftIdentifier].realtimeActions[action] = actionEnabled;
-        notifyPlayerRealtimeChange(aircraftIdentifier, action, actionEnabled);
-      }
-      break;
+void GameServer::flushRealtimeChanges()
+{
+  FOREACH(PeerPtr& peer, peers)
+  {
+    if(!peer->ready || peer->pendingRealtimeChanges == 0)
+      continue;
 
-    case Client::RequestCoopPartner:
+    sf::Uint32 sent = 0;
+    FOREACH(sf::Int32 identifier, peer->aircraftIdentifiers)
+    {
+      AircraftInfo* aircraft = aircraftInfo.find(identifier);
+      if(!aircraft)
+        continue;
+
+      sf::Uint32 changed = aircraft->realtimeActions ^ aircraft->broadcastActions;
+      for(sf::Int32 action=0; changed != 0; ++action, changed >>= 1)
       {
-        receivingPeer.aircraftIdentifiers.push_back(aircraftIdentifierCounter);
-        aircraftInfo[aircraftIdentifierCounter].position = sf::Vector2f(
-            battleFieldRect.width / 2,
-            battleFieldRect.top + battleFieldRect.height / 2);
-        aircraftInfo[aircraftIdentifierCounter].hitpoints = 100;
-        aircraftInfo[aircraftIdentifierCounter].missileAmmo = 2;
-
-        sf::Packet requestPacket;
-        requestPacket << static_cast<sf::Int32>(Server::AcceptCoopPartner);
-        requestPacket << aircraftIdentifierCounter;
-        requestPacket << aircraftInfo[aircraftIdentifierCounter].position.x;
-        requestPacket << aircraftInfo[aircraftIdentifierCounter].position.y;
-
-        receivingPeer.socket.send(requestPacket);
-        aircraftCount++;
-
-        // Inform every other peer about this new plane
-        FOREACH(PeerPtr& peer, peers)
+        if(changed & 1u)
         {
-          if (peer.get() != &receivingPeer && peer->ready)
-          {
-            sf::Packet notifyPacket;
-            notifyPacket << static_cast<sf::Int32>(Server::PlayerConnect);
-            notifyPacket << aircraftIdentifierCounter;
-            notifyPacket << aircraftInfo[aircraftIdentifierCounter].position.x;
-            notifyPacket << aircraftInfo[aircraftIdentifierCounter].position.y;
-            peer->socket.send(notifyPacket);
-          }
+          notifyPlayerRealtimeChange(identifier, action, (aircraft->realtimeActions & (1u << action)) != 0);
+          sent++;
         }
-        aircraftIdentifierCounter++;
       }
-      break;
+      aircraft->broadcastActions = aircraft->realtimeActions;
+    }
 
-    case Client::PositionUpdate:
-      {
-        sf::Int32 numAircrafts;
-        packet >> numAircrafts;
+    // Toggles that cancelled out or repeated the current state
+    if(peer->pendingRealtimeChanges > sent)
+      peer->connection->getStats().recordCoalesced(peer->pendingRealtimeChanges - sent);
+    peer->pendingRealtimeChanges = 0;
+  }
+}
 
-        for (sf::Int32 i = 0; i < numAircrafts; ++i)
-        {
-          sf::Int32 aircraftIdentifier;
-          sf::Int32 aircraftHitpoints;
-          sf::Int32 missileAmmo;
-          sf::Vector2f aircraftPosition;
-          packet >> aircraftIdentifier;
-          packet >> aircraftPosition.x;
-          packet >> aircraftPosition.y;
-          packet >> aircraftHitpoints;
-          packet >> missileAmmo;
-          aircraftInfo[aircraftIdentifier].position = aircraftPosition;
-          aircraftInfo[aircraftIdentifier].hitpoints = aircraftHitpoints;
-          aircraftInfo[aircraftIdentifier].missileAmmo = missileAmmo;
-        }
-      }
-      break;
+// Payload sizes are what each handler reads at least
+void GameServer::registerHandlers()
+{
+  dispatcher.registerHandler(Client::Quit, 0, std::bind(&GameServer::handleQuit, this, _1, _2));
+  dispatcher.registerHandler(Client::ClockSyncRequest, 4, std::bind(&GameServer::handleClockSyncRequest, this, _1, _2));
+  dispatcher.registerHandler(Client::Pong, 4, std::bind(&GameServer::handlePong, this, _1, _2));
+  dispatcher.registerHandler(Client::PlayerEvent, 8, std::bind(&GameServer::handlePlayerEvent, this, _1, _2));
+  dispatcher.registerHandler(Client::PlayerRealtimeChange, 9, std::bind(&GameServer::handlePlayerRealtimeChange, this, _1, _2));
+  dispatcher.registerHandler(Client::RequestCoopPartner, 0, std::bind(&GameServer::handleRequestCoopPartner, this, _1, _2));
+  dispatcher.registerHandler(Client::PositionUpdate, 4, std::bind(&GameServer::handlePositionUpdate, this, _1, _2));
+  dispatcher.registerHandler(Client::GameEvent, 12, std::bind(&GameServer::handleGameEvent, this, _1, _2));
+}
 
-    case Client::GameEvent:
-      {
-        sf::Int32 action;
-        float x;
-        float y;
-
-        packet >> action;
-        packet >> x;
-        packet >> y;
-
-        // Enemy explodes: With certain probability, drop pickup
-        // To avoid multiple messages spawning multiple pickups, only listen to
-        // first peer (host)
-        if (action == GameActions::EnemyExplode &&
-            randomInt(3) == 0 &&
-            &receivingPeer == peers[0].get())
-        {
-          sf::Packet packet;
-          packet << static_cast<sf::Int32>(Server::SpawnPickup);
-          packet << static_cast<sf::Int32>(randomInt(Pickup::TypeCount));
-          packet << x;
-          packet << y;
+void GameServer::handleQuit(sf::Packet&, RemotePeer& receivingPeer)
+{
+  receivingPeer.timedOut = true;
+}
 
-          sendToAll(packet);
-        }
-      }
+void GameServer::handleClockSyncRequest(sf::Packet& packet, RemotePeer& receivingPeer)
+{
+  sf::Int32 clientTime;
+  packet >> clientTime;
+
+  // Answer right away, the client measures the round trip itself
+  sf::Packet responsePacket;
+  responsePacket << static_cast<sf::Int32>(Server::ClockSyncResponse);
+  responsePacket << clientTime;
+  responsePacket << now().asMilliseconds();
+
+  receivingPeer.connection->send(responsePacket);
+}
+
+void GameServer::handlePong(sf::Packet& packet, RemotePeer& receivingPeer)
+{
+  sf::Int32 serverTime;
+  packet >> serverTime;
+
+  receivingPeer.connection->getStats().recordRoundTripTime(now() - sf::milliseconds(serverTime));
+}
+
+void GameServer::handlePlayerEvent(sf::Packet& packet, RemotePeer& receivingPeer)
+{
+  sf::Int32 aircraftIdentifier;
+  sf::Int32 action;
+  packet >> aircraftIdentifier >> action;
+
+  // Clients only act for their own aircraft
+  if(ownsAircraft(receivingPeer, aircraftIdentifier))
+    notifyPlayerEvent(aircraftIdentifier, action);
+}
+
+void GameServer::handlePlayerRealtimeChange(sf::Packet& packet, RemotePeer& receivingPeer)
+{
+  sf::Int32 aircraftIdentifier;
+  sf::Int32 action;
+  bool actionEnabled;
+  packet >> aircraftIdentifier >> action >> actionEnabled;
+
+  // Ignore stale, unknown or foreign aircraft and actions outside the
+  // mask; peers are told in flushRealtimeChanges()
+  AircraftInfo* aircraft = aircraftInfo.find(aircraftIdentifier);
+  if(aircraft && ownsAircraft(receivingPeer, aircraftIdentifier) &&
+      action >= 0 && action < 32)
+  {
+    sf::Uint32 bit = 1u << action;
+    aircraft->realtimeActions = actionEnabled ?
+      (aircraft->realtimeActions | bit) : (aircraft->realtimeActions & ~bit);
+    receivingPeer.pendingRealtimeChanges++;
+  }
+}
+
+void GameServer::handleRequestCoopPartner(sf::Packet&, RemotePeer& receivingPeer)
+{
+  sf::Int32 aircraftIdentifier = addAircraft();
+  const AircraftInfo& aircraft = *aircraftInfo.find(aircraftIdentifier);
+  receivingPeer.aircraftIdentifiers.push_back(aircraftIdentifier);
+
+  sf::Packet requestPacket;
+  requestPacket << static_cast<sf::Int32>(Server::AcceptCoopPartner);
+  requestPacket << aircraftIdentifier;
+  requestPacket << aircraft.position.x;
+  requestPacket << aircraft.position.y;
+
+  sendToPeer(receivingPeer, requestPacket);
+
+  // Inform every other peer (and the spectators) about this new plane
+  sf::Packet notifyPacket;
+  notifyPacket << static_cast<sf::Int32>(Server::PlayerConnect);
+  notifyPacket << aircraftIdentifier;
+  notifyPacket << aircraft.position.x;
+  notifyPacket << aircraft.position.y;
+  recordForSpectators(notifyPacket);
+
+  FOREACH(PeerPtr& peer, peers)
+  {
+    if (peer.get() != &receivingPeer && peer->ready)
+      sendToPeer(*peer, notifyPacket);
+  }
+}
+
+void GameServer::handlePositionUpdate(sf::Packet& packet, RemotePeer& receivingPeer)
+{
+  sf::Int32 numAircrafts;
+  packet >> numAircrafts;
+
+  for (sf::Int32 i = 0; i < numAircrafts; ++i)
+  {
+    sf::Int32 aircraftIdentifier;
+    sf::Int32 aircraftHitpoints;
+    sf::Int32 missileAmmo;
+    sf::Vector2f aircraftPosition;
+    packet >> aircraftIdentifier;
+    packet >> aircraftPosition.x;
+    packet >> aircraftPosition.y;
+    packet >> aircraftHitpoints;
+    packet >> missileAmmo;
+    if(!packet)
       break;
+
+    // Updates for aircraft of other peers, or destroyed in the meantime,
+    // are dropped
+    AircraftInfo* aircraft = aircraftInfo.find(aircraftIdentifier);
+    if(aircraft && ownsAircraft(receivingPeer, aircraftIdentifier))
+    {
+      aircraft->position = aircraftPosition;
+      aircraft->hitpoints = aircraftHitpoints;
+      aircraft->missileAmmo = missileAmmo;
+    }
+  }
+}
+
+void GameServer::handleGameEvent(sf::Packet& packet, RemotePeer& receivingPeer)
+{
+  sf::Int32 action;
+  float x;
+  float y;
+
+  packet >> action;
+  packet >> x;
+  packet >> y;
+
+  // Enemy explodes: With certain probability, drop pickup
+  // To avoid multiple messages spawning multiple pickups, only listen to
+  // first peer (host)
+  if (action == GameActions::EnemyExplode &&
+      randomInt(3) == 0 &&
+      &receivingPeer == peers[0].get())
+  {
+    sf::Packet packet;
+    packet << static_cast<sf::Int32>(Server::SpawnPickup);
+    packet << static_cast<sf::Int32>(randomInt(Pickup::TypeCount));
+    packet << x;
+    packet << y;
+
+    sendToAll(packet);
   }
 }
 
 void GameServer::updateClientState()
 {
+  // Spectators see everything, each peer gets what fits in its budget
+  if(spectatorHub && spectatorHub->getSpectatorCount() > 0)
+  {
+    sf::Packet updateClientStatePacket;
+    updateClientStatePacket << static_cast<sf::Int32>(Server::UpdateClientState);
+    updateClientStatePacket << static_cast<sf::Int32>(aircraftInfo.size());
+
+    for(std::size_t i=0; i<aircraftInfo.size(); ++i)
+    {
+      updateClientStatePacket << aircraftInfo.getIdentifier(i);
+      updateClientStatePacket << aircraftInfo.getValue(i).position.x;
+      updateClientStatePacket << aircraftInfo.getValue(i).position.y;
+    }
+
+    recordForSpectators(updateClientStatePacket);
+  }
+
+  FOREACH(PeerPtr& peer, peers)
+  {
+    if(peer->ready)
+      updatePeerState(*peer);
+  }
+}
+
+void GameServer::updatePeerState(RemotePeer& peer)
+{
+  // A peer is authoritative for its own aircraft, it only needs the others
+  for(std::size_t i=0; i<aircraftInfo.size(); ++i)
+  {
+    sf::Int32 identifier = aircraftInfo.getIdentifier(i);
+    if(ownsAircraft(peer, identifier))
+      continue;
+
+    const AircraftInfo& aircraft = aircraftInfo.getValue(i);
+    float distance = -1.f;
+    FOREACH(sf::Int32 ownIdentifier, peer.aircraftIdentifiers)
+    {
+      if(const AircraftInfo* own = aircraftInfo.find(ownIdentifier))
+      {
+        float ownDistance = length(aircraft.position - own->position);
+        if(distance < 0.f || ownDistance < distance)
+          distance = ownDistance;
+      }
+    }
+
+    float weight = (aircraft.realtimeActions != 0) ? ActiveAircraftWeight : IdleAircraftWeight;
+    if(distance >= 0.f)
+      weight *= StateDistanceScale / (StateDistanceScale + distance);
+    peer.stateScheduler.accumulate(identifier, weight);
+  }
+
+  // At least one aircraft per update, however small the budget
+  std::size_t budget = 0;
+  if(stateBytesPerUpdate > 0)
+    budget = std::max(StateEntrySize, stateBytesPerUpdate - std::min(stateBytesPerUpdate, StateHeaderSize));
+  std::vector<sf::Int32> selected;
+  peer.stateScheduler.select(budget, StateEntrySize, selected);
+  if(selected.empty())
+    return;
+
   sf::Packet updateClientStatePacket;
   updateClientStatePacket << static_cast<sf::Int32>(Server::UpdateClientState);
-  updateClientStatePacket << static_cast<float>(battleFieldRect.top + battleFieldRect.height);
-  updateClientStatePacket << static_cast<sf::Int32>(aircraftInfo.size());
+  updateClientStatePacket << static_cast<sf::Int32>(selected.size());
+
+  FOREACH(sf::Int32 identifier, selected)
+  {
+    const AircraftInfo& aircraft = *aircraftInfo.find(identifier);
+    updateClientStatePacket << identifier;
+    updateClientStatePacket << aircraft.position.x;
+    updateClientStatePacket << aircraft.position.y;
+  }
+
+  sendToPeer(peer, updateClientStatePacket);
+}
+
+void GameServer::sendPings()
+{
+  if(now() < lastPingTime + pingInterval)
+    return;
+
+  sf::Packet pingPacket;
+  pingPacket << static_cast<sf::Int32>(Server::Ping);
+  pingPacket << now().asMilliseconds();
+
+  // Not held back by join streams, a late ping would spoil the round trip
+  FOREACH(PeerPtr& peer, peers)
+  {
+    if(peer->ready)
+      peer->connection->send(pingPacket);
+  }
+  lastPingTime = now();
+}
+
+void GameServer::publishStats()
+{
+  std::vector<PeerStats> snapshots;
+  FOREACH(PeerPtr& peer, peers)
+  {
+    if(!peer->ready)
+      continue;
+
+    PeerStats snapshot;
+    snapshot.aircraftIdentifiers = peer->aircraftIdentifiers;
+    snapshot.stats = peer->connection->getStats();
+    snapshot.deferredUpdates = peer->stateScheduler.getDeferred();
+    snapshot.droppedMessages = snapshot.stats.getTotalDropped();
+    snapshot.coalescedChanges = snapshot.stats.getCoalesced();
+    snapshots.push_back(snapshot);
+  }
+
+  // Copied outside the lock, readers only wait for the swap
+  sf::Lock lock(statsMutex);
+  peerStats.swap(snapshots);
+}
+
+// Periodic dump, if enabled
+void GameServer::dumpStats()
+{
+  if(statsDumpInterval == sf::Time::Zero ||
+      now() < lastStatsDumpTime + statsDumpInterval)
+    return;
+
+  std::size_t spectatorCount = spectatorHub ? spectatorHub->getSpectatorCount() : 0;
+  std::cout << "Server stats at " << now().asSeconds() << "s, "
+    << connectedPlayers << " peer(s), " << spectatorCount << " spectator(s), "
+    << "a peer used its whole message budget " << budgetFilledPasses << " time(s)\n";
+
+  std::size_t index = 0;
+  FOREACH(PeerPtr& peer, peers)
+  {
+    if(!peer->ready)
+      continue;
+
+    std::cout << " peer " << index++ << " aircraft:";
+    FOREACH(sf::Int32 identifier, peer->aircraftIdentifiers)
+      std::cout << " " << identifier;
+    std::cout << " deferredUpdates=" << peer->stateScheduler.getDeferred() << "\n";
+    peer->connection->getStats().print(std::cout);
+  }
+  dispatcher.print(std::cout);
+  std::cout << std::flush;
+
+  lastStatsDumpTime = now();
+}
+
+void GameServer::reportLoad()
+{
+  if(gatewayAddress.empty())
+    return;
+
+  // Non-blocking connect, polled every tick: it is done once the socket
+  // has a peer
+  if(gatewaySocket && !gatewayConnected)
+  {
+    if(gatewaySocket->getRemotePort() != 0)
+    {
+      gatewayConnected = true;
+    }
+    else if(now() >= gatewayConnectDeadline)
+    {
+      gatewaySocket.reset();
+      nextLoadReportTime = now() + GatewayRetryInterval;
+    }
+  }
+
+  if(now() < nextLoadReportTime)
+    return;
 
-  FOREACH(auto aircraft, aircraftInfo)
+  if(!gatewaySocket)
   {
-    updateClientStatePacket << aircraft.first;
-    updateClientStatePacket << aircraft.second.position.x;
-    updateClientStatePacket << aircraft.second.position.y;
+    gatewaySocket.reset(new sf::TcpSocket());
+    gatewaySocket->setBlocking(false);
+    gatewaySocket->connect(gatewayAddress, gatewayPort);
+    gatewayConnected = false;
+    gatewayConnectDeadline = now() + GatewayConnectTimeout;
   }
 
-  sendToAll(updateClientStatePacket);
+  if(!gatewayConnected)
+    return;
+
+  sf::Packet packet;
+  packet << static_cast<sf::Int32>(Backend::LoadReport);
+  packet << static_cast<sf::Uint16>(port);
+  packet << static_cast<sf::Uint32>(connectedPlayers);
+  packet << static_cast<sf::Uint32>(maxConnectedPlayers);
+
+  // Tiny and infrequent, a report that does not fit is skipped; one sent in
+  // part would break the framing, so start over with a new connection
+  sf::Socket::Status status = gatewaySocket->send(packet);
+  if(status != sf::Socket::Done && status != sf::Socket::NotReady)
+    gatewaySocket.reset();
+
+  nextLoadReportTime = now() + LoadReportInterval;
 }
 
 void GameServer::handleIncomingConnections()
 {
+  // The hosting client, handed over by connectLocal()
+  std::unique_ptr<Connection> localConnection;
+  {
+    sf::Lock lock(localConnectionMutex);
+    localConnection = std::move(pendingLocalConnection);
+  }
+
+  if(localConnection)
+  {
+    // Nothing to wait for on a loopback, poll often so the host sees no
+    // added latency from this loop
+    idleTime = sf::milliseconds(1);
+    startHandshake(std::move(localConnection));
+  }
+
+  handleHandshakes();
+
   if(!listeningState)
     return;
 
-  if(listenerSocket.accept(peers[connectedPlayers]->socket) == sf::TcpListener::Done)
+  if(listenerSocket.accept(pendingConnection->getSocket()) == sf::TcpListener::Done)
   {
-    // order the new client to spawn its own plane ( player 1 )
-    aircraftInfo[aircraftIdentifierCounter].position = sf::Vector2f(battleFieldRect.width / 2, battleFieldRect.top + battleFieldRect.height / 2);
-    aircraftInfo[aircraftIdentifierCounter].hitpoints = 100;
-    aircraftInfo[aircraftIdentifierCounter].missileAmmo = 2;
+    pendingConnection->getSocket().setBlocking(false);
+    startHandshake(std::move(pendingConnection));
+    pendingConnection.reset(new TcpConnection());
+  }
+}
 
+void GameServer::startHandshake(std::unique_ptr<Connection> connection)
+{
+  HandshakingConnection handshaking;
+  handshaking.connection = std::move(connection);
+  handshaking.acceptTime = now();
+  handshakingConnections.push_back(std::move(handshaking));
+}
+
+// The first message decides: a hello negotiates the protocol version, a
+// resume reclaims a session of a migrated match. Clients saying neither
+// within HandshakeWaitTime predate the handshake and are turned away
+void GameServer::handleHandshakes()
+{
+  for(auto itr = handshakingConnections.begin(); itr != handshakingConnections.end();)
+  {
     sf::Packet packet;
-    packet << static_cast<sf::Int32>(Server::SpawnSelf);
-    packet << aircraftIdentifierCounter;
-    packet << aircraftInfo[aircraftIdentifierCounter].position.x;
-    packet << aircraftInfo[aircraftIdentifierCounter].position.y;
+    sf::Socket::Status status = itr->connection->receive(packet);
 
-    peers[connectedPlayers]->aircraftIdentifiers.push_back(aircraftIdentifierCounter);
+    if(status == sf::Socket::NotReady && now() < itr->acceptTime + HandshakeWaitTime)
+    {
+      ++itr;
+      continue;
+    }
 
-    broadcastMessage("New player!");
-    informWorldState(peers[connectedPlayers]->socket);
-    notifyPlayerSpawn(aircraftIdentifierCounter++);
+    std::unique_ptr<Connection> connection = std::move(itr->connection);
+    itr = handshakingConnections.erase(itr);
+    if(status == sf::Socket::Disconnected || status == sf::Socket::Error)
+      continue;
 
-    peers[connectedPlayers]->socket.send(packet);
-    peers[connectedPlayers]->ready = true;
-    peers[connectedPlayers]->lastPacketTime = now(); // prevent initial timeouts
-    aircraftCount++;
-    connectedPlayers++;
+    sf::Int32 packetType = -1;
+    if(status == sf::Socket::Done)
+      packet >> packetType;
 
     if(connectedPlayers >= maxConnectedPlayers)
-      setListening(false);
+    {
+      rejectConnection(*connection, "The server is full");
+      continue;
+    }
+
+    if(packetType == Client::Hello)
+    {
+      sf::Uint32 minimumVersion = 0;
+      sf::Uint32 maximumVersion = 0;
+      packet >> minimumVersion >> maximumVersion;
+
+      sf::Uint32 version = negotiateProtocolVersion(minimumVersion, maximumVersion);
+      if(!packet || version == 0)
+        rejectConnection(*connection, "Incompatible game version");
+      else
+        addPeer(std::move(connection), version);
+    }
+    else if(packetType == Client::Resume)
+    {
+      sf::Uint32 tokenHigh = 0;
+      sf::Uint32 tokenLow = 0;
+      packet >> tokenHigh >> tokenLow;
+
+      sf::Uint64 token = (static_cast<sf::Uint64>(tokenHigh) << 32) | tokenLow;
+      auto session = std::find_if(reservedSessions.begin(), reservedSessions.end(),
+          [token] (const MatchCheckpoint::Session& s) { return s.token == token; });
+
+      // Too late or unknown, the client starts over with a hello
+      if(packet && session != reservedSessions.end())
+      {
+        resumePeer(std::move(connection), *session);
+        reservedSessions.erase(session);
+      }
+      else
+      {
+        rejectConnection(*connection, "Unknown session");
+      }
+    }
     else
-      peers.push_back(PeerPtr(new RemotePeer()));
+    {
+      rejectConnection(*connection, "Incompatible game version");
+    }
+  }
+}
+
+void GameServer::rejectConnection(Connection& connection, const std::string& reason)
+{
+  sf::Packet packet;
+  packet << static_cast<sf::Int32>(Server::Reject);
+  packet << reason;
+  connection.send(packet);
+}
+
+void GameServer::resumePeer(std::unique_ptr<Connection> connection, const MatchCheckpoint::Session& session)
+{
+  RemotePeer& peer = *peers[connectedPlayers];
+  peer.connection = std::move(connection);
+  peer.messageBucket = TokenBucket(peerMessageRate, peerMessageBurst);
+  peer.typeBuckets = createTypeBuckets();
+  peer.sessionToken = session.token;
+
+  // Ahead of anything else, the client waits for it
+  sf::Packet acceptedPacket;
+  acceptedPacket << static_cast<sf::Int32>(Server::ResumeAccepted);
+  peer.connection->send(acceptedPacket);
+
+  // The client still has its world, it only needs to know its aircraft are
+  // its own again; the ones destroyed meanwhile are gone
+  FOREACH(sf::Int32 identifier, session.aircraftIdentifiers)
+  {
+    if(aircraftInfo.find(identifier))
+      peer.aircraftIdentifiers.push_back(identifier);
   }
+
+  if(recorder && !session.aircraftIdentifiers.empty())
+    peer.connection->setRecorder(recorder.get(), static_cast<sf::Uint32>(session.aircraftIdentifiers.front()));
+
+  activatePeer(peer);
+}
+
+void GameServer::activatePeer(RemotePeer& peer)
+{
+  peer.ready = true;
+  peer.lastPacketTime = now(); // prevent initial timeouts
+  connectedPlayers++;
+
+  if(connectedPlayers >= maxConnectedPlayers)
+    setListening(false);
+  else
+    peers.push_back(PeerPtr(new RemotePeer()));
+}
+
+void GameServer::expireReservedSessions()
+{
+  if(reservedSessions.empty() || now() < reservationDeadline)
+    return;
+
+  // Clients that did not follow the migration in time are gone
+  FOREACH(const MatchCheckpoint::Session& session, reservedSessions)
+  {
+    FOREACH(sf::Int32 identifier, session.aircraftIdentifiers)
+    {
+      if(!aircraftInfo.erase(identifier))
+        continue;
+
+      sf::Packet packet;
+      packet << static_cast<sf::Int32>(Server::PlayerDisconnect);
+      packet << identifier;
+      sendToAll(packet);
+    }
+  }
+
+  reservedSessions.clear();
+}
+
+void GameServer::addPeer(std::unique_ptr<Connection> connection, sf::Uint32 version)
+{
+  RemotePeer& peer = *peers[connectedPlayers];
+  peer.connection = std::move(connection);
+
+  // Ahead of the join stream, the client waits for it
+  sf::Packet welcomePacket;
+  welcomePacket << static_cast<sf::Int32>(Server::Welcome);
+  welcomePacket << version;
+  peer.connection->send(welcomePacket);
+
+  peer.messageBucket = TokenBucket(peerMessageRate, peerMessageBurst);
+  peer.typeBuckets = createTypeBuckets();
+  peer.sessionToken = tokenGenerator();
+
+  // The snapshot holds the aircraft of everybody else
+  broadcastMessage("New player!");
+  peer.joinStream.reset(new JoinStream());
+  informWorldState(*peer.joinStream);
+
+  // order the new client to spawn its own plane ( player 1 )
+  sf::Int32 aircraftIdentifier = addAircraft();
+  const AircraftInfo& aircraft = *aircraftInfo.find(aircraftIdentifier);
+
+  // Peers are told apart in the capture by their first aircraft
+  if(recorder)
+    peer.connection->setRecorder(recorder.get(), static_cast<sf::Uint32>(aircraftIdentifier));
+
+  sf::Packet packet;
+  packet << static_cast<sf::Int32>(Server::SpawnSelf);
+  packet << aircraftIdentifier;
+  packet << aircraft.position.x;
+  packet << aircraft.position.y;
+
+  peer.aircraftIdentifiers.push_back(aircraftIdentifier);
+  notifyPlayerSpawn(aircraftIdentifier);
+
+  // Delivered once the join stream is complete
+  sendToPeer(peer, packet);
+
+  // Presented again to a server resuming this match after a migration
+  sf::Packet tokenPacket;
+  tokenPacket << static_cast<sf::Int32>(Server::SessionToken);
+  tokenPacket << static_cast<sf::Uint32>(peer.sessionToken >> 32);
+  tokenPacket << static_cast<sf::Uint32>(peer.sessionToken);
+  sendToPeer(peer, tokenPacket);
+
+  activatePeer(peer);
 }
 
 void GameServer::handleDisconnections()
@@ -452,7 +1111,6 @@ void GameServer::handleDisconnections()
       }
 
       connectedPlayers--;
-      aircraftCount -= (*itr)->aircraftIdentifiers.size();
 
       itr = peers.erase(itr);
 
@@ -472,53 +1130,225 @@ void GameServer::handleDisconnections()
   }
 }
 
-// Tell the newly connected peer about how the world is currently
-void GameServer::informWorldState(sf::TcpSocket& socket)
+// New aircraft in the middle of the battlefield, returns its identifier
+sf::Int32 GameServer::addAircraft()
 {
-  sf::Packet packet;
-  packet << static_cast<sf::Int32>(Server::InitialState);
-  packet << worldHeight << battleFieldRect.top + battleFieldRect.height;
-  packet << static_cast<sf::Int32>(aircraftCount);
+  AircraftInfo aircraft;
+  aircraft.position = sf::Vector2f(battleFieldRect.width / 2, battleFieldRect.top + battleFieldRect.height / 2);
+  aircraft.hitpoints = 100;
+  aircraft.missileAmmo = 2;
+  aircraft.realtimeActions = 0;
+  aircraft.broadcastActions = 0;
+
+  return aircraftInfo.insert(aircraft);
+}
+
+// Tell the newly connected peer about how the world is currently; the
+// snapshot is taken now but streamed out over the next ticks
+void GameServer::informWorldState(JoinStream& stream)
+{
+  stream.addSection(JoinStream::Critical, createInitialStatePacket());
+  stream.addSection(JoinStream::High, createInitialAircraftPacket());
+}
 
-  for(std::size_t i=0; i<connectedPlayers; ++i)
+sf::Packet GameServer::createInitialStatePacket() const
+{
+  sf::Packet statePacket;
+  statePacket << static_cast<sf::Int32>(Server::InitialState);
+  statePacket << worldHeight << battleFieldRect.top + battleFieldRect.height;
+  statePacket << now().asMilliseconds();
+  return statePacket;
+}
+
+sf::Packet GameServer::createInitialAircraftPacket() const
+{
+  sf::Packet aircraftPacket;
+  aircraftPacket << static_cast<sf::Int32>(Server::InitialAircraft);
+  aircraftPacket << static_cast<sf::Int32>(aircraftInfo.size());
+
+  for(std::size_t i=0; i<aircraftInfo.size(); ++i)
   {
-    if(peers[i]->ready)
-    {
-      FOREACH(sf::Int32 identifier, peers[i]->aircraftIdentifiers)
-      {
-        packet << identifier;
-        packet << aircraftInfo[identifier].position.x;
-        packet << aircraftInfo[identifier].position.y;
-        packet << aircraftInfo[identifier].hitpoints;
-        packet << aircraftInfo[identifier].missileAmmo;
-      }
-    }
+    const AircraftInfo& aircraft = aircraftInfo.getValue(i);
+    aircraftPacket << aircraftInfo.getIdentifier(i);
+    aircraftPacket << aircraft.position.x;
+    aircraftPacket << aircraft.position.y;
+    aircraftPacket << aircraft.hitpoints;
+    aircraftPacket << aircraft.missileAmmo;
   }
+  return aircraftPacket;
+}
 
-  socket.send(packet);
+void GameServer::sendJoinStreams()
+{
+  // A bounded amount per peer and tick, other peers never wait on a join
+  FOREACH(PeerPtr& peer, peers)
+  {
+    if(peer->ready && peer->joinStream &&
+        peer->joinStream->write(*peer->connection, joinBytesPerTick))
+      peer->joinStream.reset();
+  }
 }
 
 void GameServer::broadcastMessage(const std::string& message)
 {
-  for(std::size_t i=0; i<connectedPlayers; ++i)
-  {
-    if(peers[i]->ready)
-    {
-      sf::Packet packet;
-      packet << static_cast<sf::Int32>(Server::BroadcastMessage);
-      packet << message;
+  sf::Packet packet;
+  packet << static_cast<sf::Int32>(Server::BroadcastMessage);
+  packet << message;
 
-      peers[i]->socket.send(packet);
-    }
-  }
+  sendToAll(packet);
+}
+
+void GameServer::sendToPeer(RemotePeer& peer, sf::Packet& packet)
+{
+  if(peer.joinStream)
+    peer.joinStream->defer(packet);
+  else
+    peer.connection->send(packet);
 }
 
 void GameServer::sendToAll(sf::Packet& packet)
 {
+  recordForSpectators(packet);
+
   FOREACH(PeerPtr& peer, peers)
   {
     if(peer->ready)
-      peer->socket.send(packet);
+      sendToPeer(*peer, packet);
   }
 }
 
+void GameServer::recordForSpectators(const sf::Packet& packet)
+{
+  // Nobody watching: skip the encoding, a newcomer starts from a join state
+  if(spectatorHub && spectatorHub->getSpectatorCount() > 0)
+    SpectatorHub::appendPacket(spectatorFrame, packet);
+}
+
+void GameServer::publishSpectatorFrame()
+{
+  if(!spectatorHub)
+    return;
+
+  // Encoded once, the hub thread writes the same buffer to every spectator
+  if(!spectatorFrame.empty())
+  {
+    std::shared_ptr<std::vector<char> > frame(new std::vector<char>());
+    frame->swap(spectatorFrame);
+    spectatorHub->publish(frame);
+  }
+
+  // Spectators joining need the state the following frames build upon
+  if(spectatorHub->isJoinStateRequested())
+  {
+    std::shared_ptr<std::vector<char> > frame(new std::vector<char>());
+    SpectatorHub::appendPacket(*frame, createInitialStatePacket());
+    SpectatorHub::appendPacket(*frame, createInitialAircraftPacket());
+    spectatorHub->publishJoinState(frame);
+  }
+}
+
+void GameServer::resume(const std::string& checkpointFile)
+{
+  MatchCheckpoint checkpoint;
+  if(!checkpoint.loadFromFile(checkpointFile))
+    throw std::runtime_error("GameServer - Failed to load checkpoint " + checkpointFile);
+
+  // The server time carries on where the old process left it, plus the
+  // time the handover took; clients keep their synchronized clocks
+  sf::Int64 handoverTime = std::max<sf::Int64>(0, MatchCheckpoint::getWallClockTime() - checkpoint.wallClockTime);
+  timeOffset = checkpoint.serverTime + sf::milliseconds(static_cast<sf::Int32>(handoverTime));
+
+  worldHeight = checkpoint.worldHeight;
+  battleFieldRect = checkpoint.battleFieldRect;
+  lastSpawnTime = checkpoint.lastSpawnTime;
+  timeForNextSpawn = checkpoint.timeForNextSpawn;
+
+  FOREACH(const MatchCheckpoint::Aircraft& saved, checkpoint.aircraft)
+  {
+    AircraftInfo aircraft;
+    aircraft.position = saved.position;
+    aircraft.hitpoints = saved.hitpoints;
+    aircraft.missileAmmo = saved.missileAmmo;
+    aircraft.realtimeActions = saved.realtimeActions;
+    aircraft.broadcastActions = saved.realtimeActions;
+
+    if(!aircraftInfo.restore(saved.identifier, aircraft))
+      throw std::runtime_error("GameServer - Invalid aircraft in checkpoint " + checkpointFile);
+  }
+
+  reservedSessions = checkpoint.sessions;
+  reservationDeadline = now() + ReservationTime;
+}
+
+bool GameServer::migrate()
+{
+  std::string checkpointFile;
+  unsigned short targetPort;
+  {
+    sf::Lock lock(migrationMutex);
+    if(!migrationRequested)
+      return false;
+
+    migrationRequested = false;
+    checkpointFile = migrationFile;
+    targetPort = migrationPort;
+  }
+
+  MatchCheckpoint checkpoint;
+  checkpoint.serverTime = now();
+  checkpoint.wallClockTime = MatchCheckpoint::getWallClockTime();
+  checkpoint.worldHeight = worldHeight;
+  checkpoint.battleFieldRect = battleFieldRect;
+  checkpoint.lastSpawnTime = lastSpawnTime;
+  checkpoint.timeForNextSpawn = timeForNextSpawn;
+
+  for(std::size_t i=0; i<aircraftInfo.size(); ++i)
+  {
+    const AircraftInfo& aircraft = aircraftInfo.getValue(i);
+    MatchCheckpoint::Aircraft saved;
+    saved.identifier = aircraftInfo.getIdentifier(i);
+    saved.position = aircraft.position;
+    saved.hitpoints = aircraft.hitpoints;
+    saved.missileAmmo = aircraft.missileAmmo;
+    saved.realtimeActions = aircraft.realtimeActions;
+    checkpoint.aircraft.push_back(saved);
+  }
+
+  FOREACH(PeerPtr& peer, peers)
+  {
+    if(!peer->ready)
+      continue;
+
+    MatchCheckpoint::Session session;
+    session.token = peer->sessionToken;
+    session.aircraftIdentifiers = peer->aircraftIdentifiers;
+    checkpoint.sessions.push_back(session);
+  }
+
+  // Sessions not claimed yet still belong to the match
+  checkpoint.sessions.insert(checkpoint.sessions.end(), reservedSessions.begin(), reservedSessions.end());
+
+  if(!checkpoint.saveToFile(checkpointFile))
+  {
+    std::cout << "Migration failed, could not write " << checkpointFile << std::endl;
+    return false;
+  }
+
+  // Straight to the socket, a pending join stream is of no use anymore
+  sf::Packet packet;
+  packet << static_cast<sf::Int32>(Server::Migrate);
+  packet << static_cast<sf::Uint16>(targetPort);
+
+  FOREACH(PeerPtr& peer, peers)
+  {
+    if(peer->ready)
+      peer->connection->send(packet);
+  }
+
+  // The gateway drops this server, the resumed one registers itself
+  setListening(false);
+  gatewaySocket.reset();
+  migrated = true;
+  std::cout << "Match migrated to port " << targetPort << " through " << checkpointFile << std::endl;
+  return true;
+}
@@ -1,29 +1,95 @@
 #ifndef SOURCES_SCOUT_GAMESERVER_HPP_
 #define SOURCES_SCOUT_GAMESERVER_HPP_
 
+#include "Connection.hpp"
+#include "EntityTable.hpp"
+#include "JoinStream.hpp"
+#include "MatchCheckpoint.hpp"
+#include "MessageDispatcher.hpp"
+#include "NetworkStats.hpp"
+#include "PacketLog.hpp"
+#include "SpectatorHub.hpp"
+#include "StateScheduler.hpp"
+#include "TcpConnection.hpp"
+#include "TokenBucket.hpp"
+
 #include <SFML/Graphics/Rect.hpp>
 #include <SFML/Network/TcpListener.hpp>
 #include <SFML/Network/TcpSocket.hpp>
 #include <SFML/System/Clock.hpp>
+#include <SFML/System/Mutex.hpp>
 #include <SFML/System/NonCopyable.hpp>
 #include <SFML/System/Sleep.hpp>
 #include <SFML/System/Thread.hpp>
 #include <SFML/System/Vector2.hpp>
 
+#include <atomic>
+#include <random>
 #include <vector>
 #include <memory>
-#include <map>
+#include <string>
 
 class GameServer : private sf::NonCopyable
 {
   public:
-    explicit GameServer(sf::Vector2f battlefieldSize);
+    // Everything a host or a dedicated server may want to tune
+    struct Settings
+    {
+      Settings();
+
+      sf::Vector2f battlefieldSize;
+      unsigned short port;
+      std::size_t maxPlayers;
+      sf::Time tickInterval;
+      sf::Time updateInterval;
+      sf::Time pingInterval;
+      sf::Time idleTime;
+      sf::Time clientTimeout;
+      sf::Time statsDumpInterval;
+      std::size_t joinBytesPerTick;
+      std::size_t stateBytesPerUpdate; // per peer, 0 sends every aircraft
+      float peerMessageRate;
+      float peerMessageBurst;
+      std::size_t messageBudget;
+      unsigned short spectatorPort;
+      std::size_t maxSpectators;
+      std::string captureFile;
+      std::string resumeFile; // checkpoint of a migrated match to continue
+      std::string gatewayAddress; // load is reported to this gateway if set
+      unsigned short gatewayPort;
+    };
+
+    explicit GameServer(const Settings& settings);
     virtual ~GameServer();
 
+    // Connects a client living in the same process (the host) through
+    // lock-free queues instead of a socket, returns the client end
+    std::unique_ptr<Connection> connectLocal();
+
     void notifyPlayerSpawn(sf::Int32 aircraftIdentifier);
     void notifyPlayerRealtimeChange(sf::Int32 aircraftIdentifier, sf::Int32 action, bool actionEnabled);
     void notifyPlayerEvent(sf::Int32 aircraftIdentifier, sf::Int32 action);
 
+    // Snapshot of a peer's traffic statistics, copied once per tick under a
+    // lock, so it is safe to read from any thread
+    struct PeerStats
+    {
+      std::vector<sf::Int32> aircraftIdentifiers;
+      NetworkStats stats;
+      sf::Uint64 deferredUpdates;
+      sf::Uint64 droppedMessages;   // refused by the peer's rate limits
+      sf::Uint64 coalescedChanges;  // realtime toggles merged within a tick
+    };
+
+    std::vector<PeerStats> getPeerStats() const;
+    // Passes in which a peer used up its whole per-tick message budget
+    sf::Uint64 getBudgetFilledPasses() const;
+
+    // Writes the match to a checkpoint and sends every client to a server
+    // resumed from it on the given port, then stops; safe from any thread
+    void requestMigration(const std::string& checkpointFile, unsigned short port);
+    bool isMigrated() const;
+
   private:
     // A GameServerRemotePeer refers to one instance of the game, it may be
     // local or from another computer
@@ -31,7 +97,13 @@ class GameServer : private sf::NonCopyable
     {
       RemotePeer();
 
-      sf::TcpSocket socket;
+      std::unique_ptr<Connection> connection;
+      std::unique_ptr<JoinStream> joinStream;
+      TokenBucket messageBucket;
+      std::vector<TokenBucket> typeBuckets;
+      StateScheduler stateScheduler;
+      sf::Uint32 pendingRealtimeChanges;
+      sf::Uint64 sessionToken;
       sf::Time lastPacketTime;
       std::vector<sf::Int32> aircraftIdentifiers;
       bool ready;
@@ -44,7 +116,15 @@ class GameServer : private sf::NonCopyable
       sf::Vector2f position;
       sf::Int32 hitpoints;
       sf::Int32 missileAmmo;
-      std::map<sf::Int32, bool> realtimeActions;
+      sf::Uint32 realtimeActions; // bit per action
+      sf::Uint32 broadcastActions; // as last told to the peers
+    };
+
+    // Accepted, waiting for its first message
+    struct HandshakingConnection
+    {
+      std::unique_ptr<Connection> connection;
+      sf::Time acceptTime;
     };
 
     // Unique pointer to remote peers
@@ -52,7 +132,9 @@ class GameServer : private sf::NonCopyable
 
     sf::Thread thread;
     sf::Clock clock;
+    sf::Time timeOffset;
     sf::TcpListener listenerSocket;
+    unsigned short port;
     bool listeningState;
     sf::Time clientTimeoutTime;
 
@@ -61,33 +143,109 @@ class GameServer : private sf::NonCopyable
 
     float worldHeight;
     sf::FloatRect battleFieldRect;
-    float battleFieldScrollSpeed;
 
-    std::size_t aircraftCount;
-    std::map<sf::Int32, AircraftInfo> aircraftInfo;
+    EntityTable<AircraftInfo> aircraftInfo;
 
     std::vector<PeerPtr> peers;
-    sf::Int32 aircraftIdentifierCounter;
-    bool waitingThreadEnd;
+    std::atomic<bool> waitingThreadEnd;
+    sf::Time idleTime;
+
+    std::unique_ptr<TcpConnection> pendingConnection;
+    std::unique_ptr<Connection> pendingLocalConnection;
+    sf::Mutex localConnectionMutex;
 
     sf::Time lastSpawnTime;
     sf::Time timeForNextSpawn;
 
+    sf::Time tickInterval;
+    sf::Time updateInterval;
+    sf::Time lastUpdateTime;
+    sf::Time pingInterval;
+    sf::Time lastPingTime;
+    std::size_t joinBytesPerTick;
+    std::size_t stateBytesPerUpdate;
+    float peerMessageRate;
+    float peerMessageBurst;
+    std::size_t messageBudget;
+
+    mutable sf::Mutex statsMutex;
+    std::vector<PeerStats> peerStats;
+    std::atomic<sf::Uint64> budgetFilledPasses;
+    sf::Time statsDumpInterval;
+    sf::Time lastStatsDumpTime;
+
+    std::unique_ptr<PacketRecorder> recorder;
+    MessageDispatcher<RemotePeer&> dispatcher;
+
+    std::unique_ptr<SpectatorHub> spectatorHub;
+    std::vector<char> spectatorFrame;
+
+    std::mt19937_64 tokenGenerator;
+    std::vector<MatchCheckpoint::Session> reservedSessions;
+    sf::Time reservationDeadline;
+    std::vector<HandshakingConnection> handshakingConnections;
+
+    sf::Mutex migrationMutex;
+    bool migrationRequested;
+    std::string migrationFile;
+    unsigned short migrationPort;
+    std::atomic<bool> migrated;
+
+    std::string gatewayAddress;
+    unsigned short gatewayPort;
+    std::unique_ptr<sf::TcpSocket> gatewaySocket;
+    bool gatewayConnected;
+    sf::Time gatewayConnectDeadline;
+    sf::Time nextLoadReportTime;
+
     void setListening(bool enable);
     void executionThread();
     void tick();
     sf::Time now() const;
 
     void handleIncomingPackets();
-    void handleIncomingPacket(sf::Packet& packet, RemotePeer& receivingPeer, bool& detectedTimeout);
+    void registerHandlers();
+    void handleQuit(sf::Packet& packet, RemotePeer& receivingPeer);
+    void handleClockSyncRequest(sf::Packet& packet, RemotePeer& receivingPeer);
+    void handlePong(sf::Packet& packet, RemotePeer& receivingPeer);
+    void handlePlayerEvent(sf::Packet& packet, RemotePeer& receivingPeer);
+    void handlePlayerRealtimeChange(sf::Packet& packet, RemotePeer& receivingPeer);
+    void handleRequestCoopPartner(sf::Packet& packet, RemotePeer& receivingPeer);
+    void handlePositionUpdate(sf::Packet& packet, RemotePeer& receivingPeer);
+    void handleGameEvent(sf::Packet& packet, RemotePeer& receivingPeer);
+    bool admitPacket(RemotePeer& peer, const sf::Packet& packet);
+    bool ownsAircraft(const RemotePeer& peer, sf::Int32 aircraftIdentifier) const;
+    void flushRealtimeChanges();
 
     void handleIncomingConnections();
+    void addPeer(std::unique_ptr<Connection> connection, sf::Uint32 version);
+    void startHandshake(std::unique_ptr<Connection> connection);
+    void handleHandshakes();
+    void rejectConnection(Connection& connection, const std::string& reason);
+    void resumePeer(std::unique_ptr<Connection> connection, const MatchCheckpoint::Session& session);
+    void activatePeer(RemotePeer& peer);
+    void expireReservedSessions();
     void handleDisconnections();
 
-    void informWorldState(sf::TcpSocket& socket);
+    sf::Int32 addAircraft();
+    void informWorldState(JoinStream& stream);
+    sf::Packet createInitialStatePacket() const;
+    sf::Packet createInitialAircraftPacket() const;
+    void sendJoinStreams();
     void broadcastMessage(const std::string& message);
+    void sendToPeer(RemotePeer& peer, sf::Packet& packet);
     void sendToAll(sf::Packet& packet);
     void updateClientState();
+    void updatePeerState(RemotePeer& peer);
+    void sendPings();
+    void publishStats();
+    void dumpStats();
+    void reportLoad();
+    void recordForSpectators(const sf::Packet& packet);
+    void publishSpectatorFrame();
+
+    void resume(const std::string& checkpointFile);
+    bool migrate();
 };
 
 #endif
@@ -0,0 +1,180 @@
+#include "JoinStream.hpp"
+#include "Compression.hpp"
+#include "Connection.hpp"
+#include "Foreach.hpp"
+#include "NetworkProtocol.hpp"
+
+#include <algorithm>
+
+namespace
+{
+  // Compressed bytes per chunk, small enough not to delay other messages
+  const std::size_t ChunkSize = 512;
+
+  // Largest section a reader accepts, far beyond any game state. The raw
+  // size comes from the sender and sizes the decompression buffer
+  const sf::Int32 MaxRawSize = 4 * 1024 * 1024;
+
+  // The compressor's literal runs add a little to incompressible data, a
+  // section never grows to twice its raw size
+  const std::size_t MaxCompressedSize = 2 * static_cast<std::size_t>(MaxRawSize);
+}
+
+JoinStream::JoinStream() :
+  sections(),
+  deferred(),
+  currentSection(0),
+  currentOffset(0),
+  currentChunk(0)
+{
+}
+
+void JoinStream::addSection(Priority priority, const sf::Packet& message)
+{
+  Section section;
+  section.priority = priority;
+  section.rawSize = static_cast<sf::Int32>(message.getDataSize());
+  section.data = Compression::compress(message.getData(), message.getDataSize());
+
+  // Keep sections sorted by priority, equal priorities in insertion order
+  auto position = std::upper_bound(sections.begin() + currentSection, sections.end(), section,
+      [] (const Section& a, const Section& b) { return a.priority < b.priority; });
+  sections.insert(position, std::move(section));
+}
+
+void JoinStream::defer(const sf::Packet& message)
+{
+  deferred.push_back(message);
+}
+
+bool JoinStream::write(Connection& connection, std::size_t byteBudget)
+{
+  std::size_t sentBytes = 0;
+
+  while(currentSection < sections.size() && sentBytes < byteBudget)
+  {
+    const Section& section = sections[currentSection];
+    sf::Int32 chunkCount = static_cast<sf::Int32>(std::max<std::size_t>(1,
+          (section.data.size() + ChunkSize - 1) / ChunkSize));
+    std::size_t size = std::min(ChunkSize, section.data.size() - currentOffset);
+
+    sf::Packet packet;
+    packet << static_cast<sf::Int32>(Server::JoinStateChunk);
+    packet << static_cast<sf::Int32>(currentSection);
+    packet << currentChunk << chunkCount << section.rawSize;
+    packet << static_cast<sf::Uint32>(size);
+    if(size > 0)
+      packet.append(&section.data[currentOffset], size);
+
+    connection.send(packet);
+    sentBytes += packet.getDataSize();
+
+    currentOffset += size;
+    if(++currentChunk >= chunkCount)
+    {
+      currentSection++;
+      currentOffset = 0;
+      currentChunk = 0;
+    }
+  }
+
+  if(currentSection < sections.size())
+    return false;
+
+  // Whatever happened meanwhile follows the snapshot it builds upon
+  FOREACH(sf::Packet& message, deferred)
+    connection.send(message);
+  deferred.clear();
+  return true;
+}
+
+std::size_t JoinStream::getRawSize() const
+{
+  std::size_t size = 0;
+  FOREACH(const Section& section, sections)
+    size += static_cast<std::size_t>(section.rawSize);
+  return size;
+}
+
+std::size_t JoinStream::getCompressedSize() const
+{
+  std::size_t size = 0;
+  FOREACH(const Section& section, sections)
+    size += section.data.size();
+  return size;
+}
+
+JoinStreamReader::JoinStreamReader() :
+  section(-1),
+  nextChunk(0),
+  chunkCount(0),
+  rawSize(0),
+  data()
+{
+}
+
+bool JoinStreamReader::addChunk(sf::Packet& chunk, sf::Packet& message)
+{
+  sf::Int32 chunkSection;
+  sf::Int32 chunkIndex;
+  sf::Int32 chunkTotal;
+  sf::Int32 chunkRawSize;
+  sf::Uint32 size;
+  chunk >> chunkSection >> chunkIndex >> chunkTotal >> chunkRawSize >> size;
+
+  // The payload is the rest of the packet, after its type and the header
+  const std::size_t headerSize = sizeof(sf::Int32) * 5 + sizeof(sf::Uint32);
+  if(!chunk || chunk.getDataSize() < headerSize || size != chunk.getDataSize() - headerSize)
+    return false;
+
+  if(chunkIndex == 0)
+  {
+    // A new section, whatever was collected before it is dropped
+    reset();
+    if(chunkSection < 0 || chunkTotal <= 0 || chunkRawSize < 0 || chunkRawSize > MaxRawSize)
+      return false;
+
+    section = chunkSection;
+    chunkCount = chunkTotal;
+    rawSize = chunkRawSize;
+  }
+  else if(section < 0 || chunkSection != section || chunkIndex != nextChunk ||
+      chunkTotal != chunkCount || chunkRawSize != rawSize)
+  {
+    // Out of order or inconsistent, the section cannot be rebuilt
+    reset();
+    return false;
+  }
+
+  if(data.size() + size > MaxCompressedSize)
+  {
+    reset();
+    return false;
+  }
+
+  const char* bytes = static_cast<const char*>(chunk.getData()) + headerSize;
+  data.insert(data.end(), bytes, bytes + size);
+
+  if(++nextChunk < chunkCount)
+    return false;
+
+  std::vector<char> raw;
+  const bool decompressed = Compression::decompress(data, static_cast<std::size_t>(rawSize), raw);
+  reset();
+  if(!decompressed)
+    return false;
+
+  message.clear();
+  if(!raw.empty())
+    message.append(&raw[0], raw.size());
+  return true;
+}
+
+void JoinStreamReader::reset()
+{
+  section = -1;
+  nextChunk = 0;
+  chunkCount = 0;
+  rawSize = 0;
+  data.clear();
+}
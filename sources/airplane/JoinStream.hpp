@@ -0,0 +1,80 @@
+#ifndef SOURCES_SCOUT_JOINSTREAM_HPP_
+#define SOURCES_SCOUT_JOINSTREAM_HPP_
+
+#include <SFML/Config.hpp>
+#include <SFML/Network/Packet.hpp>
+#include <SFML/System/NonCopyable.hpp>
+
+#include <cstddef>
+#include <vector>
+
+class Connection;
+
+// Everything a late joiner needs to catch up, sent as compressed chunks over
+// several ticks instead of one large packet.
+//
+// Each section is a complete server message. Sections go out by priority
+// (then in insertion order), each one split into Server::JoinStateChunk
+// messages. Messages sent to the peer while the stream is still running are
+// held back and delivered once it is done, so the peer sees them in order.
+class JoinStream : private sf::NonCopyable
+{
+  public:
+    enum Priority
+    {
+      Critical, // world and clock, needed before anything else makes sense
+      High,     // players
+      Normal,
+      Low
+    };
+
+    JoinStream();
+
+    void addSection(Priority priority, const sf::Packet& message);
+    void defer(const sf::Packet& message);
+
+    // Sends about byteBudget bytes worth of chunks, true once everything
+    // (including the deferred messages) was handed to the connection
+    bool write(Connection& connection, std::size_t byteBudget);
+
+    std::size_t getRawSize() const;
+    std::size_t getCompressedSize() const;
+
+  private:
+    struct Section
+    {
+      Priority priority;
+      sf::Int32 rawSize;
+      std::vector<char> data;
+    };
+
+    std::vector<Section> sections;
+    std::vector<sf::Packet> deferred;
+    std::size_t currentSection;
+    std::size_t currentOffset;
+    sf::Int32 currentChunk;
+};
+
+// Client side: collects the chunks and rebuilds the original messages
+class JoinStreamReader
+{
+  public:
+    JoinStreamReader();
+
+    // Consumes a JoinStateChunk (type already read), returns true when it
+    // completed a section, which is then stored in message
+    bool addChunk(sf::Packet& chunk, sf::Packet& message);
+
+  private:
+    void reset();
+
+    // The section being collected (-1 for none) and what its first chunk
+    // announced, every later chunk has to agree
+    sf::Int32 section;
+    sf::Int32 nextChunk;
+    sf::Int32 chunkCount;
+    sf::Int32 rawSize;
+    std::vector<char> data;
+};
+
+#endif
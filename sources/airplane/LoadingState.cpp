@@ -0,0 +1,74 @@
+#include "LoadingState.hpp"
+#include "AssetLoader.hpp"
+#include "ResourceHolder.hpp"
+#include "WindowUtils.hpp"
+
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/View.hpp>
+
+LoadingState::LoadingState(StateStack& stack, Context context, States::ID nextState) :
+  State(stack, context),
+  loadingText(),
+  progressBarBackground(),
+  progressBar(),
+  nextState(nextState)
+{
+  sf::Font& font = context.fonts->get(Fonts::Main);
+  sf::Vector2f windowSize(context.target->getSize());
+
+  loadingText.setFont(font);
+  loadingText.setString("Loading Resources");
+  centerOrigin(loadingText);
+  loadingText.setPosition(0.5f * windowSize.x, 0.5f * windowSize.y + 50.f);
+
+  progressBarBackground.setFillColor(sf::Color::White);
+  progressBarBackground.setSize(sf::Vector2f(windowSize.x - 20.f, 10.f));
+  progressBarBackground.setPosition(10.f, loadingText.getPosition().y + 40.f);
+
+  progressBar.setFillColor(sf::Color(100, 100, 100));
+  progressBar.setSize(sf::Vector2f(200.f, 10.f));
+  progressBar.setPosition(10.f, loadingText.getPosition().y + 40.f);
+
+  setCompletion(0.f);
+}
+
+void LoadingState::draw()
+{
+  sf::RenderTarget& target = *getContext().target;
+  target.setView(target.getDefaultView());
+
+  target.draw(loadingText);
+  target.draw(progressBarBackground);
+  target.draw(progressBar);
+}
+
+bool LoadingState::update(sf::Time)
+{
+  // The Application runs the uploads every frame, only watch them here
+  AssetLoader& loader = AssetLoader::getInstance();
+  if(loader.isIdle())
+  {
+    requestStackPop();
+    requestStackPush(nextState);
+    return false;
+  }
+
+  std::size_t scheduled = loader.getScheduledCount();
+  if(scheduled > 0)
+    setCompletion(static_cast<float>(loader.getFinishedCount()) / static_cast<float>(scheduled));
+  return false;
+}
+
+bool LoadingState::handleEvent(const sf::Event&)
+{
+  return false;
+}
+
+void LoadingState::setCompletion(float percent)
+{
+  // Clamp
+  if(percent > 1.f)
+    percent = 1.f;
+
+  progressBar.setSize(sf::Vector2f(progressBarBackground.getSize().x * percent, progressBar.getSize().y));
+}
@@ -0,0 +1,29 @@
+#ifndef SOURCES_SCOUT_LOADINGSTATE_HPP_
+#define SOURCES_SCOUT_LOADINGSTATE_HPP_
+
+#include "State.hpp"
+
+#include <SFML/Graphics/RectangleShape.hpp>
+#include <SFML/Graphics/Text.hpp>
+
+// Shows the progress of the AssetLoader until it has nothing left to do,
+// then replaces itself with the next state
+class LoadingState : public State
+{
+  public:
+    LoadingState(StateStack& stack, Context context, States::ID nextState);
+
+    virtual void draw();
+    virtual bool update(sf::Time dt);
+    virtual bool handleEvent(const sf::Event& event);
+
+  private:
+    sf::Text loadingText;
+    sf::RectangleShape progressBarBackground;
+    sf::RectangleShape progressBar;
+    States::ID nextState;
+
+    void setCompletion(float percent);
+};
+
+#endif
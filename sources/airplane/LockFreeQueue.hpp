@@ -0,0 +1,86 @@
+#ifndef SOURCES_SCOUT_LOCKFREEQUEUE_HPP_
+#define SOURCES_SCOUT_LOCKFREEQUEUE_HPP_
+
+#include <SFML/System/NonCopyable.hpp>
+
+#include <atomic>
+#include <utility>
+
+// Unbounded single producer / single consumer queue. push() must only be
+// called from one thread and pop() from one (possibly other) thread; neither
+// ever blocks or takes a lock.
+template <typename T>
+class LockFreeQueue : private sf::NonCopyable
+{
+  public:
+    LockFreeQueue();
+    ~LockFreeQueue();
+
+    void push(T value);
+    bool pop(T& value);
+
+  private:
+    struct Node
+    {
+      Node();
+
+      T value;
+      std::atomic<Node*> next;
+    };
+
+    // Consumer owns head (a dummy node), producer owns tail
+    Node* head;
+    Node* tail;
+};
+
+template <typename T>
+LockFreeQueue<T>::Node::Node() :
+  value(),
+  next(nullptr)
+{
+}
+
+template <typename T>
+LockFreeQueue<T>::LockFreeQueue() :
+  head(new Node()),
+  tail(head)
+{
+}
+
+template <typename T>
+LockFreeQueue<T>::~LockFreeQueue()
+{
+  while(head)
+  {
+    Node* next = head->next.load(std::memory_order_relaxed);
+    delete head;
+    head = next;
+  }
+}
+
+template <typename T>
+void LockFreeQueue<T>::push(T value)
+{
+  Node* node = new Node();
+  node->value = std::move(value);
+
+  // Publish the fully constructed node to the consumer
+  tail->next.store(node, std::memory_order_release);
+  tail = node;
+}
+
+template <typename T>
+bool LockFreeQueue<T>::pop(T& value)
+{
+  Node* next = head->next.load(std::memory_order_acquire);
+  if(!next)
+    return false;
+
+  // The popped node becomes the new dummy
+  value = std::move(next->value);
+  delete head;
+  head = next;
+  return true;
+}
+
+#endif
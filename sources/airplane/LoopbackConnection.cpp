@@ -0,0 +1,56 @@
+#include "LoopbackConnection.hpp"
+
+#include <SFML/Network/Packet.hpp>
+
+LoopbackConnection::Channel::Channel()
+{
+  closed[0] = false;
+  closed[1] = false;
+}
+
+void LoopbackConnection::createPair(Ptr& first, Ptr& second)
+{
+  std::shared_ptr<Channel> channel(new Channel());
+  first.reset(new LoopbackConnection(channel, 0));
+  second.reset(new LoopbackConnection(channel, 1));
+}
+
+LoopbackConnection::LoopbackConnection(std::shared_ptr<Channel> channel, std::size_t side) :
+  Connection(),
+  channel(channel),
+  side(side)
+{
+}
+
+LoopbackConnection::~LoopbackConnection()
+{
+  // The other end sees a disconnection once it has drained its queue
+  channel->closed[side].store(true, std::memory_order_release);
+}
+
+sf::Socket::Status LoopbackConnection::sendPacket(sf::Packet& packet)
+{
+  if(channel->closed[1 - side].load(std::memory_order_acquire))
+    return sf::Socket::Disconnected;
+
+  // Each end writes into the queue of its own side and reads the other one
+  const char* data = static_cast<const char*>(packet.getData());
+  channel->queues[side].push(std::vector<char>(data, data + packet.getDataSize()));
+  return sf::Socket::Done;
+}
+
+sf::Socket::Status LoopbackConnection::receivePacket(sf::Packet& packet)
+{
+  // Read the flag first: once it is set every message of the other end is
+  // already in the queue, so an empty queue then really means disconnected
+  bool peerClosed = channel->closed[1 - side].load(std::memory_order_acquire);
+
+  std::vector<char> data;
+  if(!channel->queues[1 - side].pop(data))
+    return peerClosed ? sf::Socket::Disconnected : sf::Socket::NotReady;
+
+  packet.clear();
+  if(!data.empty())
+    packet.append(&data[0], data.size());
+  return sf::Socket::Done;
+}
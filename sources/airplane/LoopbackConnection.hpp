@@ -0,0 +1,47 @@
+#ifndef SOURCES_SCOUT_LOOPBACKCONNECTION_HPP_
+#define SOURCES_SCOUT_LOOPBACKCONNECTION_HPP_
+
+#include "Connection.hpp"
+#include "LockFreeQueue.hpp"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Connection between two threads of the same process, used by the hosting
+// client to talk to its own GameServer. Messages are handed over through
+// lock-free queues, without sockets, kernel copies or framing; each end must
+// be used from a single thread.
+class LoopbackConnection : public Connection
+{
+  public:
+    typedef std::unique_ptr<Connection> Ptr;
+
+    // Creates two connected ends, what one sends the other receives
+    static void createPair(Ptr& first, Ptr& second);
+
+    virtual ~LoopbackConnection();
+
+  protected:
+    virtual sf::Socket::Status sendPacket(sf::Packet& packet);
+    virtual sf::Socket::Status receivePacket(sf::Packet& packet);
+
+  private:
+    typedef LockFreeQueue<std::vector<char> > Queue;
+
+    // Both directions, shared by the two ends
+    struct Channel
+    {
+      Channel();
+
+      Queue queues[2];
+      std::atomic<bool> closed[2];
+    };
+
+    LoopbackConnection(std::shared_ptr<Channel> channel, std::size_t side);
+
+    std::shared_ptr<Channel> channel;
+    std::size_t side;
+};
+
+#endif
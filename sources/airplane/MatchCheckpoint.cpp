@@ -0,0 +1,145 @@
+#include "MatchCheckpoint.hpp"
+#include "Foreach.hpp"
+
+#include <SFML/Network/Packet.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+  const char Magic[4] = { 'S', 'C', 'C', 'K' };
+  const sf::Uint8 Version = 1;
+
+  void writeUint64(sf::Packet& packet, sf::Uint64 value)
+  {
+    packet << static_cast<sf::Uint32>(value >> 32) << static_cast<sf::Uint32>(value);
+  }
+
+  sf::Uint64 readUint64(sf::Packet& packet)
+  {
+    sf::Uint32 high = 0;
+    sf::Uint32 low = 0;
+    packet >> high >> low;
+    return (static_cast<sf::Uint64>(high) << 32) | low;
+  }
+}
+
+MatchCheckpoint::MatchCheckpoint() :
+  serverTime(sf::Time::Zero),
+  wallClockTime(0),
+  worldHeight(0.f),
+  battleFieldRect(),
+  lastSpawnTime(sf::Time::Zero),
+  timeForNextSpawn(sf::Time::Zero),
+  aircraft(),
+  sessions()
+{
+}
+
+bool MatchCheckpoint::saveToFile(const std::string& filename) const
+{
+  sf::Packet packet;
+  packet << static_cast<sf::Int32>(serverTime.asMilliseconds());
+  writeUint64(packet, static_cast<sf::Uint64>(wallClockTime));
+  packet << worldHeight;
+  packet << battleFieldRect.left << battleFieldRect.top;
+  packet << battleFieldRect.width << battleFieldRect.height;
+  packet << static_cast<sf::Int32>(lastSpawnTime.asMilliseconds());
+  packet << static_cast<sf::Int32>(timeForNextSpawn.asMilliseconds());
+
+  packet << static_cast<sf::Uint32>(aircraft.size());
+  FOREACH(const Aircraft& entry, aircraft)
+  {
+    packet << entry.identifier << entry.position.x << entry.position.y;
+    packet << entry.hitpoints << entry.missileAmmo << entry.realtimeActions;
+  }
+
+  packet << static_cast<sf::Uint32>(sessions.size());
+  FOREACH(const Session& session, sessions)
+  {
+    writeUint64(packet, session.token);
+    packet << static_cast<sf::Uint32>(session.aircraftIdentifiers.size());
+    FOREACH(sf::Int32 identifier, session.aircraftIdentifiers)
+      packet << identifier;
+  }
+
+  // Written aside and renamed, a reader never sees half a checkpoint
+  std::string temporary = filename + ".tmp";
+  {
+    std::ofstream file(temporary.c_str(), std::ios::binary | std::ios::trunc);
+    file.write(Magic, sizeof(Magic));
+    file.put(static_cast<char>(Version));
+    file.write(static_cast<const char*>(packet.getData()), packet.getDataSize());
+    if(!file)
+      return false;
+  }
+
+  std::remove(filename.c_str());
+  return std::rename(temporary.c_str(), filename.c_str()) == 0;
+}
+
+bool MatchCheckpoint::loadFromFile(const std::string& filename)
+{
+  std::ifstream file(filename.c_str(), std::ios::binary);
+  std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  if(data.size() < sizeof(Magic) + 1 ||
+      !std::equal(Magic, Magic + sizeof(Magic), data.begin()) ||
+      static_cast<sf::Uint8>(data[sizeof(Magic)]) != Version)
+    return false;
+
+  sf::Packet packet;
+  packet.append(&data[sizeof(Magic) + 1], data.size() - sizeof(Magic) - 1);
+
+  sf::Int32 milliseconds = 0;
+  packet >> milliseconds;
+  serverTime = sf::milliseconds(milliseconds);
+  wallClockTime = static_cast<sf::Int64>(readUint64(packet));
+  packet >> worldHeight;
+  packet >> battleFieldRect.left >> battleFieldRect.top;
+  packet >> battleFieldRect.width >> battleFieldRect.height;
+  packet >> milliseconds;
+  lastSpawnTime = sf::milliseconds(milliseconds);
+  packet >> milliseconds;
+  timeForNextSpawn = sf::milliseconds(milliseconds);
+
+  sf::Uint32 count = 0;
+  packet >> count;
+  aircraft.clear();
+  for(sf::Uint32 i=0; i<count && packet; ++i)
+  {
+    Aircraft entry;
+    packet >> entry.identifier >> entry.position.x >> entry.position.y;
+    packet >> entry.hitpoints >> entry.missileAmmo >> entry.realtimeActions;
+    aircraft.push_back(entry);
+  }
+
+  packet >> count;
+  sessions.clear();
+  for(sf::Uint32 i=0; i<count && packet; ++i)
+  {
+    Session session;
+    session.token = readUint64(packet);
+
+    sf::Uint32 identifierCount = 0;
+    packet >> identifierCount;
+    for(sf::Uint32 j=0; j<identifierCount && packet; ++j)
+    {
+      sf::Int32 identifier;
+      packet >> identifier;
+      session.aircraftIdentifiers.push_back(identifier);
+    }
+    sessions.push_back(session);
+  }
+
+  return static_cast<bool>(packet);
+}
+
+sf::Int64 MatchCheckpoint::getWallClockTime()
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,51 @@
+#ifndef SOURCES_SCOUT_MATCHCHECKPOINT_HPP_
+#define SOURCES_SCOUT_MATCHCHECKPOINT_HPP_
+
+#include <SFML/Config.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Time.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include <string>
+#include <vector>
+
+// Everything needed to resume a running match in another server process.
+//
+// File layout: "SCCK" [Uint8:version] then the fields below in sf::Packet
+// encoding (big endian). 64 bit values are stored as two Uint32 halves.
+struct MatchCheckpoint
+{
+  struct Aircraft
+  {
+    sf::Int32 identifier;
+    sf::Vector2f position;
+    sf::Int32 hitpoints;
+    sf::Int32 missileAmmo;
+    sf::Uint32 realtimeActions;
+  };
+
+  // A connected client, reclaimed by presenting its token again
+  struct Session
+  {
+    sf::Uint64 token;
+    std::vector<sf::Int32> aircraftIdentifiers;
+  };
+
+  MatchCheckpoint();
+
+  bool saveToFile(const std::string& filename) const;
+  bool loadFromFile(const std::string& filename);
+
+  sf::Time serverTime;
+  sf::Int64 wallClockTime; // milliseconds, accounts for the handover gap
+  float worldHeight;
+  sf::FloatRect battleFieldRect;
+  sf::Time lastSpawnTime;
+  sf::Time timeForNextSpawn;
+  std::vector<Aircraft> aircraft;
+  std::vector<Session> sessions;
+
+  static sf::Int64 getWallClockTime();
+};
+
+#endif
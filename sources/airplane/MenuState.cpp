@@ -2,6 +2,7 @@
 #include "Button.hpp"
 #include "MusicPlayer.hpp"
 #include "ResourceHolder.hpp"
+#include "SoundPlayer.hpp"
 #include "WindowUtils.hpp"
 
 #include <SFML/Graphics/RenderTarget.hpp>
@@ -41,8 +42,17 @@ MenuState::MenuState(StateStack& stack, Context context) :
         requestStackPush(States::JoinGame);
       });
 
+  auto spectateButton = std::make_shared<GUI::Button>(context);
+  spectateButton->setPosition(100, 450);
+  spectateButton->setText("Spectate");
+  spectateButton->setCallback([this] ()
+      {
+        requestStackPop();
+        requestStackPush(States::SpectateGame);
+      });
+
   auto settingsButton = std::make_shared<GUI::Button>(context);
-  settingsButton->setPosition(100, 450);
+  settingsButton->setPosition(100, 500);
   settingsButton->setText("Settings");
   settingsButton->setCallback([this] ()
       {
@@ -50,7 +60,7 @@ MenuState::MenuState(StateStack& stack, Context context) :
       });
 
   auto exitButton = std::make_shared<GUI::Button>(context);
-  exitButton->setPosition(100, 500);
+  exitButton->setPosition(100, 550);
   exitButton->setText("Exit");
   exitButton->setCallback([this] ()
       {
@@ -60,10 +70,16 @@ MenuState::MenuState(StateStack& stack, Context context) :
   guiContainer.pack(playButton);
   guiContainer.pack(hostPlayButton);
   guiContainer.pack(joinPlayButton);
+  guiContainer.pack(spectateButton);
   guiContainer.pack(settingsButton);
   guiContainer.pack(exitButton);
 
   //context.music->play(Music::MenuTheme);
+
+  // The menu only plays its buttons; back from a game, the game's sounds
+  // go until the next World prefetches them
+  context.sounds->prefetch(SoundEffect::Button);
+  context.sounds->evictAllExcept(SoundEffect::Button);
 }
 
 void MenuState::draw()
@@ -0,0 +1,159 @@
+#ifndef SOURCES_SCOUT_MESSAGEDISPATCHER_HPP_
+#define SOURCES_SCOUT_MESSAGEDISPATCHER_HPP_
+
+#include <SFML/Config.hpp>
+#include <SFML/Network/Packet.hpp>
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Time.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+// Routes received messages to the handler registered for their type.
+//
+// The handler reads the received packet in place, right after the type.
+// Messages shorter than the size registered for their type never reach it;
+// variable length messages register their fixed part and check the packet
+// state while reading the rest. Counts and handling time are kept per type.
+template <typename... Arguments>
+class MessageDispatcher : private sf::NonCopyable
+{
+  public:
+    typedef std::function<void(sf::Packet&, Arguments...)> Handler;
+
+    struct TypeStats
+    {
+      TypeStats();
+
+      sf::Uint64 handled;
+      sf::Uint64 rejected;  // shorter than registered
+      sf::Uint64 malformed; // handler read past the end
+      sf::Time totalTime;
+      sf::Time maxTime;
+    };
+
+    MessageDispatcher();
+
+    // minimumSize is the payload size in bytes, without the type
+    void registerHandler(sf::Int32 type, std::size_t minimumSize, Handler handler);
+
+    // False if the message was not handled
+    bool dispatch(sf::Packet& packet, Arguments... arguments);
+
+    TypeStats getStats(sf::Int32 type) const;
+    sf::Uint64 getUnknown() const;
+    void print(std::ostream& out) const;
+
+  private:
+    struct Entry
+    {
+      Handler handler;
+      std::size_t minimumSize;
+      TypeStats stats;
+    };
+
+    std::vector<Entry> entries;
+    sf::Uint64 unknown;
+    sf::Clock clock;
+};
+
+template <typename... Arguments>
+MessageDispatcher<Arguments...>::TypeStats::TypeStats() :
+  handled(0),
+  rejected(0),
+  malformed(0),
+  totalTime(sf::Time::Zero),
+  maxTime(sf::Time::Zero)
+{
+}
+
+template <typename... Arguments>
+MessageDispatcher<Arguments...>::MessageDispatcher() :
+  entries(),
+  unknown(0),
+  clock()
+{
+}
+
+template <typename... Arguments>
+void MessageDispatcher<Arguments...>::registerHandler(sf::Int32 type, std::size_t minimumSize, Handler handler)
+{
+  // Packet types are small consecutive enumerators, index by them
+  if(type < 0)
+    return;
+
+  if(entries.size() <= static_cast<std::size_t>(type))
+    entries.resize(type + 1);
+
+  entries[type].handler = handler;
+  entries[type].minimumSize = minimumSize;
+}
+
+template <typename... Arguments>
+bool MessageDispatcher<Arguments...>::dispatch(sf::Packet& packet, Arguments... arguments)
+{
+  sf::Int32 type = -1;
+  packet >> type;
+
+  if(!packet || type < 0 || static_cast<std::size_t>(type) >= entries.size() || !entries[type].handler)
+  {
+    unknown++;
+    return false;
+  }
+
+  Entry& entry = entries[type];
+  if(packet.getDataSize() < sizeof(sf::Int32) + entry.minimumSize)
+  {
+    entry.stats.rejected++;
+    return false;
+  }
+
+  sf::Time start = clock.getElapsedTime();
+  entry.handler(packet, arguments...);
+  sf::Time elapsed = clock.getElapsedTime() - start;
+
+  entry.stats.handled++;
+  entry.stats.totalTime += elapsed;
+  if(elapsed > entry.stats.maxTime)
+    entry.stats.maxTime = elapsed;
+
+  if(!packet)
+    entry.stats.malformed++;
+  return true;
+}
+
+template <typename... Arguments>
+typename MessageDispatcher<Arguments...>::TypeStats MessageDispatcher<Arguments...>::getStats(sf::Int32 type) const
+{
+  if(type < 0 || static_cast<std::size_t>(type) >= entries.size())
+    return TypeStats();
+  return entries[type].stats;
+}
+
+template <typename... Arguments>
+sf::Uint64 MessageDispatcher<Arguments...>::getUnknown() const
+{
+  return unknown;
+}
+
+template <typename... Arguments>
+void MessageDispatcher<Arguments...>::print(std::ostream& out) const
+{
+  out << "  handlers: unknown=" << unknown << "\n";
+  for(std::size_t i=0; i<entries.size(); ++i)
+  {
+    const TypeStats& stats = entries[i].stats;
+    if(stats.handled == 0 && stats.rejected == 0)
+      continue;
+
+    sf::Int64 average = stats.totalTime.asMicroseconds() / static_cast<sf::Int64>(std::max<sf::Uint64>(1, stats.handled));
+    out << "    type " << i << ": " << stats.handled << " handled, "
+        << stats.rejected << " rejected, " << stats.malformed << " malformed, "
+        << average << "us avg, " << stats.maxTime.asMicroseconds() << "us max\n";
+  }
+}
+
+#endif
@@ -0,0 +1,257 @@
+#include "Mission.hpp"
+#include "AssetPack.hpp"
+#include "Foreach.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+  void write(std::vector<char>& output, sf::Uint32 value, std::size_t bytes)
+  {
+    for(std::size_t i=0; i<bytes; ++i)
+      output.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+
+  void write(std::vector<char>& output, float value)
+  {
+    sf::Uint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    write(output, bits, 4);
+  }
+}
+
+const char Mission::Magic[4] = { 'S', 'C', 'M', 'S' };
+
+Mission::Mission() :
+  data(nullptr),
+  size(0),
+  position(0),
+  file(),
+  height(0.f),
+  finish(0.f),
+  backgrounds(),
+  chunk(),
+  nextSpawn(0),
+  chunkPending(false),
+  pendingCount(0),
+  pendingDistance(0.f)
+{
+}
+
+bool Mission::loadFromFile(const std::string& filename)
+{
+  data = nullptr;
+  size = 0;
+  position = 0;
+  file.close();
+  backgrounds.clear();
+  chunk.clear();
+  nextSpawn = 0;
+  chunkPending = false;
+
+  const void* packed;
+  if(AssetPack::getInstance().find(filename, packed, size))
+  {
+    data = static_cast<const char*>(packed);
+  }
+  else
+  {
+    file.clear();
+    file.open(filename.c_str(), std::ios::binary);
+    if(!file)
+      return false;
+  }
+
+  if(!readHeader() || !readChunkHeader())
+  {
+    chunkPending = false;
+    return false;
+  }
+
+  return true;
+}
+
+bool Mission::isLoaded() const
+{
+  return data || file.is_open();
+}
+
+float Mission::getHeight() const
+{
+  return height;
+}
+
+float Mission::getFinish() const
+{
+  return finish;
+}
+
+const std::vector<Mission::Background>& Mission::getBackgrounds() const
+{
+  return backgrounds;
+}
+
+bool Mission::pollSpawn(float distance, Spawn& spawn)
+{
+  while(nextSpawn == chunk.size())
+  {
+    // The next chunk is read once the battlefield reaches its first spawn
+    if(!chunkPending || pendingDistance > distance)
+      return false;
+
+    readChunk();
+  }
+
+  if(chunk[nextSpawn].distance > distance)
+    return false;
+
+  spawn = chunk[nextSpawn++];
+  return true;
+}
+
+void Mission::encode(float height, float finish, std::vector<Background> backgrounds,
+    std::vector<Spawn> spawns, std::vector<char>& output)
+{
+  // Sorted here once, the game reads the timeline in order
+  std::stable_sort(backgrounds.begin(), backgrounds.end(),
+      [] (const Background& lhs, const Background& rhs)
+      {
+        return lhs.distance < rhs.distance;
+      });
+  std::stable_sort(spawns.begin(), spawns.end(),
+      [] (const Spawn& lhs, const Spawn& rhs)
+      {
+        return lhs.distance < rhs.distance;
+      });
+
+  output.assign(Magic, Magic + sizeof(Magic));
+  write(output, Version, 1);
+  write(output, height);
+  write(output, finish);
+
+  write(output, static_cast<sf::Uint32>(backgrounds.size()), 4);
+  FOREACH(const Background& background, backgrounds)
+  {
+    write(output, background.texture, 1);
+    write(output, background.distance);
+    write(output, background.length);
+  }
+
+  const std::size_t chunkSize = ChunkSize;
+  for(std::size_t first=0; first<spawns.size(); first+=chunkSize)
+  {
+    std::size_t count = std::min(chunkSize, spawns.size() - first);
+    write(output, static_cast<sf::Uint32>(count), 4);
+    write(output, spawns[first].distance);
+
+    for(std::size_t i=first; i<first+count; ++i)
+    {
+      write(output, spawns[i].type, 1);
+      write(output, spawns[i].x);
+      write(output, spawns[i].distance);
+    }
+  }
+}
+
+bool Mission::readBytes(char* buffer, std::size_t count)
+{
+  if(data)
+  {
+    if(count > size - position)
+      return false;
+
+    std::memcpy(buffer, data + position, count);
+    position += count;
+    return true;
+  }
+
+  return static_cast<bool>(file.read(buffer, count));
+}
+
+bool Mission::read(sf::Uint32& value, std::size_t bytes)
+{
+  char buffer[4];
+  if(!readBytes(buffer, bytes))
+    return false;
+
+  value = 0;
+  for(std::size_t i=0; i<bytes; ++i)
+    value |= static_cast<sf::Uint32>(static_cast<unsigned char>(buffer[i])) << (8 * i);
+  return true;
+}
+
+bool Mission::read(float& value)
+{
+  sf::Uint32 bits;
+  if(!read(bits, 4))
+    return false;
+
+  std::memcpy(&value, &bits, sizeof(value));
+  return true;
+}
+
+bool Mission::atEnd()
+{
+  if(data)
+    return position == size;
+
+  return file.peek() == std::ifstream::traits_type::eof();
+}
+
+bool Mission::readHeader()
+{
+  char magic[sizeof(Magic)];
+  sf::Uint32 version;
+  sf::Uint32 backgroundCount;
+  if(!readBytes(magic, sizeof(magic)) || std::memcmp(magic, Magic, sizeof(Magic)) != 0 ||
+      !read(version, 1) || version != Version ||
+      !read(height) || !read(finish) || !read(backgroundCount, 4))
+    return false;
+
+  for(sf::Uint32 i=0; i<backgroundCount; ++i)
+  {
+    sf::Uint32 texture;
+    Background background;
+    if(!read(texture, 1) || texture >= Textures::TextureCount ||
+        !read(background.distance) || !read(background.length))
+      return false;
+
+    background.texture = static_cast<Textures::ID>(texture);
+    backgrounds.push_back(background);
+  }
+
+  return true;
+}
+
+bool Mission::readChunkHeader()
+{
+  chunkPending = !atEnd();
+  if(!chunkPending)
+    return true;
+
+  return read(pendingCount, 4) && pendingCount <= ChunkSize && read(pendingDistance);
+}
+
+void Mission::readChunk()
+{
+  chunk.clear();
+  chunk.reserve(pendingCount);
+  nextSpawn = 0;
+
+  for(sf::Uint32 i=0; i<pendingCount; ++i)
+  {
+    sf::Uint32 type;
+    Spawn spawn;
+    if(!read(type, 1) || type >= Aircraft::TypeCount ||
+        !read(spawn.x) || !read(spawn.distance))
+      throw std::runtime_error("Mission::readChunk - Broken spawn timeline");
+
+    spawn.type = static_cast<Aircraft::Type>(type);
+    chunk.push_back(spawn);
+  }
+
+  if(!readChunkHeader())
+    throw std::runtime_error("Mission::readChunk - Broken spawn timeline");
+}
@@ -0,0 +1,96 @@
+#ifndef SOURCES_SCOUT_MISSION_HPP_
+#define SOURCES_SCOUT_MISSION_HPP_
+
+#include "Aircraft.hpp"
+#include "ResourceIdentifiers.hpp"
+
+#include <SFML/Config.hpp>
+#include <SFML/System/NonCopyable.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Level played by a local World: its height, the finish line, the
+// background segments and the enemy spawn timeline, compiled by the
+// missionc tool from a text source.
+//
+// Loading reads the header only. The compiler sorted the timeline and cut
+// it in chunks, which are read one at a time as the battlefield reaches
+// them, so a mission of any length keeps a single chunk in memory.
+//
+// File layout, little endian, floats stored as their bits:
+//   "SCMS" [Uint8:version] [float:height] [float:finish]
+//   [Uint32:backgroundCount]
+//   backgroundCount times: [Uint8:texture] [float:distance] [float:length]
+//   chunks up to the end of the file:
+//     [Uint32:spawnCount] [float:distance of the first spawn]
+//     spawnCount times: [Uint8:type] [float:x] [float:distance]
+// Distances are measured up from the player spawn position, x from the
+// middle of the world.
+class Mission : private sf::NonCopyable
+{
+  public:
+    static const char Magic[4];
+    static const sf::Uint8 Version = 1;
+    static const std::size_t ChunkSize = 64;
+
+    struct Spawn
+    {
+      Aircraft::Type type;
+      float x;
+      float distance;
+    };
+
+    struct Background
+    {
+      Textures::ID texture;
+      float distance;
+      float length;
+    };
+
+    Mission();
+
+    // From the AssetPack when it has the file
+    bool loadFromFile(const std::string& filename);
+    bool isLoaded() const;
+
+    float getHeight() const;
+    float getFinish() const;
+    const std::vector<Background>& getBackgrounds() const;
+
+    // Next spawn up to distance, in timeline order
+    bool pollSpawn(float distance, Spawn& spawn);
+
+    // Sorts the backgrounds and the timeline, then writes the file layout
+    static void encode(float height, float finish, std::vector<Background> backgrounds,
+        std::vector<Spawn> spawns, std::vector<char>& output);
+
+  private:
+    // Either the pack holds the file, or it is read from disk
+    const char* data;
+    std::size_t size;
+    std::size_t position;
+    std::ifstream file;
+
+    float height;
+    float finish;
+    std::vector<Background> backgrounds;
+
+    std::vector<Spawn> chunk;
+    std::size_t nextSpawn;
+    bool chunkPending;
+    sf::Uint32 pendingCount;
+    float pendingDistance;
+
+    bool readBytes(char* buffer, std::size_t count);
+    bool read(sf::Uint32& value, std::size_t bytes);
+    bool read(float& value);
+    bool atEnd();
+
+    bool readHeader();
+    bool readChunkHeader();
+    void readChunk();
+};
+
+#endif
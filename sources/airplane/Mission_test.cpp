@@ -0,0 +1,122 @@
+#include "Mission.hpp"
+#include "TestUtils.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+// Encodes a mission spanning several chunks, as missionc does, and streams
+// it back; a cut file must never yield the whole timeline.
+namespace
+{
+  const char* const MissionFile = "Mission_test.mission";
+  const std::size_t SpawnCount = Mission::ChunkSize * 2 + 22;
+
+  std::vector<Mission::Spawn> makeSpawns()
+  {
+    std::vector<Mission::Spawn> spawns;
+    for(std::size_t i=0; i<SpawnCount; ++i)
+    {
+      Mission::Spawn spawn;
+      spawn.type = (i % 3 == 0) ? Aircraft::Avenger : Aircraft::Raptor;
+      spawn.x = static_cast<float>(i % 5) * 70.f - 140.f;
+      spawn.distance = 500.f + static_cast<float>(i) * 25.f;
+      spawns.push_back(spawn);
+    }
+    return spawns;
+  }
+
+  std::vector<char> encode(const std::vector<Mission::Spawn>& spawns)
+  {
+    Mission::Background background;
+    background.texture = Textures::Jungle;
+    background.distance = -384.f;
+    background.length = 5768.f;
+
+    std::vector<char> contents;
+    Mission::encode(5000.f, 4616.f, std::vector<Mission::Background>(1, background), spawns, contents);
+    return contents;
+  }
+
+  bool save(const std::vector<char>& contents, std::size_t size)
+  {
+    std::ofstream file(MissionFile, std::ios::binary);
+    return static_cast<bool>(file.write(contents.data(), size));
+  }
+
+  // Polls the timeline the way World does, a little further every frame
+  std::vector<Mission::Spawn> streamAll(Mission& mission)
+  {
+    std::vector<Mission::Spawn> spawns;
+    for(float distance=0.f; distance<5000.f; distance+=10.f)
+    {
+      Mission::Spawn spawn;
+      while(mission.pollSpawn(distance, spawn))
+        spawns.push_back(spawn);
+    }
+    return spawns;
+  }
+
+  bool equal(const std::vector<Mission::Spawn>& lhs, const std::vector<Mission::Spawn>& rhs)
+  {
+    if(lhs.size() != rhs.size())
+      return false;
+
+    for(std::size_t i=0; i<lhs.size(); ++i)
+    {
+      if(lhs[i].type != rhs[i].type || lhs[i].x != rhs[i].x || lhs[i].distance != rhs[i].distance)
+        return false;
+    }
+    return true;
+  }
+}
+
+int main()
+{
+  std::vector<Mission::Spawn> spawns = makeSpawns();
+  std::vector<char> contents = encode(spawns);
+
+  Mission mission;
+  check(save(contents, contents.size()) && mission.loadFromFile(MissionFile), "mission loads");
+  check(mission.getHeight() == 5000.f && mission.getFinish() == 4616.f, "header survives the round trip");
+  check(mission.getBackgrounds().size() == 1 &&
+      mission.getBackgrounds()[0].texture == Textures::Jungle &&
+      mission.getBackgrounds()[0].distance == -384.f &&
+      mission.getBackgrounds()[0].length == 5768.f, "backgrounds survive the round trip");
+  check(equal(streamAll(mission), spawns), "spawns come back in order across chunks");
+
+  // encode() sorts the timeline, statements may come in any order
+  std::vector<Mission::Spawn> reversed(spawns.rbegin(), spawns.rend());
+  Mission sorted;
+  check(save(encode(reversed), contents.size()) && sorted.loadFromFile(MissionFile) &&
+      equal(streamAll(sorted), spawns), "the timeline is sorted when encoded");
+
+  // Cut anywhere, the mission fails to load, throws while streaming or ends
+  // early at a chunk boundary
+  bool rejectsTruncated = true;
+  for(std::size_t size=0; size<contents.size(); ++size)
+  {
+    Mission truncated;
+    if(!save(contents, size) || !truncated.loadFromFile(MissionFile))
+      continue;
+
+    try
+    {
+      if(streamAll(truncated).size() == spawns.size())
+        rejectsTruncated = false;
+    }
+    catch(std::runtime_error&)
+    {
+    }
+  }
+  check(rejectsTruncated, "truncated missions never yield every spawn");
+
+  std::vector<char> wrongVersion(contents);
+  wrongVersion[sizeof(Mission::Magic)] = static_cast<char>(Mission::Version + 1);
+  Mission versioned;
+  check(save(wrongVersion, wrongVersion.size()) && !versioned.loadFromFile(MissionFile), "other versions are rejected");
+
+  std::remove(MissionFile);
+  return testResult();
+}
@@ -1,20 +1,52 @@
 #include "MultiplayerGameState.hpp"
 #include "Foreach.hpp"
 #include "MusicPlayer.hpp"
+#include "TcpConnection.hpp"
 #include "WindowUtils.hpp"
 
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Network/IpAddress.hpp>
 
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
+#include <functional>
+#include <iostream>
 
-sf::IpAddress getAddressFromFile()
+// For std::bind() placeholders _1, _2, ...
+using namespace std::placeholders;
+
+namespace
+{
+  // Connection attempts: each may take ConnectAttemptTimeout, the pause
+  // between them doubles from FirstRetryDelay up to MaxRetryDelay
+  const std::size_t MaxConnectAttempts = 6;
+  const sf::Time ConnectAttemptTimeout = sf::seconds(1.f);
+  const sf::Time FirstRetryDelay = sf::milliseconds(250);
+  const sf::Time MaxRetryDelay = sf::seconds(2.f);
+
+  // Time the server has to answer a hello
+  const sf::Time HandshakeTimeout = sf::seconds(5.f);
+}
+
+// The file holds "address" or "address:port" (e.g. to go through netproxy)
+sf::IpAddress getAddressFromFile(unsigned short& port)
 {
+  port = serverPort;
+
   { // Try to open existing file (RAII block)
     std::ifstream inputFile("assets/config/ip.txt");
     std::string ipAddress;
     if(inputFile >> ipAddress)
+    {
+      std::string::size_type separator = ipAddress.find(':');
+      if(separator != std::string::npos)
+      {
+        port = static_cast<unsigned short>(std::atoi(ipAddress.c_str() + separator + 1));
+        ipAddress.erase(separator);
+      }
       return ipAddress;
+    }
   }
 
   // If open/read failed, create new file
@@ -24,16 +56,58 @@ sf::IpAddress getAddressFromFile()
   return localAddress;
 }
 
-MultiplayerGameState::MultiplayerGameState(StateStack& stack, Context context, bool isHost) :
+// Capturing is enabled by putting a file prefix in assets/config/capture.txt
+std::string getCapturePrefixFromFile()
+{
+  std::ifstream inputFile("assets/config/capture.txt");
+  std::string prefix;
+  inputFile >> prefix;
+  return prefix;
+}
+
+// Periodic statistics dumps are enabled by putting an interval in seconds in
+// assets/config/stats.txt, for the client and the server it hosts
+sf::Time getStatsDumpIntervalFromFile()
+{
+  std::ifstream inputFile("assets/config/stats.txt");
+  float seconds = 0.f;
+  inputFile >> seconds;
+  return sf::seconds(std::max(seconds, 0.f));
+}
+
+MultiplayerGameState::MultiplayerGameState(StateStack& stack, Context context, Role role) :
   State(stack, context),
-  world(*context.target, *context.fonts, *context.sounds, true),
+  world(new World(*context.target, *context.fonts, *context.sounds, true)),
   target(*context.target),
   textures(*context.textures),
-  connected(false),
+  recorder(),
+  connection(),
+  serverSocket(nullptr),
+  serverAddress(),
+  targetPort(serverPort),
+  phase(Connecting),
+  connectAttempts(0),
+  attemptActive(false),
+  resumeSession(false),
+  connectClock(),
+  attemptDeadline(sf::Time::Zero),
+  nextAttemptTime(sf::Time::Zero),
+  handshakeDeadline(sf::Time::Zero),
+  negotiatedVersion(0),
   gameServer(nullptr),
+  joinStreamReader(),
+  dispatcher(),
+  clockSync(),
+  syncClock(),
+  nextSyncRequestTime(sf::Time::Zero),
+  serverTimeKnown(false),
+  sessionToken(0),
+  statsDumpInterval(getStatsDumpIntervalFromFile()),
+  statsDumpClock(),
   activeState(true),
   hasFocus(true),
-  host(isHost),
+  host(role == Hosting),
+  spectator(role == Spectating),
   gameStarted(false),
   clientTimeout(sf::seconds(2.f)),
   timeSinceLastPacket(sf::seconds(0.f))
@@ -48,38 +122,53 @@ MultiplayerGameState::MultiplayerGameState(StateStack& stack, Context context, b
   playerInvitationText.setString("Press Enter to spawn player 2");
   playerInvitationText.setPosition(1000 - playerInvitationText.getLocalBounds().width, 760 - playerInvitationText.getLocalBounds().height);
 
-  // We reuse this text for "Attempt to connect" and "Failed to connect" messages
+  // We reuse this text for the connection progress and "Failed to connect"
+  // messages
   failedConnectionText.setFont(font);
-  failedConnectionText.setString("Attempting to connect...");
   failedConnectionText.setCharacterSize(35);
   failedConnectionText.setColor(sf::Color::White);
-  centerOrigin(failedConnectionText);
   failedConnectionText.setPosition(target.getSize().x / 2.f, target.getSize().y / 2.f);
+  setStatusText("Attempting to connect...");
 
-  // Render a "establishing connection" frame for user feedback
-  target.clear(sf::Color::Black);
-  target.draw(failedConnectionText);
-  //target.display();
-  failedConnectionText.setString("Could not connect to the remote server!");
-  centerOrigin(failedConnectionText);
+  registerHandlers();
 
-  sf::IpAddress ip;
-  if(isHost)
+  std::string capturePrefix = getCapturePrefixFromFile();
+  if(host)
   {
-    gameServer.reset(new GameServer(sf::Vector2f(target.getSize())));
-    ip = "127.0.0.1";
+    // The host talks to its own server through in-process queues
+    GameServer::Settings settings;
+    settings.battlefieldSize = sf::Vector2f(target.getSize());
+    settings.statsDumpInterval = statsDumpInterval;
+    if(!capturePrefix.empty())
+      settings.captureFile = capturePrefix + "_server.scpk";
+
+    gameServer.reset(new GameServer(settings));
+    connection = gameServer->connectLocal();
   }
   else
   {
-    ip = getAddressFromFile();
+    std::unique_ptr<TcpConnection> tcpConnection(new TcpConnection());
+    serverAddress = getAddressFromFile(targetPort);
+
+    // Spectators have a port of their own on the same server
+    if(spectator)
+      targetPort = spectatorPort;
+
+    // The connect is started by update(), the window keeps responding
+    tcpConnection->getSocket().setBlocking(false);
+    serverSocket = &tcpConnection->getSocket();
+    connection = std::move(tcpConnection);
   }
 
-  if(socket.connect(ip, serverPort, sf::seconds(5.f)) == sf::TcpSocket::Done)
-    connected = true;
-  else
-    failedConnectionClock.restart();
+  if(!capturePrefix.empty() &&
+      recorder.open(capturePrefix + "_client.scpk", PacketLog::ClientSide))
+    connection->setRecorder(&recorder, 0);
 
-  socket.setBlocking(false);
+  // Nothing to connect for the host, it says hello right away
+  if(host)
+    onConnected();
+  else
+    startConnecting();
 
   // Play game theme
   //context.music->play(Music::MissionTheme);
@@ -87,9 +176,10 @@ MultiplayerGameState::MultiplayerGameState(StateStack& stack, Context context, b
 
 void MultiplayerGameState::draw()
 {
-  if(connected)
+  // A match being reconnected stays visible behind the progress
+  if(phase == Playing || gameStarted)
   {
-    world.draw();
+    world->draw();
 
     // Broadcast messages in default view
     target.setView(target.getDefaultView());
@@ -97,13 +187,12 @@ void MultiplayerGameState::draw()
     if(!broadcasts.empty())
       target.draw(broadcastText);
 
-    if(localPlayerIdentifiers.size() < 2 && playerInvitationTime < sf::seconds(0.5f))
+    if(!spectator && localPlayerIdentifiers.size() < 2 && playerInvitationTime < sf::seconds(0.5f))
       target.draw(playerInvitationText);
   }
-  else
-  {
+
+  if(phase != Playing)
     target.draw(failedConnectionText);
-  }
 }
 
 void MultiplayerGameState::onActivate()
@@ -113,21 +202,30 @@ void MultiplayerGameState::onActivate()
 
 void MultiplayerGameState::onDestroy()
 {
-  if(!host && connected)
+  if(!host && phase == Playing)
   {
     // Inform server this client is dying
     sf::Packet packet;
     packet << static_cast<sf::Int32>(Client::Quit);
-    socket.send(packet);
+    connection->send(packet);
   }
 }
 
 bool MultiplayerGameState::update(sf::Time dt)
 {
   // Connected to server: Handle all the network logic
-  if(connected)
+  if(phase == Connecting || phase == Handshaking)
+  {
+    // The world waits until the match is (back) on
+    updateConnection();
+  }
+  else if(phase == Playing)
   {
-    world.update(dt);
+    // The battlefield position follows the synchronized server clock
+    if(serverTimeKnown)
+      world->setBattleFieldTime(clockSync.getServerTime(syncClock.getElapsedTime()));
+
+    world->update(dt);
 
     // Remove players whose aircrafts were destroyed
     bool foundLocalPlane = false;
@@ -140,7 +238,7 @@ bool MultiplayerGameState::update(sf::Time dt)
         foundLocalPlane = true;
       }
 
-      if(!world.getAircraft(itr->first))
+      if(!world->getAircraft(itr->first))
       {
         if(foundLocalPlane)
           localPlayerIdentifiers.erase(itrLocal);
@@ -163,7 +261,7 @@ bool MultiplayerGameState::update(sf::Time dt)
 
     // Only handle the realtime input if the window has focus and the game is
     // unpaused
-    CommandQueue& commands = world.getCommandQueue();
+    CommandQueue& commands = world->getCommandQueue();
     if(activeState && hasFocus)
     {
       FOREACH(auto& pair, players)
@@ -174,27 +272,24 @@ bool MultiplayerGameState::update(sf::Time dt)
     FOREACH(auto& pair, players)
       pair.second->handleRealtimeNetworkInput(commands);
 
-    // Handle messages from server that may have arrived
+    // Handle all messages from server that may have arrived; a server or
+    // spectator frame often carries several per tick
     sf::Packet packet;
-    if(socket.receive(packet) == sf::Socket::Done)
+    bool receivedAny = false;
+    while(phase == Playing && connection->receive(packet) == sf::Socket::Done)
     {
+      connection->getStats().recordSilence(timeSinceLastPacket, clientTimeout);
       timeSinceLastPacket = sf::seconds(0.f);
-      sf::Int32 packetType;
-      packet >> packetType;
-      handlePacket(packetType, packet);
+      receivedAny = true;
+
+      dispatcher.dispatch(packet);
     }
-    else
+
+    if(!receivedAny)
     {
       // Check for timeout with the server
       if(timeSinceLastPacket > clientTimeout)
-      {
-        connected = false;
-
-        failedConnectionText.setString("Lost connection to server");
-        centerOrigin(failedConnectionText);
-
-        failedConnectionClock.restart();
-      }
+        failConnection("Lost connection to server");
     }
 
     updateBroadcastMessage(dt);
@@ -206,19 +301,23 @@ bool MultiplayerGameState::update(sf::Time dt)
 
     // Events occurring in the game
     GameActions::Action gameAction;
-    while(world.pollGameAction(gameAction))
+    while(world->pollGameAction(gameAction))
     {
+      // Spectators only watch, the players report what happens
+      if(spectator)
+        continue;
+
       sf::Packet packet;
       packet << static_cast<sf::Int32>(Client::GameEvent);
       packet << static_cast<sf::Int32>(gameAction.type);
       packet << gameAction.position.x;
       packet << gameAction.position.y;
 
-      socket.send(packet);
+      connection->send(packet);
     }
 
     // Regular position updates
-    if(tickClock.getElapsedTime() > sf::seconds(1.f / 20.f))
+    if(!spectator && tickClock.getElapsedTime() > sf::seconds(1.f / 20.f))
     {
       sf::Packet positionUpdatePacket;
       positionUpdatePacket << static_cast<sf::Int32>(Client::PositionUpdate);
@@ -226,7 +325,7 @@ bool MultiplayerGameState::update(sf::Time dt)
 
       FOREACH(sf::Int32 identifier, localPlayerIdentifiers)
       {
-        if(Aircraft* aircraft = world.getAircraft(identifier))
+        if(Aircraft* aircraft = world->getAircraft(identifier))
         {
           positionUpdatePacket << identifier;
           positionUpdatePacket << aircraft->getPosition().x;
@@ -236,10 +335,29 @@ bool MultiplayerGameState::update(sf::Time dt)
         }
       }
 
-      socket.send(positionUpdatePacket);
+      connection->send(positionUpdatePacket);
       tickClock.restart();
     }
 
+    // Clock synchronization requests, frequent until the estimate settles
+    if(syncClock.getElapsedTime() >= nextSyncRequestTime)
+    {
+      sf::Packet syncRequestPacket;
+      syncRequestPacket << static_cast<sf::Int32>(Client::ClockSyncRequest);
+      syncRequestPacket << syncClock.getElapsedTime().asMilliseconds();
+
+      connection->send(syncRequestPacket);
+      nextSyncRequestTime = syncClock.getElapsedTime() + clockSync.getRequestInterval();
+    }
+
+    // Periodic statistics dump, if enabled
+    if(statsDumpInterval != sf::Time::Zero &&
+        statsDumpClock.getElapsedTime() >= statsDumpInterval)
+    {
+      dumpNetworkStats();
+      statsDumpClock.restart();
+    }
+
     timeSinceLastPacket += dt;
   }
   else if(failedConnectionClock.getElapsedTime() >= sf::seconds(5.f))
@@ -251,6 +369,145 @@ bool MultiplayerGameState::update(sf::Time dt)
   return true;
 }
 
+const NetworkStats& MultiplayerGameState::getNetworkStats() const
+{
+  return connection->getStats();
+}
+
+void MultiplayerGameState::dumpNetworkStats() const
+{
+  std::cout << "Client stats (server connection)\n";
+  connection->getStats().print(std::cout);
+  dispatcher.print(std::cout);
+  std::cout << std::flush;
+}
+
+void MultiplayerGameState::setStatusText(const std::string& text)
+{
+  failedConnectionText.setString(text);
+  centerOrigin(failedConnectionText);
+}
+
+// (Re)connects the same connection object, so after a migration or redirect
+// the players, statistics and capture carry on
+void MultiplayerGameState::startConnecting()
+{
+  serverSocket->disconnect();
+  phase = Connecting;
+  connectAttempts = 0;
+  attemptActive = false;
+  nextAttemptTime = connectClock.getElapsedTime();
+}
+
+void MultiplayerGameState::updateConnection()
+{
+  sf::Time now = connectClock.getElapsedTime();
+
+  if(phase == Connecting)
+  {
+    if(!attemptActive)
+    {
+      if(now < nextAttemptTime)
+        return;
+
+      // Non-blocking, this only starts the connect; it is done once the
+      // socket has a peer
+      serverSocket->connect(serverAddress, targetPort);
+      attemptActive = true;
+      attemptDeadline = now + ConnectAttemptTimeout;
+      connectAttempts++;
+
+      if(connectAttempts > 1)
+        setStatusText("Attempting to connect... (try " + std::to_string(connectAttempts) + ")");
+    }
+
+    if(serverSocket->getRemotePort() != 0)
+    {
+      attemptActive = false;
+      onConnected();
+    }
+    else if(now >= attemptDeadline)
+    {
+      serverSocket->disconnect();
+      attemptActive = false;
+
+      if(connectAttempts >= MaxConnectAttempts)
+      {
+        failConnection(gameStarted ? "Lost connection to server" : "Could not connect to the remote server!");
+      }
+      else
+      {
+        sf::Time delay = FirstRetryDelay * static_cast<float>(1u << (connectAttempts - 1));
+        nextAttemptTime = now + std::min(delay, MaxRetryDelay);
+      }
+    }
+  }
+  else if(phase == Handshaking)
+  {
+    // Welcome, Reject or a gateway's Redirect move on from here
+    sf::Packet packet;
+    while(phase == Handshaking && connection->receive(packet) == sf::Socket::Done)
+      dispatcher.dispatch(packet);
+
+    if(phase == Handshaking && now >= handshakeDeadline)
+      failConnection("The server did not answer");
+  }
+}
+
+void MultiplayerGameState::onConnected()
+{
+  if(resumeSession)
+  {
+    // The server resuming a migrated match knows us by our token, the
+    // protocol version was agreed on with the previous one
+    sf::Packet packet;
+    packet << static_cast<sf::Int32>(Client::Resume);
+    packet << static_cast<sf::Uint32>(sessionToken >> 32);
+    packet << static_cast<sf::Uint32>(sessionToken);
+    connection->send(packet);
+
+    // Playing again once the server accepts the session
+    phase = Handshaking;
+    handshakeDeadline = connectClock.getElapsedTime() + HandshakeTimeout;
+    setStatusText("Resuming...");
+    return;
+  }
+
+  sf::Packet packet;
+  packet << static_cast<sf::Int32>(Client::Hello);
+  packet << minimumProtocolVersion;
+  packet << protocolVersion;
+  connection->send(packet);
+
+  phase = Handshaking;
+  handshakeDeadline = connectClock.getElapsedTime() + HandshakeTimeout;
+  setStatusText("Joining...");
+}
+
+void MultiplayerGameState::failConnection(const std::string& reason)
+{
+  phase = Failed;
+  setStatusText(reason);
+  failedConnectionClock.restart();
+}
+
+// Drops everything learned from the previous server, the next join stream
+// rebuilds it
+void MultiplayerGameState::resetMatch()
+{
+  players.clear();
+  localPlayerIdentifiers.clear();
+  joinStreamReader = JoinStreamReader();
+  clockSync = ClockSync();
+  serverTimeKnown = false;
+  sessionToken = 0;
+  broadcasts.clear();
+  gameStarted = false;
+
+  const Context context = getContext();
+  world.reset(new World(*context.target, *context.fonts, *context.sounds, true));
+}
+
 void MultiplayerGameState::disableAllRealtimeActions()
 {
   activeState = false;
@@ -262,7 +519,7 @@ void MultiplayerGameState::disableAllRealtimeActions()
 bool MultiplayerGameState::handleEvent(const sf::Event& event)
 {
   // Game input handling
-  CommandQueue& commands = world.getCommandQueue();
+  CommandQueue& commands = world->getCommandQueue();
 
   // Forward event to all players
   FOREACH(auto& pair, players)
@@ -276,9 +533,13 @@ bool MultiplayerGameState::handleEvent(const sf::Event& event)
       sf::Packet packet;
       packet << static_cast<sf::Int32>(Client::RequestCoopPartner);
 
-      socket.send(packet);
+      connection->send(packet);
     }
 
+    // F3 pressed, dump the connection statistics
+    if(event.key.code == sf::Keyboard::F3)
+      dumpNetworkStats();
+
     // Escape pressed, trigger the pause screen
     if(event.key.code == sf::Keyboard::Escape)
     {
@@ -320,208 +581,329 @@ void MultiplayerGameState::updateBroadcastMessage(sf::Time elapsedTime)
   }
 }
 
-void MultiplayerGameState::handlePacket(sf::Int32 packetType, sf::Packet& packet)
+// Payload sizes are what each handler reads at least
+void MultiplayerGameState::registerHandlers()
 {
-  switch(packetType)
+  dispatcher.registerHandler(Server::BroadcastMessage, 4, std::bind(&MultiplayerGameState::handleBroadcastMessage, this, _1));
+  dispatcher.registerHandler(Server::SpawnSelf, 12, std::bind(&MultiplayerGameState::handleSpawnSelf, this, _1));
+  dispatcher.registerHandler(Server::PlayerConnect, 12, std::bind(&MultiplayerGameState::handlePlayerConnect, this, _1));
+  dispatcher.registerHandler(Server::PlayerDisconnect, 4, std::bind(&MultiplayerGameState::handlePlayerDisconnect, this, _1));
+  dispatcher.registerHandler(Server::InitialState, 12, std::bind(&MultiplayerGameState::handleInitialState, this, _1));
+  dispatcher.registerHandler(Server::InitialAircraft, 4, std::bind(&MultiplayerGameState::handleInitialAircraft, this, _1));
+  dispatcher.registerHandler(Server::JoinStateChunk, 20, std::bind(&MultiplayerGameState::handleJoinStateChunk, this, _1));
+  dispatcher.registerHandler(Server::AcceptCoopPartner, 4, std::bind(&MultiplayerGameState::handleAcceptCoopPartner, this, _1));
+  dispatcher.registerHandler(Server::PlayerEvent, 8, std::bind(&MultiplayerGameState::handlePlayerEvent, this, _1));
+  dispatcher.registerHandler(Server::PlayerRealtimeChange, 9, std::bind(&MultiplayerGameState::handlePlayerRealtimeChange, this, _1));
+  dispatcher.registerHandler(Server::SpawnEnemy, 12, std::bind(&MultiplayerGameState::handleSpawnEnemy, this, _1));
+  dispatcher.registerHandler(Server::MissionSuccess, 0, std::bind(&MultiplayerGameState::handleMissionSuccess, this, _1));
+  dispatcher.registerHandler(Server::SpawnPickup, 12, std::bind(&MultiplayerGameState::handleSpawnPickup, this, _1));
+  dispatcher.registerHandler(Server::UpdateClientState, 4, std::bind(&MultiplayerGameState::handleUpdateClientState, this, _1));
+  dispatcher.registerHandler(Server::ClockSyncResponse, 8, std::bind(&MultiplayerGameState::handleClockSyncResponse, this, _1));
+  dispatcher.registerHandler(Server::SessionToken, 8, std::bind(&MultiplayerGameState::handleSessionToken, this, _1));
+  dispatcher.registerHandler(Server::Migrate, 2, std::bind(&MultiplayerGameState::handleMigrate, this, _1));
+  dispatcher.registerHandler(Server::Redirect, 6, std::bind(&MultiplayerGameState::handleRedirect, this, _1));
+  dispatcher.registerHandler(Server::Ping, 4, std::bind(&MultiplayerGameState::handlePing, this, _1));
+  dispatcher.registerHandler(Server::Welcome, 4, std::bind(&MultiplayerGameState::handleWelcome, this, _1));
+  dispatcher.registerHandler(Server::Reject, 4, std::bind(&MultiplayerGameState::handleReject, this, _1));
+  dispatcher.registerHandler(Server::ResumeAccepted, 0, std::bind(&MultiplayerGameState::handleResumeAccepted, this, _1));
+}
+
+// Send message to call clients
+void MultiplayerGameState::handleBroadcastMessage(sf::Packet& packet)
+{
+  std::string message;
+  packet >> message;
+  broadcasts.push_back(message);
+
+  // Just added first message, display immediately
+  if(broadcasts.size() == 1)
   {
-    // Send message to call clients
-    case Server::BroadcastMessage:
-      {
-        std::string message;
-        packet >> message;
-        broadcasts.push_back(message);
+    broadcastText.setString(broadcasts.front());
+    centerOrigin(broadcastText);
+    broadcastElapsedTime = sf::Time::Zero;
+  }
+}
 
-        // Just added first message, display immediately
-        if(broadcasts.size() == 1)
-        {
-          broadcastText.setString(broadcasts.front());
-          centerOrigin(broadcastText);
-          broadcastElapsedTime = sf::Time::Zero;
-        }
-      }
-      break;
+// Sent by the server to order to spawn player 1 airplane on connect
+void MultiplayerGameState::handleSpawnSelf(sf::Packet& packet)
+{
+  sf::Int32 aircraftIdentifier;
+  sf::Vector2f aircraftPosition;
+  packet >> aircraftIdentifier;
+  packet >> aircraftPosition.x;
+  packet >> aircraftPosition.y;
 
-    // Sent by the server to order to spawn player 1 airplane on connect
-    case Server::SpawnSelf:
-      {
-        sf::Int32 aircraftIdentifier;
-        sf::Vector2f aircraftPosition;
-        packet >> aircraftIdentifier;
-        packet >> aircraftPosition.x;
-        packet >> aircraftPosition.y;
+  Aircraft* aircraft = world->addAircraft(aircraftIdentifier);
+  aircraft->setPosition(aircraftPosition);
 
-        Aircraft* aircraft = world.addAircraft(aircraftIdentifier);
-        aircraft->setPosition(aircraftPosition);
+  players[aircraftIdentifier].reset(new Player(connection.get(), aircraftIdentifier, getContext().keys1));
+  localPlayerIdentifiers.push_back(aircraftIdentifier);
 
-        players[aircraftIdentifier].reset(new Player(&socket, aircraftIdentifier, getContext().keys1));
-        localPlayerIdentifiers.push_back(aircraftIdentifier);
+  gameStarted = true;
+}
 
-        gameStarted = true;
-      }
-      break;
+void MultiplayerGameState::handlePlayerConnect(sf::Packet& packet)
+{
+  sf::Int32 aircraftIdentifier;
+  sf::Vector2f aircraftPosition;
+  packet >> aircraftIdentifier;
+  packet >> aircraftPosition.x;
+  packet >> aircraftPosition.y;
 
-    //
-    case Server::PlayerConnect:
-      {
-        sf::Int32 aircraftIdentifier;
-        sf::Vector2f aircraftPosition;
-        packet >> aircraftIdentifier;
-        packet >> aircraftPosition.x;
-        packet >> aircraftPosition.y;
+  Aircraft* aircraft = world->addAircraft(aircraftIdentifier);
+  aircraft->setPosition(aircraftPosition);
 
-        Aircraft* aircraft = world.addAircraft(aircraftIdentifier);
-        aircraft->setPosition(aircraftPosition);
+  players[aircraftIdentifier].reset(new Player(connection.get(), aircraftIdentifier, nullptr));
+}
 
-        players[aircraftIdentifier].reset(new Player(&socket, aircraftIdentifier, nullptr));
-      }
-      break;
+void MultiplayerGameState::handlePlayerDisconnect(sf::Packet& packet)
+{
+  sf::Int32 aircraftIdentifier;
+  packet >> aircraftIdentifier;
 
-    //
-    case Server::PlayerDisconnect:
-      {
-        sf::Int32 aircraftIdentifier;
-        packet >> aircraftIdentifier;
+  world->removeAircraft(aircraftIdentifier);
+  players.erase(aircraftIdentifier);
+}
 
-        world.removeAircraft(aircraftIdentifier);
-        players.erase(aircraftIdentifier);
-      }
+void MultiplayerGameState::handleInitialState(sf::Packet& packet)
+{
+  float worldHeight, currentScroll;
+  sf::Int32 serverTime;
+  packet >> worldHeight >> currentScroll >> serverTime;
+
+  world->setWorldHeight(worldHeight);
+  world->setCurrentBattleFieldPosition(currentScroll);
+
+  // Coarse clock estimate until the first synchronization response; a
+  // synchronization response may already have overtaken the join stream
+  if(!clockSync.isSynchronized())
+    clockSync.reset(sf::milliseconds(serverTime), syncClock.getElapsedTime());
+  serverTimeKnown = true;
+}
+
+// Aircraft already in game when joining
+void MultiplayerGameState::handleInitialAircraft(sf::Packet& packet)
+{
+  sf::Int32 aircraftCount;
+  packet >> aircraftCount;
+  for(sf::Int32 i=0; i<aircraftCount; ++i)
+  {
+    sf::Int32 aircraftIdentifier;
+    sf::Int32 hitpoints;
+    sf::Int32 missileAmmo;
+    sf::Vector2f aircraftPosition;
+
+    packet >> aircraftIdentifier;
+    packet >> aircraftPosition.x;
+    packet >> aircraftPosition.y;
+    packet >> hitpoints;
+    packet >> missileAmmo;
+    if(!packet)
       break;
 
-    //
-    case Server::InitialState:
-      {
-        float worldHeight, currentScroll;
-        packet >> worldHeight >> currentScroll;
+    Aircraft* aircraft = world->addAircraft(aircraftIdentifier);
+    aircraft->setPosition(aircraftPosition);
+    aircraft->setHitpoints(hitpoints);
+    aircraft->setMissileAmmo(missileAmmo);
 
-        world.setWorldHeight(worldHeight);
-        world.setCurrentBattleFieldPosition(currentScroll);
+    players[aircraftIdentifier].reset(new Player(connection.get(), aircraftIdentifier, nullptr));
+  }
+}
 
-        sf::Int32 aircraftCount;
-        packet >> aircraftCount;
-        for(sf::Int32 i=0; i<aircraftCount; ++i)
-        {
-          sf::Int32 aircraftIdentifier;
-          sf::Int32 hitpoints;
-          sf::Int32 missileAmmo;
-          sf::Vector2f aircraftPosition;
-
-          packet >> aircraftIdentifier;
-          packet >> aircraftPosition.x;
-          packet >> aircraftPosition.y;
-          packet >> hitpoints;
-          packet >> missileAmmo;
-
-          Aircraft* aircraft = world.addAircraft(aircraftIdentifier);
-          aircraft->setPosition(aircraftPosition);
-          aircraft->setHitpoints(hitpoints);
-          aircraft->setMissileAmmo(missileAmmo);
-
-          players[aircraftIdentifier].reset(new Player(&socket, aircraftIdentifier, nullptr));
-        }
-      }
-      break;
+// Piece of the join state, handled as a regular message once complete
+void MultiplayerGameState::handleJoinStateChunk(sf::Packet& packet)
+{
+  sf::Packet message;
+  if(joinStreamReader.addChunk(packet, message))
+    dispatcher.dispatch(message);
+}
 
-    //
-    case Server::AcceptCoopPartner:
-      {
-        sf::Int32 aircraftIdentifier;
-        packet >> aircraftIdentifier;
+void MultiplayerGameState::handleAcceptCoopPartner(sf::Packet& packet)
+{
+  sf::Int32 aircraftIdentifier;
+  packet >> aircraftIdentifier;
 
-        world.addAircraft(aircraftIdentifier);
-        players[aircraftIdentifier].reset(new Player(&socket, aircraftIdentifier, getContext().keys2));
-        localPlayerIdentifiers.push_back(aircraftIdentifier);
-      }
-      break;
+  world->addAircraft(aircraftIdentifier);
+  players[aircraftIdentifier].reset(new Player(connection.get(), aircraftIdentifier, getContext().keys2));
+  localPlayerIdentifiers.push_back(aircraftIdentifier);
+}
 
-    // Player event (like missile fired) occurs
-    case Server::PlayerEvent:
-      {
-        sf::Int32 aircraftIdentifier;
-        sf::Int32 action;
-        packet >> aircraftIdentifier >> action;
+// Player event (like missile fired) occurs
+void MultiplayerGameState::handlePlayerEvent(sf::Packet& packet)
+{
+  sf::Int32 aircraftIdentifier;
+  sf::Int32 action;
+  packet >> aircraftIdentifier >> action;
 
-        auto itr = players.find(aircraftIdentifier);
-        if(itr != players.end())
-          itr->second->handleNetworkEvent(static_cast<PlayerActions::Action>(action), world.getCommandQueue());
-      }
-      break;
+  auto itr = players.find(aircraftIdentifier);
+  if(itr != players.end())
+    itr->second->handleNetworkEvent(static_cast<PlayerActions::Action>(action), world->getCommandQueue());
+}
 
-    // Player's movement or fire keyboard state changes
-    case Server::PlayerRealtimeChange:
-      {
-        sf::Int32 aircraftIdentifier;
-        sf::Int32 action;
-        bool actionEnabled;
-        packet >> aircraftIdentifier >> action >> actionEnabled;
-
-        auto itr = players.find(aircraftIdentifier);
-        if(itr != players.end())
-          itr->second->handleNetworkRealtimeChange(static_cast<PlayerActions::Action>(action), actionEnabled);
-      }
-      break;
+// Player's movement or fire keyboard state changes
+void MultiplayerGameState::handlePlayerRealtimeChange(sf::Packet& packet)
+{
+  sf::Int32 aircraftIdentifier;
+  sf::Int32 action;
+  bool actionEnabled;
+  packet >> aircraftIdentifier >> action >> actionEnabled;
+
+  auto itr = players.find(aircraftIdentifier);
+  if(itr != players.end())
+    itr->second->handleNetworkRealtimeChange(static_cast<PlayerActions::Action>(action), actionEnabled);
+}
 
-    // New enemy to be created
-    case Server::SpawnEnemy:
-      {
-        float height;
-        sf::Int32 type;
-        float relativeX;
-        packet >> type >> height >> relativeX;
+// New enemy to be created
+void MultiplayerGameState::handleSpawnEnemy(sf::Packet& packet)
+{
+  float height;
+  sf::Int32 type;
+  float relativeX;
+  packet >> type >> height >> relativeX;
 
-        world.addEnemy(static_cast<Aircraft::Type>(type), relativeX, height);
-        world.sortEnemies();
-      }
-      break;
+  world->addEnemy(static_cast<Aircraft::Type>(type), relativeX, height);
+}
 
-    // Mission successfully completed
-    case Server::MissionSuccess:
-      {
-        requestStackPush(States::MissionSuccess);
-      }
-      break;
+// Mission successfully completed
+void MultiplayerGameState::handleMissionSuccess(sf::Packet&)
+{
+  requestStackPush(States::MissionSuccess);
+}
 
-    // Pickup created
-    case Server::SpawnPickup:
-      {
-        sf::Int32 type;
-        sf::Vector2f position;
-        packet >> type >> position.x >> position.y;
+// Pickup created
+void MultiplayerGameState::handleSpawnPickup(sf::Packet& packet)
+{
+  sf::Int32 type;
+  sf::Vector2f position;
+  packet >> type >> position.x >> position.y;
 
-        world.createPickup(position, static_cast<Pickup::Type>(type));
-      }
+  world->createPickup(position, static_cast<Pickup::Type>(type));
+}
+
+void MultiplayerGameState::handleUpdateClientState(sf::Packet& packet)
+{
+  sf::Int32 aircraftCount;
+  packet >> aircraftCount;
+
+  for(sf::Int32 i=0; i<aircraftCount; ++i)
+  {
+    sf::Vector2f aircraftPosition;
+    sf::Int32 aircraftIdentifier;
+    packet >> aircraftIdentifier >> aircraftPosition.x >> aircraftPosition.y;
+    if(!packet)
       break;
 
-    //
-    case Server::UpdateClientState:
-      {
-        float currentWorldPosition;
-        sf::Int32 aircraftCount;
-        packet >> currentWorldPosition >> aircraftCount;
+    Aircraft* aircraft = world->getAircraft(aircraftIdentifier);
+    bool isLocalPlane = std::find(localPlayerIdentifiers.begin(),
+        localPlayerIdentifiers.end(), aircraftIdentifier) !=
+      localPlayerIdentifiers.end();
+    if(aircraft && !isLocalPlane)
+    {
+      sf::Vector2f interpolatedPosition = aircraft->getPosition() +
+        (aircraftPosition - aircraft->getPosition()) * 0.1f;
+      aircraft->setPosition(interpolatedPosition);
+    }
+  }
+}
 
-        float currentViewPosition = world.getViewBounds().top + world.getViewBounds().height;
+// Answer to a clock synchronization request
+void MultiplayerGameState::handleClockSyncResponse(sf::Packet& packet)
+{
+  sf::Int32 clientTime;
+  sf::Int32 serverTime;
+  packet >> clientTime >> serverTime;
+
+  clockSync.addSample(sf::milliseconds(clientTime),
+      sf::milliseconds(serverTime), syncClock.getElapsedTime());
+  connection->getStats().recordRoundTripTime(
+      syncClock.getElapsedTime() - sf::milliseconds(clientTime));
+}
 
-        // Set the world's scroll compensation according to whether the view
-        // is behind or too advanced
-        world.setWorldScrollCompensation(currentViewPosition / currentWorldPosition);
+// Token to present if the match moves to another server
+void MultiplayerGameState::handleSessionToken(sf::Packet& packet)
+{
+  sf::Uint32 tokenHigh;
+  sf::Uint32 tokenLow;
+  packet >> tokenHigh >> tokenLow;
+  sessionToken = (static_cast<sf::Uint64>(tokenHigh) << 32) | tokenLow;
+}
 
-        for(sf::Int32 i=0; i<aircraftCount; ++i)
-        {
-          sf::Vector2f aircraftPosition;
-          sf::Int32 aircraftIdentifier;
-          packet >> aircraftIdentifier >> aircraftPosition.x >> aircraftPosition.y;
-
-          Aircraft* aircraft = world.getAircraft(aircraftIdentifier);
-          bool isLocalPlane = std::find(localPlayerIdentifiers.begin(),
-              localPlayerIdentifiers.end(), aircraftIdentifier) !=
-            localPlayerIdentifiers.end();
-          if(aircraft && !isLocalPlane)
-          {
-            sf::Vector2f interpolatedPosition = aircraft->getPosition() +
-              (aircraftPosition - aircraft->getPosition()) * 0.1f;
-            aircraft->setPosition(interpolatedPosition);
-          }
-        }
-      }
-      break;
+// The match continues on another port of the same server machine; the
+// host's own server is never migrated
+void MultiplayerGameState::handleMigrate(sf::Packet& packet)
+{
+  sf::Uint16 port;
+  packet >> port;
+
+  if(serverSocket)
+  {
+    targetPort = port;
+    resumeSession = true;
+    startConnecting();
   }
 }
+
+// Sent by a gateway right after connecting, the match is on another
+// server; reconnecting works as for a migration, with no session yet
+void MultiplayerGameState::handleRedirect(sf::Packet& packet)
+{
+  std::string address;
+  sf::Uint16 port;
+  packet >> address >> port;
+
+  if(serverSocket)
+  {
+    if(!address.empty())
+      serverAddress = address;
+    targetPort = port;
+    resumeSession = false;
+    startConnecting();
+  }
+}
+
+// Latency probe from the server, answer right away
+void MultiplayerGameState::handlePing(sf::Packet& packet)
+{
+  sf::Int32 serverTime;
+  packet >> serverTime;
+
+  sf::Packet pongPacket;
+  pongPacket << static_cast<sf::Int32>(Client::Pong);
+  pongPacket << serverTime;
+  connection->send(pongPacket);
+}
+
+// The server speaks a version we offered, the join state follows
+void MultiplayerGameState::handleWelcome(sf::Packet& packet)
+{
+  packet >> negotiatedVersion;
+
+  phase = Playing;
+  timeSinceLastPacket = sf::Time::Zero;
+}
+
+// Incompatible version, a full server or a session it does not know
+void MultiplayerGameState::handleReject(sf::Packet& packet)
+{
+  std::string reason;
+  packet >> reason;
+
+  // The match went on without us, join it as a new player instead
+  if(resumeSession)
+  {
+    resumeSession = false;
+    resetMatch();
+    startConnecting();
+    return;
+  }
+
+  failConnection(reason);
+}
+
+// The server resumed our session, our aircraft are ours again
+void MultiplayerGameState::handleResumeAccepted(sf::Packet&)
+{
+  resumeSession = false;
+  phase = Playing;
+  timeSinceLastPacket = sf::Time::Zero;
+}
@@ -2,23 +2,37 @@
 #define SOURCES_SCOUT_MULTIPLAYERGAMESTATE_HPP_
 
 #include "State.hpp"
+#include "ClockSync.hpp"
+#include "Connection.hpp"
 #include "GameServer.hpp"
+#include "JoinStream.hpp"
+#include "MessageDispatcher.hpp"
 #include "NetworkProtocol.hpp"
+#include "PacketLog.hpp"
 #include "Player.hpp"
 #include "World.hpp"
 
 #include <SFML/Graphics/Text.hpp>
-#include <SFML/Network/TcpSocket.hpp>
+#include <SFML/Network/IpAddress.hpp>
 #include <SFML/Network/Packet.hpp>
+#include <SFML/Network/TcpSocket.hpp>
 #include <SFML/System/Clock.hpp>
 
 #include <map>
+#include <memory>
 #include <vector>
 
 class MultiplayerGameState : public State
 {
   public:
-    MultiplayerGameState(StateStack& stack, Context context, bool isHost);
+    enum Role
+    {
+      Hosting,
+      Joining,
+      Spectating // read-only, receives snapshots and events only
+    };
+
+    MultiplayerGameState(StateStack& stack, Context context, Role role);
 
     virtual void draw();
     virtual bool update(sf::Time dt);
@@ -28,19 +42,58 @@ class MultiplayerGameState : public State
 
     void disableAllRealtimeActions();
 
+    const NetworkStats& getNetworkStats() const;
+
   private:
     typedef std::unique_ptr<Player> PlayerPtr;
 
-    World world;
+    // Replaced when a resumed session is refused and the match is joined anew
+    std::unique_ptr<World> world;
     sf::RenderTarget& target;
     TextureHolder& textures;
 
     std::map<int, PlayerPtr> players;
     std::vector<sf::Int32> localPlayerIdentifiers;
-    sf::TcpSocket socket;
-    bool connected;
+
+    // Where the connection to the server stands; none of it blocks
+    enum ConnectionPhase
+    {
+      Connecting,  // socket connect in progress, retried with backoff
+      Handshaking, // waiting for the server to accept our protocol version
+      Playing,
+      Failed
+    };
+
+    // Outlives the connection, which records into it
+    PacketRecorder recorder;
+    std::unique_ptr<Connection> connection;
+    sf::TcpSocket* serverSocket; // null for the host
+    sf::IpAddress serverAddress;
+    unsigned short targetPort;
+    ConnectionPhase phase;
+    std::size_t connectAttempts;
+    bool attemptActive;
+    bool resumeSession; // present the session token instead of a hello, until answered
+    sf::Clock connectClock;
+    sf::Time attemptDeadline;
+    sf::Time nextAttemptTime;
+    sf::Time handshakeDeadline;
+    sf::Uint32 negotiatedVersion;
     std::unique_ptr<GameServer> gameServer;
     sf::Clock tickClock;
+    JoinStreamReader joinStreamReader;
+    MessageDispatcher<> dispatcher;
+
+    ClockSync clockSync;
+    sf::Clock syncClock;
+    sf::Time nextSyncRequestTime;
+    bool serverTimeKnown;
+
+    // Presented again when the server hands the match over to another process
+    sf::Uint64 sessionToken;
+
+    sf::Time statsDumpInterval;
+    sf::Clock statsDumpClock;
 
     std::vector<std::string> broadcasts;
     sf::Text broadcastText;
@@ -55,12 +108,42 @@ class MultiplayerGameState : public State
     bool activeState;
     bool hasFocus;
     bool host;
+    bool spectator;
     bool gameStarted;
     sf::Time clientTimeout;
     sf::Time timeSinceLastPacket;
 
     void updateBroadcastMessage(sf::Time elapsedTime);
-    void handlePacket(sf::Int32 packetType, sf::Packet& packet);
+    void dumpNetworkStats() const;
+    void startConnecting();
+    void updateConnection();
+    void onConnected();
+    void failConnection(const std::string& reason);
+    void resetMatch();
+    void setStatusText(const std::string& text);
+    void registerHandlers();
+    void handleBroadcastMessage(sf::Packet& packet);
+    void handleSpawnSelf(sf::Packet& packet);
+    void handlePlayerConnect(sf::Packet& packet);
+    void handlePlayerDisconnect(sf::Packet& packet);
+    void handleInitialState(sf::Packet& packet);
+    void handleInitialAircraft(sf::Packet& packet);
+    void handleJoinStateChunk(sf::Packet& packet);
+    void handleAcceptCoopPartner(sf::Packet& packet);
+    void handlePlayerEvent(sf::Packet& packet);
+    void handlePlayerRealtimeChange(sf::Packet& packet);
+    void handleSpawnEnemy(sf::Packet& packet);
+    void handleMissionSuccess(sf::Packet& packet);
+    void handleSpawnPickup(sf::Packet& packet);
+    void handleUpdateClientState(sf::Packet& packet);
+    void handleClockSyncResponse(sf::Packet& packet);
+    void handleSessionToken(sf::Packet& packet);
+    void handleMigrate(sf::Packet& packet);
+    void handleRedirect(sf::Packet& packet);
+    void handlePing(sf::Packet& packet);
+    void handleWelcome(sf::Packet& packet);
+    void handleReject(sf::Packet& packet);
+    void handleResumeAccepted(sf::Packet& packet);
 };
 
 #endif
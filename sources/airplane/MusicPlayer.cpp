@@ -1,4 +1,5 @@
 #include "MusicPlayer.hpp"
+#include "AssetPack.hpp"
 
 MusicPlayer::MusicPlayer() :
   music(),
@@ -13,7 +14,12 @@ void MusicPlayer::play(Music::ID theme)
 {
   std::string filename = filenames[theme];
 
-  if(!music.openFromFile(filename))
+  // Streamed straight from the pack mapping when it has the theme
+  const void* data;
+  std::size_t size;
+  bool packed = AssetPack::getInstance().find(filename, data, size);
+
+  if(!(packed ? music.openFromMemory(data, size) : music.openFromFile(filename)))
     throw std::runtime_error("Music " + filename + " could not be loaded.");
 
   music.setVolume(volume);
@@ -6,6 +6,30 @@
 
 const unsigned short serverPort = 5000;
 
+// Range of protocol versions this build speaks; a client offers its range
+// in its hello and the server picks the highest version both support
+const sf::Uint32 minimumProtocolVersion = 1;
+const sf::Uint32 protocolVersion = 1;
+
+// Highest version both sides speak, 0 if there is none
+inline sf::Uint32 negotiateProtocolVersion(sf::Uint32 clientMinimum, sf::Uint32 clientMaximum)
+{
+  sf::Uint32 version = (clientMaximum < protocolVersion) ? clientMaximum : protocolVersion;
+  sf::Uint32 minimum = (clientMinimum > minimumProtocolVersion) ? clientMinimum : minimumProtocolVersion;
+  return (version >= minimum) ? version : 0;
+}
+
+// Read-only spectators connect here (5001 is the impairment proxy default)
+const unsigned short spectatorPort = 5002;
+
+// Game servers behind a gateway report their load here, the gateway itself
+// takes the clients on serverPort
+const unsigned short gatewayPort = 5003;
+
+// Vertical speed of the battlefield; both sides derive the scroll position
+// from the (synchronized) server clock and this value
+const float battleFieldScrollSpeed = -50.f;
+
 namespace Server
 {
   // Packets originated in the server
@@ -13,7 +37,7 @@ namespace Server
   {
     BroadcastMessage, // format: [Int32:packetType] [string:message]
     SpawnSelf,        // format: [Int32:packetType]
-    InitialState,
+    InitialState,     // format: [Int32:packetType] [float:worldHeight] [float:currentScroll] [Int32:serverTime]
     PlayerEvent,
     PlayerRealtimeChange,
     PlayerConnect,
@@ -22,7 +46,26 @@ namespace Server
     SpawnEnemy,
     SpawnPickup,
     UpdateClientState,
-    MissionSuccess
+    MissionSuccess,
+    ClockSyncResponse, // format: [Int32:packetType] [Int32:clientTime] [Int32:serverTime]
+    Ping,              // format: [Int32:packetType] [Int32:serverTime]
+    JoinStateChunk,    // format: [Int32:packetType] [Int32:section] [Int32:chunk] [Int32:chunkCount] [Int32:rawSize] [Uint32:size] [size bytes]
+    InitialAircraft,   // format: [Int32:packetType] [Int32:count] count x ([Int32:id] [float:x] [float:y] [Int32:hitpoints] [Int32:missiles])
+    SessionToken,      // format: [Int32:packetType] [Uint32:tokenHigh] [Uint32:tokenLow]
+    Migrate,           // format: [Int32:packetType] [Uint16:port], reconnect there and send Resume
+    Redirect,          // format: [Int32:packetType] [string:address] [Uint16:port], empty address means the same host
+    Welcome,           // format: [Int32:packetType] [Uint32:version], answer to a hello
+    Reject,            // format: [Int32:packetType] [string:reason], the connection is closed after it
+    ResumeAccepted     // format: [Int32:packetType], answer to a resume; an unknown session gets a Reject
+  };
+}
+
+namespace Backend
+{
+  // Packets a game server sends to the gateway
+  enum PacketType
+  {
+    LoadReport // format: [Int32:packetType] [Uint16:port] [Uint32:players] [Uint32:maxPlayers]
   };
 }
 
@@ -36,7 +79,12 @@ namespace Client
     RequestCoopPartner,
     PositionUpdate,
     GameEvent,
-    Quit
+    Quit,
+    ClockSyncRequest, // format: [Int32:packetType] [Int32:clientTime]
+    Pong,             // format: [Int32:packetType] [Int32:serverTime]
+    Resume,           // format: [Int32:packetType] [Uint32:tokenHigh] [Uint32:tokenLow], first message only
+    Hello,            // format: [Int32:packetType] [Uint32:minimumVersion] [Uint32:maximumVersion], first message only
+    PacketTypeCount
   };
 }
 
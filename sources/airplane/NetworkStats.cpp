@@ -0,0 +1,243 @@
+#include "NetworkStats.hpp"
+#include "Foreach.hpp"
+
+#include <SFML/Network/Packet.hpp>
+
+#include <algorithm>
+
+namespace
+{
+  // Size of the length prefix sf::TcpSocket puts in front of each packet
+  const std::size_t PacketHeaderSize = 4;
+
+  // Weight of a new sample in the smoothed round trip time (as in TCP)
+  const float RoundTripSmoothing = 0.125f;
+
+  // Silences longer than this fraction of the timeout count as near misses
+  const float NearMissRatio = 0.5f;
+
+  std::size_t bucketFor(sf::Uint64 value)
+  {
+    std::size_t bucket = 0;
+    while(value > 1 && bucket + 1 < NetworkStats::HistogramSize)
+    {
+      value >>= 1;
+      ++bucket;
+    }
+    return bucket;
+  }
+
+  void printHistogram(std::ostream& out, const NetworkStats::Histogram& histogram)
+  {
+    for(std::size_t i=0; i<histogram.size(); ++i)
+    {
+      if(histogram[i] > 0)
+        out << " [" << (1u << i) << "]=" << histogram[i];
+    }
+    out << "\n";
+  }
+
+  const char* directionName(NetworkStats::Direction direction)
+  {
+    return (direction == NetworkStats::Incoming) ? "in" : "out";
+  }
+}
+
+NetworkStats::Counter::Counter() :
+  messages(0),
+  bytes(0)
+{
+}
+
+NetworkStats::NetworkStats() :
+  totals(),
+  counters(),
+  sizeHistograms(),
+  roundTripHistogram(),
+  smoothedRoundTripTime(sf::Time::Zero),
+  hasRoundTripTime(false),
+  incompleteSends(0),
+  timeoutNearMisses(0),
+  longestSilence(sf::Time::Zero),
+  drops(),
+  coalesced(0),
+  uptime()
+{
+  FOREACH(Histogram& histogram, sizeHistograms)
+    histogram.fill(0);
+  roundTripHistogram.fill(0);
+}
+
+void NetworkStats::recordMessage(Direction direction, const sf::Packet& packet)
+{
+  sf::Uint64 bytes = packet.getDataSize() + PacketHeaderSize;
+
+  Counter& counter = counters[direction][getPacketType(packet)];
+  counter.messages++;
+  counter.bytes += bytes;
+
+  totals[direction].messages++;
+  totals[direction].bytes += bytes;
+
+  sizeHistograms[direction][bucketFor(bytes)]++;
+}
+
+void NetworkStats::recordSendStatus(sf::Socket::Status status)
+{
+  // Anything but Done means the kernel send buffer is backed up (or the
+  // connection is gone) and the message was not fully handed over
+  if(status != sf::Socket::Done)
+    incompleteSends++;
+}
+
+void NetworkStats::recordRoundTripTime(sf::Time roundTripTime)
+{
+  // Clock adjustments can make a sample come out negative
+  if(roundTripTime < sf::Time::Zero)
+    roundTripTime = sf::Time::Zero;
+
+  if(hasRoundTripTime)
+    smoothedRoundTripTime += (roundTripTime - smoothedRoundTripTime) * RoundTripSmoothing;
+  else
+    smoothedRoundTripTime = roundTripTime;
+  hasRoundTripTime = true;
+
+  roundTripHistogram[bucketFor(roundTripTime.asMilliseconds())]++;
+}
+
+void NetworkStats::recordSilence(sf::Time silence, sf::Time timeout)
+{
+  if(silence > longestSilence)
+    longestSilence = silence;
+
+  if(silence >= timeout * NearMissRatio && silence < timeout)
+    timeoutNearMisses++;
+}
+
+void NetworkStats::recordDrop(const sf::Packet& packet)
+{
+  drops[getPacketType(packet)]++;
+}
+
+void NetworkStats::recordCoalesced(sf::Uint64 messages)
+{
+  coalesced += messages;
+}
+
+const NetworkStats::Counter& NetworkStats::getTotal(Direction direction) const
+{
+  return totals[direction];
+}
+
+NetworkStats::Counter NetworkStats::getCounter(Direction direction, sf::Int32 packetType) const
+{
+  auto found = counters[direction].find(packetType);
+  return (found != counters[direction].end()) ? found->second : Counter();
+}
+
+const NetworkStats::Histogram& NetworkStats::getSizeHistogram(Direction direction) const
+{
+  return sizeHistograms[direction];
+}
+
+const NetworkStats::Histogram& NetworkStats::getRoundTripHistogram() const
+{
+  return roundTripHistogram;
+}
+
+sf::Time NetworkStats::getSmoothedRoundTripTime() const
+{
+  return smoothedRoundTripTime;
+}
+
+sf::Uint64 NetworkStats::getIncompleteSends() const
+{
+  return incompleteSends;
+}
+
+sf::Uint64 NetworkStats::getTimeoutNearMisses() const
+{
+  return timeoutNearMisses;
+}
+
+sf::Time NetworkStats::getLongestSilence() const
+{
+  return longestSilence;
+}
+
+sf::Uint64 NetworkStats::getDropped(sf::Int32 packetType) const
+{
+  auto found = drops.find(packetType);
+  return (found != drops.end()) ? found->second : 0;
+}
+
+sf::Uint64 NetworkStats::getTotalDropped() const
+{
+  sf::Uint64 total = 0;
+  FOREACH(auto& pair, drops)
+    total += pair.second;
+  return total;
+}
+
+sf::Uint64 NetworkStats::getCoalesced() const
+{
+  return coalesced;
+}
+
+sf::Time NetworkStats::getUptime() const
+{
+  return uptime.getElapsedTime();
+}
+
+void NetworkStats::print(std::ostream& out) const
+{
+  float seconds = std::max(getUptime().asSeconds(), 0.001f);
+
+  out << "  rtt=" << smoothedRoundTripTime.asMilliseconds() << "ms"
+      << " incompleteSends=" << incompleteSends
+      << " nearMisses=" << timeoutNearMisses
+      << " longestSilence=" << longestSilence.asMilliseconds() << "ms"
+      << " coalesced=" << coalesced << " dropped=" << getTotalDropped() << "\n";
+
+  if(!drops.empty())
+  {
+    out << "  dropped:";
+    FOREACH(auto& pair, drops)
+      out << " [" << pair.first << "]=" << pair.second;
+    out << "\n";
+  }
+
+  for(std::size_t i=0; i<DirectionCount; ++i)
+  {
+    Direction direction = static_cast<Direction>(i);
+    out << "  " << directionName(direction) << ": "
+        << totals[i].messages << " msgs (" << totals[i].messages / seconds << "/s) "
+        << totals[i].bytes << " bytes (" << totals[i].bytes / seconds << " B/s)\n";
+
+    FOREACH(auto& pair, counters[i])
+    {
+      out << "    type " << pair.first << ": " << pair.second.messages
+          << " msgs, " << pair.second.bytes << " bytes\n";
+    }
+
+    out << "    sizes:";
+    printHistogram(out, sizeHistograms[i]);
+  }
+
+  out << "  rtt ms:";
+  printHistogram(out, roundTripHistogram);
+}
+
+sf::Int32 NetworkStats::getPacketType(const sf::Packet& packet)
+{
+  // Every message starts with its type as a big endian Int32
+  if(packet.getDataSize() < sizeof(sf::Int32))
+    return -1;
+
+  const sf::Uint8* data = static_cast<const sf::Uint8*>(packet.getData());
+  return static_cast<sf::Int32>(
+      (static_cast<sf::Uint32>(data[0]) << 24) |
+      (static_cast<sf::Uint32>(data[1]) << 16) |
+      (static_cast<sf::Uint32>(data[2]) << 8) |
+      static_cast<sf::Uint32>(data[3]));
+}
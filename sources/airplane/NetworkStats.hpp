@@ -0,0 +1,85 @@
+#ifndef SOURCES_SCOUT_NETWORKSTATS_HPP_
+#define SOURCES_SCOUT_NETWORKSTATS_HPP_
+
+#include <SFML/Config.hpp>
+#include <SFML/Network/Socket.hpp>
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Time.hpp>
+
+#include <array>
+#include <map>
+#include <ostream>
+
+namespace sf
+{
+  class Packet;
+}
+
+// Traffic counters and histograms for one connection. Copyable, so owners
+// running on another thread can hand out snapshots.
+class NetworkStats
+{
+  public:
+    enum Direction
+    {
+      Incoming,
+      Outgoing,
+      DirectionCount
+    };
+
+    struct Counter
+    {
+      Counter();
+
+      sf::Uint64 messages;
+      sf::Uint64 bytes;
+    };
+
+    // Bucket i counts values in [2^i, 2^(i+1)) (bytes or milliseconds)
+    static const std::size_t HistogramSize = 16;
+    typedef std::array<sf::Uint64, HistogramSize> Histogram;
+
+    NetworkStats();
+
+    void recordMessage(Direction direction, const sf::Packet& packet);
+    void recordSendStatus(sf::Socket::Status status);
+    void recordRoundTripTime(sf::Time roundTripTime);
+    void recordSilence(sf::Time silence, sf::Time timeout);
+    void recordDrop(const sf::Packet& packet);
+    void recordCoalesced(sf::Uint64 messages);
+
+    const Counter& getTotal(Direction direction) const;
+    Counter getCounter(Direction direction, sf::Int32 packetType) const;
+    const Histogram& getSizeHistogram(Direction direction) const;
+    const Histogram& getRoundTripHistogram() const;
+
+    sf::Time getSmoothedRoundTripTime() const;
+    sf::Uint64 getIncompleteSends() const;
+    sf::Uint64 getTimeoutNearMisses() const;
+    sf::Time getLongestSilence() const;
+    sf::Uint64 getDropped(sf::Int32 packetType) const;
+    sf::Uint64 getTotalDropped() const;
+    sf::Uint64 getCoalesced() const;
+    sf::Time getUptime() const;
+
+    void print(std::ostream& out) const;
+
+    static sf::Int32 getPacketType(const sf::Packet& packet);
+
+  private:
+    std::array<Counter, DirectionCount> totals;
+    std::array<std::map<sf::Int32, Counter>, DirectionCount> counters;
+    std::array<Histogram, DirectionCount> sizeHistograms;
+    Histogram roundTripHistogram;
+
+    sf::Time smoothedRoundTripTime;
+    bool hasRoundTripTime;
+    sf::Uint64 incompleteSends;
+    sf::Uint64 timeoutNearMisses;
+    sf::Time longestSilence;
+    std::map<sf::Int32, sf::Uint64> drops;
+    sf::Uint64 coalesced;
+    sf::Clock uptime;
+};
+
+#endif
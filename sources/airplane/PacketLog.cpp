@@ -0,0 +1,146 @@
+#include "PacketLog.hpp"
+
+#include <SFML/Network/Packet.hpp>
+
+#include <algorithm>
+
+namespace
+{
+  const char Magic[4] = { 'S', 'C', 'P', 'K' };
+  const sf::Uint8 Version = 1;
+
+  // Sanity limit, a larger size means the file is corrupt
+  const sf::Uint64 MaxRecordSize = 16 * 1024 * 1024;
+}
+
+bool PacketLog::isClientMessage(Role role, const Record& record)
+{
+  // The server receives what the clients send, the client sends it itself
+  return (role == ServerSide) == (record.direction == NetworkStats::Incoming);
+}
+
+PacketRecorder::PacketRecorder() :
+  file(),
+  clock(),
+  lastTime(sf::Time::Zero)
+{
+}
+
+bool PacketRecorder::open(const std::string& filename, PacketLog::Role role)
+{
+  file.open(filename.c_str(), std::ios::binary | std::ios::trunc);
+  if(!file)
+    return false;
+
+  file.write(Magic, sizeof(Magic));
+  file.put(static_cast<char>(Version));
+  file.put(static_cast<char>(role));
+
+  clock.restart();
+  lastTime = sf::Time::Zero;
+  return static_cast<bool>(file);
+}
+
+bool PacketRecorder::isOpen() const
+{
+  return file.is_open();
+}
+
+void PacketRecorder::record(sf::Uint32 channel, NetworkStats::Direction direction, const sf::Packet& packet)
+{
+  if(!file.is_open())
+    return;
+
+  // Store time deltas, they are small and encode in one or two bytes
+  sf::Time now = clock.getElapsedTime();
+  writeVarint(static_cast<sf::Uint64>((now - lastTime).asMicroseconds()));
+  lastTime = now;
+
+  writeVarint(channel);
+  file.put(static_cast<char>(direction));
+  writeVarint(packet.getDataSize());
+  file.write(static_cast<const char*>(packet.getData()), packet.getDataSize());
+}
+
+void PacketRecorder::writeVarint(sf::Uint64 value)
+{
+  while(value >= 0x80)
+  {
+    file.put(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  file.put(static_cast<char>(value));
+}
+
+PacketLogReader::PacketLogReader() :
+  file(),
+  role(PacketLog::ServerSide),
+  lastTime(sf::Time::Zero)
+{
+}
+
+bool PacketLogReader::open(const std::string& filename)
+{
+  file.open(filename.c_str(), std::ios::binary);
+  if(!file)
+    return false;
+
+  char magic[sizeof(Magic)];
+  char version = 0;
+  char storedRole = 0;
+  file.read(magic, sizeof(magic));
+  file.get(version);
+  file.get(storedRole);
+
+  if(!file || !std::equal(magic, magic + sizeof(magic), Magic) ||
+      static_cast<sf::Uint8>(version) != Version)
+    return false;
+
+  role = static_cast<PacketLog::Role>(storedRole);
+  lastTime = sf::Time::Zero;
+  return true;
+}
+
+PacketLog::Role PacketLogReader::getRole() const
+{
+  return role;
+}
+
+bool PacketLogReader::next(PacketLog::Record& record)
+{
+  sf::Uint64 timeDelta;
+  sf::Uint64 channel;
+  sf::Uint64 size;
+  char direction = 0;
+
+  if(!readVarint(timeDelta) || !readVarint(channel) ||
+      !file.get(direction) || !readVarint(size) || size > MaxRecordSize)
+    return false;
+
+  record.data.resize(static_cast<std::size_t>(size));
+  if(size > 0 && !file.read(&record.data[0], record.data.size()))
+    return false;
+
+  lastTime += sf::microseconds(static_cast<sf::Int64>(timeDelta));
+  record.time = lastTime;
+  record.channel = static_cast<sf::Uint32>(channel);
+  record.direction = static_cast<NetworkStats::Direction>(direction);
+  return true;
+}
+
+bool PacketLogReader::readVarint(sf::Uint64& value)
+{
+  value = 0;
+  for(unsigned int shift = 0; shift < 64; shift += 7)
+  {
+    char byte;
+    if(!file.get(byte))
+      return false;
+
+    value |= static_cast<sf::Uint64>(byte & 0x7f) << shift;
+    if(!(byte & 0x80))
+      return true;
+  }
+
+  return false;
+}
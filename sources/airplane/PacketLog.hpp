@@ -0,0 +1,79 @@
+#ifndef SOURCES_SCOUT_PACKETLOG_HPP_
+#define SOURCES_SCOUT_PACKETLOG_HPP_
+
+#include "NetworkStats.hpp"
+
+#include <SFML/Config.hpp>
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Time.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace sf
+{
+  class Packet;
+}
+
+// Binary capture of every message passing through one or more connections.
+//
+// File layout (all integers are unsigned LEB128 varints unless noted):
+//   header: "SCPK" [Uint8:version] [Uint8:role]
+//   record: [timeDelta(us)] [channel] [Uint8:direction] [size] [data]
+namespace PacketLog
+{
+  enum Role
+  {
+    ServerSide,
+    ClientSide
+  };
+
+  struct Record
+  {
+    sf::Time time;
+    sf::Uint32 channel;
+    NetworkStats::Direction direction;
+    std::vector<char> data;
+  };
+
+  // True if the record holds a message sent by a client to the server
+  bool isClientMessage(Role role, const Record& record);
+}
+
+class PacketRecorder : private sf::NonCopyable
+{
+  public:
+    PacketRecorder();
+
+    bool open(const std::string& filename, PacketLog::Role role);
+    bool isOpen() const;
+    void record(sf::Uint32 channel, NetworkStats::Direction direction, const sf::Packet& packet);
+
+  private:
+    std::ofstream file;
+    sf::Clock clock;
+    sf::Time lastTime;
+
+    void writeVarint(sf::Uint64 value);
+};
+
+class PacketLogReader : private sf::NonCopyable
+{
+  public:
+    PacketLogReader();
+
+    bool open(const std::string& filename);
+    PacketLog::Role getRole() const;
+    bool next(PacketLog::Record& record);
+
+  private:
+    std::ifstream file;
+    PacketLog::Role role;
+    sf::Time lastTime;
+
+    bool readVarint(sf::Uint64& value);
+};
+
+#endif
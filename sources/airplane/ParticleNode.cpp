@@ -1,7 +1,11 @@
 #include "ParticleNode.hpp"
 #include "Foreach.hpp"
 #include "DataTables.hpp"
+#ifdef SCOUT_STATIC_TABLES
+#include "StaticTables.hpp"
+#endif
 #include "ResourceHolder.hpp"
+#include "TextureAtlas.hpp"
 
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/Texture.hpp>
@@ -10,13 +14,17 @@
 
 namespace
 {
-  const std::vector<ParticleData> Table = initializeParticleData();
+  const std::vector<ParticleData>& table()
+  {
+    return DataTables::getInstance().getParticleData();
+  }
 }
 
 ParticleNode::ParticleNode(Particle::Type type, const TextureHolder& textures) :
   SceneNode(),
   particles(),
   texture(textures.get(Textures::Particle)),
+  textureArea(TextureAtlas::getInstance().getArea(Textures::Particle, texture)),
   type(type),
   vertexArray(sf::Quads),
   needsVertexUpdate(true)
@@ -27,8 +35,15 @@ void ParticleNode::addParticle(sf::Vector2f position)
 {
   Particle particle;
   particle.position = position;
-  particle.color = Table[type].color;
-  particle.lifetime = Table[type].lifetime;
+#ifdef SCOUT_STATIC_TABLES
+  const int (&color)[4] = StaticTables::ParticleTable[type].color;
+  particle.color = sf::Color(static_cast<sf::Uint8>(color[0]), static_cast<sf::Uint8>(color[1]),
+      static_cast<sf::Uint8>(color[2]), static_cast<sf::Uint8>(color[3]));
+  particle.lifetime = sf::seconds(StaticTables::ParticleTable[type].lifetime);
+#else
+  particle.color = table()[type].color;
+  particle.lifetime = table()[type].lifetime;
+#endif
 
   particles.push_back(particle);
 }
@@ -84,8 +99,16 @@ void ParticleNode::addVertex(float worldX, float worldY, float texCoordX,
 
 void ParticleNode::computeVertices() const
 {
-  sf::Vector2f size(texture.getSize());
+  sf::Vector2f size(static_cast<float>(textureArea.width), static_cast<float>(textureArea.height));
   sf::Vector2f half = size / 2.f;
+  float left = static_cast<float>(textureArea.left);
+  float top = static_cast<float>(textureArea.top);
+
+#ifdef SCOUT_STATIC_TABLES
+  const float lifetime = StaticTables::ParticleTable[type].lifetime;
+#else
+  const float lifetime = table()[type].lifetime.asSeconds();
+#endif
 
   // Refill vertex array
   vertexArray.clear();
@@ -94,14 +117,13 @@ void ParticleNode::computeVertices() const
     sf::Vector2f pos = particle.position;
     sf::Color color = particle.color;
 
-    float ratio = particle.lifetime.asSeconds() /
-      Table[type].lifetime.asSeconds();
+    float ratio = particle.lifetime.asSeconds() / lifetime;
     color.a = static_cast<sf::Uint8>(255 * std::max(ratio, 0.f));
 
-    addVertex(pos.x - half.x, pos.y - half.y, 0.f, 0.f, color);
-    addVertex(pos.x + half.x, pos.y - half.y, size.x, 0.f, color);
-    addVertex(pos.x + half.x, pos.y + half.y, size.x, size.y, color);
-    addVertex(pos.x - half.x, pos.y + half.y, 0.f, size.y, color);
+    addVertex(pos.x - half.x, pos.y - half.y, left, top, color);
+    addVertex(pos.x + half.x, pos.y - half.y, left + size.x, top, color);
+    addVertex(pos.x + half.x, pos.y + half.y, left + size.x, top + size.y, color);
+    addVertex(pos.x - half.x, pos.y + half.y, left, top + size.y, color);
   }
 }
 
@@ -21,6 +21,7 @@ class ParticleNode : public SceneNode
   private:
     std::deque<Particle> particles;
     const sf::Texture& texture;
+    sf::IntRect textureArea; // part of texture holding the particle
     Particle::Type type;
 
     mutable sf::VertexArray vertexArray;
@@ -3,19 +3,23 @@
 #include "CommandQueue.hpp"
 #include "DataTables.hpp"
 #include "ResourceHolder.hpp"
+#include "TextureAtlas.hpp"
 #include "WindowUtils.hpp"
 
 #include <SFML/Graphics/RenderTarget.hpp>
 
 namespace
 {
-  const std::vector<PickupData> Table = initializePickupData();
+  const std::vector<PickupData>& table()
+  {
+    return DataTables::getInstance().getPickupData();
+  }
 }
 
 Pickup::Pickup(Type type, const TextureHolder& textures) :
   Entity(1),
   type(type),
-  sprite(textures.get(Table[type].texture), Table[type].textureRect)
+  sprite(textures.get(table()[type].texture), TextureAtlas::getInstance().getRect(table()[type].texture, table()[type].textureRect))
 {
   centerOrigin(sprite);
 }
@@ -32,7 +36,7 @@ sf::FloatRect Pickup::getBoundingRect() const
 
 void Pickup::apply(Aircraft& player) const
 {
-  Table[type].action(player);
+  table()[type].action(player);
 }
 
 void Pickup::drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const
@@ -1,11 +1,11 @@
 #include "Player.hpp"
 #include "Aircraft.hpp"
 #include "CommandQueue.hpp"
+#include "Connection.hpp"
 #include "Foreach.hpp"
 #include "NetworkProtocol.hpp"
 
 #include <SFML/Network/Packet.hpp>
-#include <SFML/Network/TcpSocket.hpp>
 
 #include <algorithm>
 #include <map>
@@ -61,13 +61,13 @@ struct AircraftMissileTrigger
   int aircraftID;
 };
 
-Player::Player(sf::TcpSocket* socket, sf::Int32 identifier, const KeyBinding* binding) :
+Player::Player(Connection* connection, sf::Int32 identifier, const KeyBinding* binding) :
   keyBinding(binding),
   actionBinding(),
   actionProxies(),
   currentMissionStatus(MissionRunning),
   identifier(identifier),
-  socket(socket)
+  connection(connection)
 {
   // Set initial action bindings
   initializeActions();
@@ -88,13 +88,13 @@ void Player::handleEvent(const sf::Event& event, CommandQueue& commands)
        !isRealtimeAction(action))
     {
       // Network connected -> send event over network
-      if(socket)
+      if(connection)
       {
         sf::Packet packet;
         packet << static_cast<sf::Int32>(Client::PlayerEvent);
         packet << identifier;
         packet << static_cast<sf::Int32>(action);
-        socket->send(packet);
+        connection->send(packet);
       }
       // Network disconnected -> local event
       else
@@ -105,7 +105,7 @@ void Player::handleEvent(const sf::Event& event, CommandQueue& commands)
   }
 
   // Realtime change (network connected)
-  if (socket &&
+  if (connection &&
       (event.type == sf::Event::KeyPressed ||
        event.type == sf::Event::KeyReleased))
   {
@@ -120,7 +120,7 @@ void Player::handleEvent(const sf::Event& event, CommandQueue& commands)
       packet << identifier;
       packet << static_cast<sf::Int32>(action);
       packet << (event.type == sf::Event::KeyPressed);
-      socket->send(packet);
+      connection->send(packet);
     }
   }
 }
@@ -140,7 +140,7 @@ void Player::disableAllRealtimeActions()
     packet << identifier;
     packet << static_cast<sf::Int32>(action.first);
     packet << false;
-    socket->send(packet);
+    connection->send(packet);
   }
 }
 
@@ -148,7 +148,7 @@ void Player::handleRealtimeInput(CommandQueue& commands)
 {
   // Check if this is a networked game and local player or just a single
   // player game
-  if(!socket || (socket && isLocal()))
+  if(!connection || (connection && isLocal()))
   {
     // Lookup all actions and push corresponding commands to queue
     std::vector<PlayerActions::Action> activeActions =
@@ -160,7 +160,7 @@ void Player::handleRealtimeInput(CommandQueue& commands)
 
 void Player::handleRealtimeNetworkInput(CommandQueue& commands)
 {
-  if(socket && !isLocal())
+  if(connection && !isLocal())
   {
     // Traverse all realtime input proxies. Because this is a networked game,
     // the input isn't handled directly
@@ -9,12 +9,8 @@
 
 #include <map>
 
-namespace sf
-{
-  class TcpSocket;
-}
-
 class CommandQueue;
+class Connection;
 
 class Player : private sf::NonCopyable
 {
@@ -26,7 +22,7 @@ class Player : private sf::NonCopyable
       MissionFailure
     };
 
-    Player(sf::TcpSocket* socket, sf::Int32 identifier, const KeyBinding* binding);
+    Player(Connection* connection, sf::Int32 identifier, const KeyBinding* binding);
 
     void handleEvent(const sf::Event& event, CommandQueue& commands);
     void handleRealtimeInput(CommandQueue& commands);
@@ -48,7 +44,7 @@ class Player : private sf::NonCopyable
     std::map<PlayerActions::Action, bool> actionProxies;
     MissionStatus currentMissionStatus;
     int identifier;
-    sf::TcpSocket* socket;
+    Connection* connection;
 
     void initializeActions();
 };
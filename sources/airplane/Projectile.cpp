@@ -1,7 +1,11 @@
 #include "Projectile.hpp"
 #include "DataTables.hpp"
+#ifdef SCOUT_STATIC_TABLES
+#include "StaticTables.hpp"
+#endif
 #include "EmitterNode.hpp"
 #include "ResourceHolder.hpp"
+#include "TextureAtlas.hpp"
 #include "MathUtils.hpp"
 #include "WindowUtils.hpp"
 
@@ -13,13 +17,16 @@
 
 namespace
 {
-  const std::vector<ProjectileData> Table = initializeProjectileData();
+  const std::vector<ProjectileData>& table()
+  {
+    return DataTables::getInstance().getProjectileData();
+  }
 }
 
 Projectile::Projectile(Type type, const TextureHolder& textures) :
   Entity(1),
   type(type),
-  sprite(textures.get(Table[type].texture), Table[type].textureRect),
+  sprite(textures.get(table()[type].texture), TextureAtlas::getInstance().getRect(table()[type].texture, table()[type].textureRect)),
   targetDirection()
 {
   centerOrigin(sprite);
@@ -87,11 +94,19 @@ sf::FloatRect Projectile::getBoundingRect() const
 
 float Projectile::getMaxSpeed() const
 {
-  return Table[type].speed;
+#ifdef SCOUT_STATIC_TABLES
+  return StaticTables::ProjectileTable[type].speed;
+#else
+  return table()[type].speed;
+#endif
 }
 
 int Projectile::getDamage() const
 {
-  return Table[type].damage;
+#ifdef SCOUT_STATIC_TABLES
+  return StaticTables::ProjectileTable[type].damage;
+#else
+  return table()[type].damage;
+#endif
 }
 
@@ -0,0 +1,324 @@
+#ifndef SOURCES_SCOUT_RESOURCECACHE_HPP_
+#define SOURCES_SCOUT_RESOURCECACHE_HPP_
+
+#include "AssetDecoder.hpp"
+#include "AssetLoader.hpp"
+
+#include <SFML/System/Lock.hpp>
+#include <SFML/System/Mutex.hpp>
+#include <SFML/System/NonCopyable.hpp>
+
+#include <exception>
+#include <future>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// Process-wide store of loaded resources of one type, keyed by the files
+// they come from.
+//
+// Every holder asking for the same file gets the same object; it lives as
+// long as someone holds it, or for good if it was acquired as retained
+// (until purge()), so a state constructed again finds its resources decoded
+// already.
+//
+// acquireAsync() hands the loading to the AssetLoader and returns at once;
+// the handle becomes ready once the main thread uploaded the resource. A
+// synchronous acquire() of a file being loaded that way waits for it, so
+// like the loader it is for the main thread then. The lock is only held
+// around the lookups, never while a file is loaded.
+template <typename Resource>
+class ResourceCache : private sf::NonCopyable
+{
+  public:
+    typedef std::shared_ptr<Resource> Ptr;
+    typedef std::shared_future<Ptr> Handle;
+
+    static ResourceCache& getInstance();
+
+    Ptr acquire(const std::string& filename, bool retain);
+
+    template <typename Parameter>
+    Ptr acquire(const std::string& filename, const Parameter& secondParam, bool retain);
+
+    Handle acquireAsync(const std::string& filename, bool retain);
+
+    template <typename Parameter>
+    Handle acquireAsync(const std::string& filename, const Parameter& secondParam, bool retain);
+
+    // Drops the retained resources nobody else holds
+    void purge();
+
+    // Drops every retained resource, before the window and the audio
+    // device they belong to are gone; holders keep what they hold
+    void clear();
+
+  private:
+    typedef typename AssetDecoder<Resource>::Staged Staged;
+
+    struct PendingLoad
+    {
+      Handle handle;
+      bool retain;
+      bool synchronous;
+    };
+
+    ResourceCache();
+
+    // The second parameter (a shader type or second shader file) is part of
+    // what gets loaded, so it is part of the key
+    template <typename Parameter>
+    static std::string makeKey(const std::string& filename, const Parameter& secondParam);
+
+    template <typename Loader>
+    Ptr acquire(const std::string& key, bool retain, Loader loader);
+
+    Handle acquireAsync(const std::string& key, bool retain, std::function<bool(Staged&)> decode);
+    void finishAsync(const std::string& key, Staged& staged, bool decoded, std::promise<Ptr>& promise);
+
+    sf::Mutex mutex;
+    std::map<std::string, std::weak_ptr<Resource> > entries;
+    std::map<std::string, Ptr> retained;
+    std::map<std::string, PendingLoad> pending;
+};
+
+template <typename Resource>
+ResourceCache<Resource>& ResourceCache<Resource>::getInstance()
+{
+  static ResourceCache instance;
+  return instance;
+}
+
+template <typename Resource>
+ResourceCache<Resource>::ResourceCache() :
+  mutex(),
+  entries(),
+  retained(),
+  pending()
+{
+}
+
+template <typename Resource>
+typename ResourceCache<Resource>::Ptr ResourceCache<Resource>::acquire(const std::string& filename, bool retain)
+{
+  return acquire(filename, retain, [&filename] (Resource& resource)
+  {
+    Staged staged;
+    return AssetDecoder<Resource>::decode(staged, filename) && AssetDecoder<Resource>::upload(resource, staged);
+  });
+}
+
+template <typename Resource>
+template <typename Parameter>
+typename ResourceCache<Resource>::Ptr ResourceCache<Resource>::acquire(const std::string& filename, const Parameter& secondParam, bool retain)
+{
+  return acquire(makeKey(filename, secondParam), retain, [&filename, &secondParam] (Resource& resource)
+  {
+    Staged staged;
+    return AssetDecoder<Resource>::decode(staged, filename, secondParam) && AssetDecoder<Resource>::upload(resource, staged);
+  });
+}
+
+template <typename Resource>
+typename ResourceCache<Resource>::Handle ResourceCache<Resource>::acquireAsync(const std::string& filename, bool retain)
+{
+  return acquireAsync(filename, retain, [filename] (Staged& staged)
+  {
+    return AssetDecoder<Resource>::decode(staged, filename);
+  });
+}
+
+template <typename Resource>
+template <typename Parameter>
+typename ResourceCache<Resource>::Handle ResourceCache<Resource>::acquireAsync(const std::string& filename, const Parameter& secondParam, bool retain)
+{
+  return acquireAsync(makeKey(filename, secondParam), retain, [filename, secondParam] (Staged& staged)
+  {
+    return AssetDecoder<Resource>::decode(staged, filename, secondParam);
+  });
+}
+
+template <typename Resource>
+template <typename Parameter>
+std::string ResourceCache<Resource>::makeKey(const std::string& filename, const Parameter& secondParam)
+{
+  std::ostringstream key;
+  key << filename << '|' << secondParam;
+  return key.str();
+}
+
+template <typename Resource>
+template <typename Loader>
+typename ResourceCache<Resource>::Ptr ResourceCache<Resource>::acquire(const std::string& key, bool retain, Loader loader)
+{
+  // A load already running is finished instead of repeated; a pending
+  // load registered here keeps other threads from decoding the same file
+  Handle running;
+  bool synchronous = false;
+  std::promise<Ptr> promise;
+  {
+    sf::Lock lock(mutex);
+    auto found = pending.find(key);
+    if(found != pending.end())
+    {
+      running = found->second.handle;
+      synchronous = found->second.synchronous;
+      found->second.retain = found->second.retain || retain;
+    }
+    else
+    {
+      Ptr resource = entries[key].lock();
+      if(resource)
+      {
+        if(retain)
+          retained[key] = resource;
+        return resource;
+      }
+
+      PendingLoad load;
+      load.handle = promise.get_future().share();
+      load.retain = retain;
+      load.synchronous = true;
+      pending[key] = load;
+    }
+  }
+
+  if(running.valid())
+  {
+    // Another thread loading synchronously needs no uploads from this one
+    if(synchronous)
+      running.wait();
+    else
+      AssetLoader::getInstance().wait(running);
+    return running.get();
+  }
+
+  Ptr resource(new Resource());
+  bool loaded = loader(*resource);
+
+  sf::Lock lock(mutex);
+  retain = pending[key].retain;
+  pending.erase(key);
+
+  if(!loaded)
+  {
+    std::runtime_error error("ResourceCache::acquire - Failed to load " + key);
+    promise.set_exception(std::make_exception_ptr(error));
+    throw error;
+  }
+
+  entries[key] = resource;
+  if(retain)
+    retained[key] = resource;
+
+  promise.set_value(resource);
+  return resource;
+}
+
+template <typename Resource>
+typename ResourceCache<Resource>::Handle ResourceCache<Resource>::acquireAsync(const std::string& key, bool retain, std::function<bool(Staged&)> decode)
+{
+  sf::Lock lock(mutex);
+
+  auto found = pending.find(key);
+  if(found != pending.end())
+  {
+    found->second.retain = found->second.retain || retain;
+    return found->second.handle;
+  }
+
+  std::shared_ptr<std::promise<Ptr> > promise(new std::promise<Ptr>());
+  Ptr resource = entries[key].lock();
+  if(resource)
+  {
+    if(retain)
+      retained[key] = resource;
+
+    promise->set_value(resource);
+    return promise->get_future().share();
+  }
+
+  PendingLoad load;
+  load.handle = promise->get_future().share();
+  load.retain = retain;
+  load.synchronous = false;
+  pending[key] = load;
+
+  // The staged data lives until the upload, it is shared by both steps
+  std::shared_ptr<Staged> staged(new Staged());
+  AssetLoader::getInstance().enqueue(
+    [decode, staged] ()
+    {
+      return decode(*staged);
+    },
+    [this, key, staged, promise] (bool decoded)
+    {
+      finishAsync(key, *staged, decoded, *promise);
+    });
+
+  return load.handle;
+}
+
+template <typename Resource>
+void ResourceCache<Resource>::finishAsync(const std::string& key, Staged& staged, bool decoded, std::promise<Ptr>& promise)
+{
+  Ptr resource(new Resource());
+  if(!decoded || !AssetDecoder<Resource>::upload(*resource, staged))
+  {
+    {
+      sf::Lock lock(mutex);
+      pending.erase(key);
+    }
+
+    promise.set_exception(std::make_exception_ptr(
+      std::runtime_error("ResourceCache::acquireAsync - Failed to load " + key)));
+    return;
+  }
+
+  sf::Lock lock(mutex);
+  bool retain = pending[key].retain;
+  pending.erase(key);
+
+  // A synchronous acquire on another thread may have been quicker
+  Ptr existing = entries[key].lock();
+  if(existing)
+    resource = existing;
+  else
+    entries[key] = resource;
+
+  if(retain)
+    retained[key] = resource;
+  promise.set_value(resource);
+}
+
+template <typename Resource>
+void ResourceCache<Resource>::purge()
+{
+  sf::Lock lock(mutex);
+
+  for(auto itr = retained.begin(); itr != retained.end();)
+  {
+    if(itr->second.use_count() == 1)
+    {
+      entries.erase(itr->first);
+      itr = retained.erase(itr);
+    }
+    else
+    {
+      ++itr;
+    }
+  }
+}
+
+template <typename Resource>
+void ResourceCache<Resource>::clear()
+{
+  sf::Lock lock(mutex);
+
+  retained.clear();
+  entries.clear();
+}
+
+#endif
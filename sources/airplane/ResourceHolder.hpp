@@ -1,78 +1,228 @@
 #ifndef SOURCES_SCOUT_RESOURCEHOLDER_HPP_
 #define SOURCES_SCOUT_RESOURCEHOLDER_HPP_
 
+#include "ResourceCache.hpp"
+#include "ResourceIdentifiers.hpp"
+
+#include <array>
 #include <cassert>
+#include <chrono>
+#include <future>
 #include <map>
 #include <memory>
 #include <string>
 #include <stdexcept>
 
+// Value per identifier: an array indexed by the identifier for dense sets
+// with a count (see IdentifierCount), a map for any other identifier
+template <typename Value, typename Identifier, std::size_t Count = IdentifierCount<Identifier>::value>
+class IdentifierTable
+{
+  public:
+    Value& operator[](Identifier id)
+    {
+      assert(static_cast<std::size_t>(id) < Count);
+      return values[id];
+    }
+
+  private:
+    std::array<Value, Count> values;
+};
+
+template <typename Value, typename Identifier>
+class IdentifierTable<Value, Identifier, 0>
+{
+  public:
+    Value& operator[](Identifier id)
+    {
+      return values[id];
+    }
+
+  private:
+    std::map<Identifier, Value> values;
+};
+
+// Names the resources one owner uses; the resources themselves come from
+// the process-wide ResourceCache, so holders loading the same file share it.
+//
+// loadAsync() returns right away. get() on a resource still loading finishes
+// the load on the spot, so it needs the main thread.
 template <typename Resource, typename Identifier>
 class ResourceHolder
 {
   public:
+    // Retained resources stay cached after the holder is gone, so the next
+    // holder loading them (the next World, say) does not decode them again
+    explicit ResourceHolder(bool retainResources = true);
+
     void load(Identifier id, const std::string& filename);
 
     template <typename Parameter>
     void load(Identifier id, const std::string& filename, const Parameter& secondParam);
 
+    typename ResourceCache<Resource>::Handle loadAsync(Identifier id, const std::string& filename);
+
+    template <typename Parameter>
+    typename ResourceCache<Resource>::Handle loadAsync(Identifier id, const std::string& filename, const Parameter& secondParam);
+
     Resource& get(Identifier id);
     const Resource& get(Identifier id) const;
 
-  private:
-    std::map<Identifier, std::unique_ptr<Resource> > resourceMap;
+    // Loaded or being loaded
+    bool contains(Identifier id) const;
+
+    // Loaded, a background load that finished included; never waits
+    bool isLoaded(Identifier id) const;
+
+    // Lets go of the resource, the cache frees it unless held elsewhere
+    void unload(Identifier id);
 
-    void insertResource(Identifier id, std::unique_ptr<Resource> resource);
+  private:
+    // Pending loads move to resources on first use, even through get() const
+    mutable IdentifierTable<std::shared_ptr<Resource>, Identifier> resources;
+    mutable IdentifierTable<typename ResourceCache<Resource>::Handle, Identifier> pending;
+    bool retainResources;
+
+    void insertResource(Identifier id, std::shared_ptr<Resource> resource);
+    void insertPending(Identifier id, typename ResourceCache<Resource>::Handle handle);
+    Resource& find(Identifier id) const;
 };
 
+template <typename Resource, typename Identifier>
+ResourceHolder<Resource, Identifier>::ResourceHolder(bool retainResources) :
+  resources(),
+  pending(),
+  retainResources(retainResources)
+{
+}
+
 template <typename Resource, typename Identifier>
 void ResourceHolder<Resource, Identifier>::load(Identifier id, const std::string& filename)
 {
-  std::unique_ptr<Resource> resource(new Resource());
-  if(!resource->loadFromFile(filename))
+  std::shared_ptr<Resource> resource;
+  try
+  {
+    resource = ResourceCache<Resource>::getInstance().acquire(filename, retainResources);
+  }
+  catch (std::runtime_error&)
   {
     throw std::runtime_error("ResourceHolder::load - Failed to load " + filename);
   }
 
-  insertResource(id, std::move(resource));
+  insertResource(id, resource);
 }
 
 template <typename Resource, typename Identifier>
 template <typename Parameter>
 void ResourceHolder<Resource, Identifier>::load(Identifier id, const std::string& filename, const Parameter& secondParam)
 {
-  std::unique_ptr<Resource> resource(new Resource());
-  if(!resource->loadFromFile(filename, secondParam))
+  std::shared_ptr<Resource> resource;
+  try
+  {
+    resource = ResourceCache<Resource>::getInstance().acquire(filename, secondParam, retainResources);
+  }
+  catch (std::runtime_error&)
   {
     throw std::runtime_error("ResourceHolder::load - Failed to load " + filename);
   }
 
-  insertResource(id, std::move(resource));
+  insertResource(id, resource);
 }
 
 template <typename Resource, typename Identifier>
-Resource& ResourceHolder<Resource, Identifier>::get(Identifier id)
+typename ResourceCache<Resource>::Handle ResourceHolder<Resource, Identifier>::loadAsync(Identifier id, const std::string& filename)
+{
+  auto handle = ResourceCache<Resource>::getInstance().acquireAsync(filename, retainResources);
+  insertPending(id, handle);
+  return handle;
+}
+
+template <typename Resource, typename Identifier>
+template <typename Parameter>
+typename ResourceCache<Resource>::Handle ResourceHolder<Resource, Identifier>::loadAsync(Identifier id, const std::string& filename, const Parameter& secondParam)
 {
-  auto found = resourceMap.find(id);
-  assert(found != resourceMap.end());
+  auto handle = ResourceCache<Resource>::getInstance().acquireAsync(filename, secondParam, retainResources);
+  insertPending(id, handle);
+  return handle;
+}
 
-  return *found->second;
+template <typename Resource, typename Identifier>
+Resource& ResourceHolder<Resource, Identifier>::get(Identifier id)
+{
+  return find(id);
 }
 
 template <typename Resource, typename Identifier>
 const Resource& ResourceHolder<Resource, Identifier>::get(Identifier id) const
 {
-  auto found = resourceMap.find(id);
-  assert(found != resourceMap.end());
+  return find(id);
+}
+
+template <typename Resource, typename Identifier>
+bool ResourceHolder<Resource, Identifier>::contains(Identifier id) const
+{
+  return resources[id] || pending[id].valid();
+}
+
+template <typename Resource, typename Identifier>
+bool ResourceHolder<Resource, Identifier>::isLoaded(Identifier id) const
+{
+  if(resources[id])
+    return true;
+
+  const typename ResourceCache<Resource>::Handle& handle = pending[id];
+  if(!handle.valid() || handle.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    return false;
+
+  // Done, moved over as on first use; a failed load throws from get() later
+  try
+  {
+    find(id);
+  }
+  catch (std::runtime_error&)
+  {
+    return false;
+  }
+  return true;
+}
+
+template <typename Resource, typename Identifier>
+void ResourceHolder<Resource, Identifier>::unload(Identifier id)
+{
+  resources[id].reset();
+  pending[id] = typename ResourceCache<Resource>::Handle();
+}
+
+template <typename Resource, typename Identifier>
+void ResourceHolder<Resource, Identifier>::insertResource(Identifier id, std::shared_ptr<Resource> resource)
+{
+  assert(!resources[id] && !pending[id].valid());
+  resources[id] = resource;
+}
 
-  return *found->second;
+template <typename Resource, typename Identifier>
+void ResourceHolder<Resource, Identifier>::insertPending(Identifier id, typename ResourceCache<Resource>::Handle handle)
+{
+  assert(!resources[id] && !pending[id].valid());
+  pending[id] = handle;
 }
 
 template <typename Resource, typename Identifier>
-void ResourceHolder<Resource, Identifier>::insertResource(Identifier id, std::unique_ptr<Resource> resource)
+Resource& ResourceHolder<Resource, Identifier>::find(Identifier id) const
 {
-  auto inserted = resourceMap.insert(std::make_pair(id, std::move(resource)));
-  assert(inserted.second);
+  // Loaded resources are one index away, the rest is for pending loads
+  std::shared_ptr<Resource>& resource = resources[id];
+  if(resource)
+    return *resource;
+
+  typename ResourceCache<Resource>::Handle handle = pending[id];
+  assert(handle.valid());
+
+  // Throws if the load failed
+  AssetLoader::getInstance().wait(handle);
+  resource = handle.get();
+  pending[id] = typename ResourceCache<Resource>::Handle();
+  return *resource;
 }
 
 #endif
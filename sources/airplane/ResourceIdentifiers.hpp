@@ -1,6 +1,8 @@
 #ifndef SOURCES_SCOUT_RESOURCEIDENTIFIERS_HPP_
 #define SOURCES_SCOUT_RESOURCEIDENTIFIERS_HPP_
 
+#include <cstddef>
+
 // Forward declaration of SFML classes
 namespace sf
 {
@@ -15,6 +17,7 @@ namespace Fonts
   enum ID
   {
     Main,
+    FontCount
   };
 }
 
@@ -35,6 +38,7 @@ namespace Shaders
     DownSamplePass,
     GaussianBlurPass,
     AddPass,
+    ShaderCount
   };
 }
 
@@ -49,6 +53,7 @@ namespace SoundEffect
     LaunchMissile,
     CollectPickup,
     Button,
+    SoundEffectCount
   };
 }
 
@@ -62,10 +67,43 @@ namespace Textures
     Buttons,
     Explosion,
     Particle,
-    FinishLine
+    FinishLine,
+    TextureCount
   };
 }
 
+// Identifier sets ending with a count enumerator are dense, their holders
+// index an array instead of searching a map
+template <typename Identifier>
+struct IdentifierCount
+{
+  static const std::size_t value = 0;
+};
+
+template <>
+struct IdentifierCount<Fonts::ID>
+{
+  static const std::size_t value = Fonts::FontCount;
+};
+
+template <>
+struct IdentifierCount<Shaders::ID>
+{
+  static const std::size_t value = Shaders::ShaderCount;
+};
+
+template <>
+struct IdentifierCount<SoundEffect::ID>
+{
+  static const std::size_t value = SoundEffect::SoundEffectCount;
+};
+
+template <>
+struct IdentifierCount<Textures::ID>
+{
+  static const std::size_t value = Textures::TextureCount;
+};
+
 // Forward declaration and a few type definitions
 template <typename Resource, typename Identifier>
 class ResourceHolder;
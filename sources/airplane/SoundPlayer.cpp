@@ -1,8 +1,11 @@
 #include "SoundPlayer.hpp"
+#include "Foreach.hpp"
 
 #include <SFML/Audio/Listener.hpp>
 
 #include <cmath>
+#include <stdexcept>
+#include <string>
 
 namespace
 {
@@ -15,20 +18,39 @@ namespace
   const float MinDistance2D = 200.f;
   const float MinDistance3D = std::sqrt(MinDistance2D*MinDistance2D +
       ListenerZ*ListenerZ);
+
+  struct SoundFile
+  {
+    SoundEffect::ID id;
+    const char* filename;
+  };
+
+  const SoundFile SoundFiles[] =
+  {
+    { SoundEffect::AlliedGunfire, "assets/sounds/AlliedGunfire.wav" },
+    { SoundEffect::EnemyGunfire, "assets/sounds/EnemyGunfire.wav" },
+    { SoundEffect::Explosion1, "assets/sounds/Explosion1.wav" },
+    { SoundEffect::Explosion2, "assets/sounds/Explosion2.wav" },
+    { SoundEffect::LaunchMissile, "assets/sounds/LaunchMissile.wav" },
+    { SoundEffect::CollectPickup, "assets/sounds/CollectPickup.wav" },
+    { SoundEffect::Button, "assets/sounds/Button.wav" }
+  };
+
+  std::string getFilename(SoundEffect::ID effect)
+  {
+    for(std::size_t i=0; i<sizeof(SoundFiles) / sizeof(SoundFiles[0]); ++i)
+    {
+      if(SoundFiles[i].id == effect)
+        return SoundFiles[i].filename;
+    }
+    throw std::runtime_error("SoundPlayer::getFilename - No file for sound effect");
+  }
 }
 
 SoundPlayer::SoundPlayer() :
-  soundBuffers(),
+  soundBuffers(false),
   sounds()
 {
-  soundBuffers.load(SoundEffect::AlliedGunfire, "assets/sounds/AlliedGunfire.wav");
-  soundBuffers.load(SoundEffect::EnemyGunfire, "assets/sounds/EnemyGunfire.wav");
-  soundBuffers.load(SoundEffect::Explosion1, "assets/sounds/Explosion1.wav");
-  soundBuffers.load(SoundEffect::Explosion2, "assets/sounds/Explosion2.wav");
-  soundBuffers.load(SoundEffect::LaunchMissile, "assets/sounds/LaunchMissile.wav");
-  soundBuffers.load(SoundEffect::CollectPickup, "assets/sounds/CollectPickup.wav");
-  soundBuffers.load(SoundEffect::Button, "assets/sounds/Button.wav");
-
   // Listener points towards the screen (default in SFML)
   sf::Listener::setDirection(0.f, 0.f, -1.f);
 }
@@ -43,7 +65,7 @@ void SoundPlayer::play(SoundEffect::ID effect, sf::Vector2f position)
   sounds.push_back(sf::Sound());
   sf::Sound& sound = sounds.back();
 
-  sound.setBuffer(soundBuffers.get(effect));
+  sound.setBuffer(getBuffer(effect));
   sound.setPosition(position.x, -position.y, 0.f);
   sound.setAttenuation(Attenuation);
   sound.setMinDistance(MinDistance3D);
@@ -51,6 +73,35 @@ void SoundPlayer::play(SoundEffect::ID effect, sf::Vector2f position)
   sound.play();
 }
 
+void SoundPlayer::prefetch(SoundEffect::ID effect)
+{
+  if(!soundBuffers.contains(effect))
+    soundBuffers.loadAsync(effect, getFilename(effect));
+}
+
+void SoundPlayer::evictAllExcept(SoundEffect::ID effect)
+{
+  for(std::size_t i=0; i<SoundEffect::SoundEffectCount; ++i)
+  {
+    // Buffers still loading are left to finish
+    SoundEffect::ID evicted = static_cast<SoundEffect::ID>(i);
+    if(evicted == effect || !soundBuffers.isLoaded(evicted))
+      continue;
+
+    // Still played, the sound would lose its buffer
+    bool playing = false;
+    const sf::SoundBuffer* buffer = &soundBuffers.get(evicted);
+    FOREACH(const sf::Sound& sound, sounds)
+    {
+      if(sound.getBuffer() == buffer)
+        playing = true;
+    }
+
+    if(!playing)
+      soundBuffers.unload(evicted);
+  }
+}
+
 void SoundPlayer::removeStoppedSounds()
 {
   sounds.remove_if([] (const sf::Sound& s)
@@ -69,3 +120,12 @@ sf::Vector2f SoundPlayer::getListenerPosition() const
   sf::Vector3f position = sf::Listener::getPosition();
   return sf::Vector2f(position.x, position.y);
 }
+
+sf::SoundBuffer& SoundPlayer::getBuffer(SoundEffect::ID effect)
+{
+  // Not prefetched, or evicted since: load it right here
+  if(!soundBuffers.contains(effect))
+    soundBuffers.load(effect, getFilename(effect));
+
+  return soundBuffers.get(effect);
+}
@@ -19,6 +19,14 @@ class SoundPlayer : private sf::NonCopyable
     void play(SoundEffect::ID effect);
     void play(SoundEffect::ID effect, sf::Vector2f position);
 
+    // Sounds load on first play; states prefetch the ones they will play so
+    // they are decoded in the background by then
+    void prefetch(SoundEffect::ID effect);
+
+    // Drops every buffer but the one of effect, except the ones still
+    // playing or loading; for state changes, never during play
+    void evictAllExcept(SoundEffect::ID effect);
+
     void removeStoppedSounds();
     void setListenerPosition(sf::Vector2f position);
     sf::Vector2f getListenerPosition() const;
@@ -26,6 +34,8 @@ class SoundPlayer : private sf::NonCopyable
   private:
     SoundBufferHolder soundBuffers;
     std::list<sf::Sound> sounds;
+
+    sf::SoundBuffer& getBuffer(SoundEffect::ID effect);
 };
 
 
@@ -0,0 +1,239 @@
+#include "SpectatorHub.hpp"
+#include "Foreach.hpp"
+#include "NetworkProtocol.hpp"
+
+#include <SFML/Network/Packet.hpp>
+#include <SFML/System/Sleep.hpp>
+
+namespace
+{
+  // Frames queued for one spectator before it counts as too slow
+  const std::size_t MaxBacklog = 64;
+
+  // The game thread publishes once per tick, no need to poll faster
+  const sf::Time IdleTime = sf::milliseconds(5);
+}
+
+SpectatorHub::SpectatorHub(unsigned short port, std::size_t maxSpectators, const sf::Clock& serverClock, sf::Time clockOffset) :
+  thread(&SpectatorHub::executionThread, this),
+  serverClock(serverClock),
+  clockOffset(clockOffset),
+  listener(),
+  port(port),
+  maxSpectators(maxSpectators),
+  listening(false),
+  messages(),
+  spectators(),
+  joinStateRequested(false),
+  spectatorCount(0),
+  waitingThreadEnd(false)
+{
+  listener.setBlocking(false);
+  thread.launch();
+}
+
+SpectatorHub::~SpectatorHub()
+{
+  waitingThreadEnd = true;
+  thread.wait();
+}
+
+void SpectatorHub::publish(Frame frame)
+{
+  Message message;
+  message.frame = frame;
+  message.joinState = false;
+  messages.push(message);
+}
+
+void SpectatorHub::publishJoinState(Frame frame)
+{
+  joinStateRequested = false;
+
+  Message message;
+  message.frame = frame;
+  message.joinState = true;
+  messages.push(message);
+}
+
+bool SpectatorHub::isJoinStateRequested() const
+{
+  return joinStateRequested;
+}
+
+std::size_t SpectatorHub::getSpectatorCount() const
+{
+  return spectatorCount;
+}
+
+void SpectatorHub::appendPacket(std::vector<char>& frame, const sf::Packet& packet)
+{
+  sf::Uint32 size = static_cast<sf::Uint32>(packet.getDataSize());
+  frame.push_back(static_cast<char>(size >> 24));
+  frame.push_back(static_cast<char>(size >> 16));
+  frame.push_back(static_cast<char>(size >> 8));
+  frame.push_back(static_cast<char>(size));
+
+  const char* data = static_cast<const char*>(packet.getData());
+  frame.insert(frame.end(), data, data + size);
+}
+
+void SpectatorHub::executionThread()
+{
+  while(!waitingThreadEnd)
+  {
+    acceptSpectators();
+    distribute();
+
+    for(auto itr = spectators.begin(); itr != spectators.end();)
+    {
+      if(handleRequests(*itr) && flush(*itr))
+        ++itr;
+      else
+        itr = spectators.erase(itr);
+    }
+    spectatorCount = spectators.size();
+
+    sf::sleep(IdleTime);
+  }
+}
+
+void SpectatorHub::acceptSpectators()
+{
+  // Only listen while there is room
+  if(spectators.size() < maxSpectators && !listening)
+    listening = (listener.listen(port) == sf::Socket::Done);
+  else if(spectators.size() >= maxSpectators && listening)
+  {
+    listener.close();
+    listening = false;
+  }
+
+  if(!listening)
+    return;
+
+  std::unique_ptr<sf::TcpSocket> socket(new sf::TcpSocket());
+  if(listener.accept(*socket) != sf::Socket::Done)
+    return;
+
+  socket->setBlocking(false);
+
+  Spectator spectator;
+  spectator.socket = std::move(socket);
+  spectator.offset = 0;
+  spectator.joined = false;
+  spectators.push_back(std::move(spectator));
+
+  joinStateRequested = true;
+}
+
+void SpectatorHub::distribute()
+{
+  Message message;
+  while(messages.pop(message))
+  {
+    // The same buffer is referenced by every backlog, never copied. New
+    // spectators skip everything up to their join state
+    FOREACH(Spectator& spectator, spectators)
+    {
+      if(message.joinState && !spectator.joined)
+      {
+        spectator.backlog.push_back(message.frame);
+        spectator.joined = true;
+      }
+      else if(!message.joinState && spectator.joined)
+      {
+        spectator.backlog.push_back(message.frame);
+      }
+    }
+  }
+
+  // Ask again if someone arrived after the last join state was built
+  FOREACH(const Spectator& spectator, spectators)
+  {
+    if(!spectator.joined)
+      joinStateRequested = true;
+  }
+}
+
+bool SpectatorHub::handleRequests(Spectator& spectator)
+{
+  sf::Packet packet;
+  sf::Socket::Status status;
+  while((status = spectator.socket->receive(packet)) == sf::Socket::Done)
+  {
+    sf::Int32 packetType;
+    packet >> packetType;
+
+    if(packetType == Client::ClockSyncRequest)
+    {
+      sf::Int32 clientTime;
+      packet >> clientTime;
+
+      sf::Packet responsePacket;
+      responsePacket << static_cast<sf::Int32>(Server::ClockSyncResponse);
+      responsePacket << clientTime;
+      responsePacket << (serverClock.getElapsedTime() + clockOffset).asMilliseconds();
+      queueResponse(spectator, responsePacket);
+    }
+    else if(packetType == Client::Hello)
+    {
+      sf::Uint32 minimumVersion = 0;
+      sf::Uint32 maximumVersion = 0;
+      packet >> minimumVersion >> maximumVersion;
+
+      // Spectators only read, an incompatible one is simply dropped
+      sf::Uint32 version = negotiateProtocolVersion(minimumVersion, maximumVersion);
+      if(version == 0)
+        return false;
+
+      sf::Packet responsePacket;
+      responsePacket << static_cast<sf::Int32>(Server::Welcome);
+      responsePacket << version;
+      queueResponse(spectator, responsePacket);
+    }
+    packet.clear();
+  }
+
+  return status == sf::Socket::NotReady;
+}
+
+void SpectatorHub::queueResponse(Spectator& spectator, const sf::Packet& packet)
+{
+  // Queued behind the frame being sent, the stream must stay framed
+  std::shared_ptr<std::vector<char> > response(new std::vector<char>());
+  appendPacket(*response, packet);
+  spectator.backlog.push_back(response);
+}
+
+bool SpectatorHub::flush(Spectator& spectator)
+{
+  if(spectator.backlog.size() > MaxBacklog)
+    return false;
+
+  while(!spectator.backlog.empty())
+  {
+    const std::vector<char>& frame = *spectator.backlog.front();
+    std::size_t sent = 0;
+    sf::Socket::Status status = frame.empty() ? sf::Socket::Done :
+      spectator.socket->send(&frame[spectator.offset], frame.size() - spectator.offset, sent);
+
+    spectator.offset += sent;
+    if(status == sf::Socket::Done || spectator.offset >= frame.size())
+    {
+      spectator.backlog.pop_front();
+      spectator.offset = 0;
+    }
+    else if(status == sf::Socket::Partial || status == sf::Socket::NotReady)
+    {
+      // Kernel buffer full, continue on the next pass
+      return true;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,86 @@
+#ifndef SOURCES_SCOUT_SPECTATORHUB_HPP_
+#define SOURCES_SCOUT_SPECTATORHUB_HPP_
+
+#include "LockFreeQueue.hpp"
+
+#include <SFML/Network/TcpListener.hpp>
+#include <SFML/Network/TcpSocket.hpp>
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Thread.hpp>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace sf
+{
+  class Packet;
+}
+
+// Serves read-only spectators from its own I/O thread.
+//
+// The game thread encodes what happened during a tick once, as a buffer of
+// SFML framed messages, and publishes it; the I/O thread writes that same
+// immutable buffer to every spectator. Spectators joining later first get a
+// join state frame, requested from the game thread through
+// isJoinStateRequested(). Clock synchronization requests are answered here,
+// anything else a spectator sends is ignored.
+class SpectatorHub : private sf::NonCopyable
+{
+  public:
+    typedef std::shared_ptr<const std::vector<char> > Frame;
+
+    // The server time is serverClock plus clockOffset, which is non zero
+    // for a match resumed from a checkpoint
+    SpectatorHub(unsigned short port, std::size_t maxSpectators, const sf::Clock& serverClock, sf::Time clockOffset);
+    ~SpectatorHub();
+
+    // Game thread only
+    void publish(Frame frame);
+    void publishJoinState(Frame frame);
+    bool isJoinStateRequested() const;
+    std::size_t getSpectatorCount() const;
+
+    // Appends a message with the same framing sf::TcpSocket uses for packets
+    static void appendPacket(std::vector<char>& frame, const sf::Packet& packet);
+
+  private:
+    struct Message
+    {
+      Frame frame;
+      bool joinState;
+    };
+
+    struct Spectator
+    {
+      std::unique_ptr<sf::TcpSocket> socket;
+      std::deque<Frame> backlog;
+      std::size_t offset;
+      bool joined;
+    };
+
+    sf::Thread thread;
+    const sf::Clock& serverClock;
+    sf::Time clockOffset;
+    sf::TcpListener listener;
+    unsigned short port;
+    std::size_t maxSpectators;
+    bool listening;
+
+    LockFreeQueue<Message> messages;
+    std::vector<Spectator> spectators;
+    std::atomic<bool> joinStateRequested;
+    std::atomic<std::size_t> spectatorCount;
+    std::atomic<bool> waitingThreadEnd;
+
+    void executionThread();
+    void acceptSpectators();
+    void distribute();
+    bool handleRequests(Spectator& spectator);
+    void queueResponse(Spectator& spectator, const sf::Packet& packet);
+    bool flush(Spectator& spectator);
+};
+
+#endif
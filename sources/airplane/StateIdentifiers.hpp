@@ -17,6 +17,7 @@ namespace States
     MissionSuccess,
     HostGame,
     JoinGame,
+    SpectateGame,
   };
 }
 
@@ -0,0 +1,59 @@
+#include "StateScheduler.hpp"
+#include "Foreach.hpp"
+
+#include <algorithm>
+
+StateScheduler::StateScheduler() :
+  entries(),
+  deferred(0)
+{
+}
+
+void StateScheduler::accumulate(sf::Int32 identifier, float priority)
+{
+  // A handful of entities per peer, a linear search beats a map here
+  auto found = std::find_if(entries.begin(), entries.end(),
+      [identifier] (const Entry& entry) { return entry.identifier == identifier; });
+
+  if(found == entries.end())
+  {
+    Entry entry = { identifier, priority, true };
+    entries.push_back(entry);
+  }
+  else
+  {
+    found->priority += priority;
+    found->current = true;
+  }
+}
+
+void StateScheduler::select(std::size_t byteBudget, std::size_t entrySize, std::vector<sf::Int32>& selected)
+{
+  selected.clear();
+
+  // Forget entities that are gone
+  entries.erase(std::remove_if(entries.begin(), entries.end(),
+      [] (const Entry& entry) { return !entry.current; }), entries.end());
+
+  std::size_t count = entries.size();
+  if(byteBudget > 0)
+    count = std::min(count, byteBudget / std::max<std::size_t>(1, entrySize));
+
+  std::partial_sort(entries.begin(), entries.begin() + count, entries.end(),
+      [] (const Entry& a, const Entry& b) { return a.priority > b.priority; });
+
+  for(std::size_t i=0; i<count; ++i)
+  {
+    selected.push_back(entries[i].identifier);
+    entries[i].priority = 0.f;
+  }
+  deferred += entries.size() - count;
+
+  FOREACH(Entry& entry, entries)
+    entry.current = false;
+}
+
+sf::Uint64 StateScheduler::getDeferred() const
+{
+  return deferred;
+}
@@ -0,0 +1,42 @@
+#ifndef SOURCES_SCOUT_STATESCHEDULER_HPP_
+#define SOURCES_SCOUT_STATESCHEDULER_HPP_
+
+#include <SFML/Config.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Chooses which entity updates go to one peer when not all of them fit.
+//
+// Every update round each entity the peer should hear about gains some
+// priority (how much is up to the caller: closer, livelier entities gain
+// more). The highest ones that fit in the byte budget are sent and start
+// over from zero, the others keep what they have, so an entity left out
+// keeps rising until it is sent. Entities not mentioned in a round are
+// forgotten.
+class StateScheduler
+{
+  public:
+    StateScheduler();
+
+    void accumulate(sf::Int32 identifier, float priority);
+
+    // Picks entities worth entrySize bytes each until byteBudget is used
+    // up, a budget of zero picks all of them
+    void select(std::size_t byteBudget, std::size_t entrySize, std::vector<sf::Int32>& selected);
+
+    sf::Uint64 getDeferred() const;
+
+  private:
+    struct Entry
+    {
+      sf::Int32 identifier;
+      float priority;
+      bool current;
+    };
+
+    std::vector<Entry> entries;
+    sf::Uint64 deferred;
+};
+
+#endif
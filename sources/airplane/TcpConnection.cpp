@@ -0,0 +1,24 @@
+#include "TcpConnection.hpp"
+
+#include <SFML/Network/Packet.hpp>
+
+TcpConnection::TcpConnection() :
+  Connection(),
+  socket()
+{
+}
+
+sf::TcpSocket& TcpConnection::getSocket()
+{
+  return socket;
+}
+
+sf::Socket::Status TcpConnection::sendPacket(sf::Packet& packet)
+{
+  return socket.send(packet);
+}
+
+sf::Socket::Status TcpConnection::receivePacket(sf::Packet& packet)
+{
+  return socket.receive(packet);
+}
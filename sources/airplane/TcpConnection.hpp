@@ -0,0 +1,24 @@
+#ifndef SOURCES_SCOUT_TCPCONNECTION_HPP_
+#define SOURCES_SCOUT_TCPCONNECTION_HPP_
+
+#include "Connection.hpp"
+
+#include <SFML/Network/TcpSocket.hpp>
+
+// Connection to a peer on another process or computer
+class TcpConnection : public Connection
+{
+  public:
+    TcpConnection();
+
+    sf::TcpSocket& getSocket();
+
+  protected:
+    virtual sf::Socket::Status sendPacket(sf::Packet& packet);
+    virtual sf::Socket::Status receivePacket(sf::Packet& packet);
+
+  private:
+    sf::TcpSocket socket;
+};
+
+#endif
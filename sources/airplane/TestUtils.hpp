@@ -0,0 +1,28 @@
+#ifndef SOURCES_SCOUT_TESTUTILS_HPP_
+#define SOURCES_SCOUT_TESTUTILS_HPP_
+
+#include <iostream>
+
+// Shared by the *_test programs: check() reports and counts failed
+// conditions, testResult() turns the count into the exit code of main
+inline int& testFailures()
+{
+  static int failures = 0;
+  return failures;
+}
+
+inline void check(bool condition, const char* description)
+{
+  if(!condition)
+  {
+    std::cout << "FAILED: " << description << std::endl;
+    testFailures()++;
+  }
+}
+
+inline int testResult()
+{
+  return testFailures() == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,93 @@
+#include "TextureAtlas.hpp"
+#include "AssetPack.hpp"
+
+#include <SFML/Graphics/Texture.hpp>
+
+#include <fstream>
+#include <sstream>
+
+TextureAtlas& TextureAtlas::getInstance()
+{
+  static TextureAtlas instance;
+  return instance;
+}
+
+TextureAtlas::TextureAtlas() :
+  regions(),
+  bindings()
+{
+}
+
+bool TextureAtlas::loadFromFile(const std::string& filename)
+{
+  // The table is packed with the other assets when there is a pack
+  std::string contents;
+  const void* data;
+  std::size_t size;
+  if(AssetPack::getInstance().find(filename, data, size))
+  {
+    contents.assign(static_cast<const char*>(data), size);
+  }
+  else
+  {
+    std::ifstream file(filename.c_str());
+    if(!file)
+      return false;
+
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    contents = stream.str();
+  }
+
+  std::map<std::string, Region> table;
+  std::istringstream lines(contents);
+  std::string line;
+  while(std::getline(lines, line))
+  {
+    if(line.empty() || line[0] == '#')
+      continue;
+
+    std::istringstream fields(line);
+    std::string textureFile;
+    Region region;
+    if(!(fields >> textureFile >> region.atlasFile >> region.rect.left >> region.rect.top
+          >> region.rect.width >> region.rect.height))
+      return false;
+
+    table[textureFile] = region;
+  }
+
+  regions.swap(table);
+  return true;
+}
+
+std::string TextureAtlas::bind(Textures::ID id, const std::string& textureFile)
+{
+  auto found = regions.find(textureFile);
+  if(found == regions.end())
+  {
+    bindings.erase(id);
+    return textureFile;
+  }
+
+  bindings[id] = found->second.rect;
+  return found->second.atlasFile;
+}
+
+sf::IntRect TextureAtlas::getRect(Textures::ID id, const sf::IntRect& rect) const
+{
+  auto found = bindings.find(id);
+  if(found == bindings.end())
+    return rect;
+
+  return sf::IntRect(found->second.left + rect.left, found->second.top + rect.top, rect.width, rect.height);
+}
+
+sf::IntRect TextureAtlas::getArea(Textures::ID id, const sf::Texture& texture) const
+{
+  auto found = bindings.find(id);
+  if(found == bindings.end())
+    return sf::IntRect(0, 0, texture.getSize().x, texture.getSize().y);
+
+  return found->second;
+}
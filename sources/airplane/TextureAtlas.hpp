@@ -0,0 +1,53 @@
+#ifndef SOURCES_SCOUT_TEXTUREATLAS_HPP_
+#define SOURCES_SCOUT_TEXTUREATLAS_HPP_
+
+#include "ResourceIdentifiers.hpp"
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/NonCopyable.hpp>
+
+#include <map>
+#include <string>
+
+namespace sf
+{
+  class Texture;
+}
+
+// Where the atlaspack tool put the textures it packed together.
+//
+// The remap table has one line per packed texture:
+//   <texture file> <atlas file> <left> <top> <width> <height>
+// Whoever loads a texture binds its ID first and loads the file returned,
+// the atlas when the texture was packed. Rectangles meant for the original
+// texture are then moved into the atlas by getRect(). Without a table every
+// texture stays on its own.
+class TextureAtlas : private sf::NonCopyable
+{
+  public:
+    static TextureAtlas& getInstance();
+
+    TextureAtlas();
+
+    bool loadFromFile(const std::string& filename);
+
+    // Returns the file to load for the texture from now on known as id
+    std::string bind(Textures::ID id, const std::string& textureFile);
+
+    sf::IntRect getRect(Textures::ID id, const sf::IntRect& rect) const;
+
+    // Part of the loaded texture holding the whole original one
+    sf::IntRect getArea(Textures::ID id, const sf::Texture& texture) const;
+
+  private:
+    struct Region
+    {
+      std::string atlasFile;
+      sf::IntRect rect;
+    };
+
+    std::map<std::string, Region> regions;
+    std::map<Textures::ID, sf::IntRect> bindings;
+};
+
+#endif
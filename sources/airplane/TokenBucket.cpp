@@ -0,0 +1,35 @@
+#include "TokenBucket.hpp"
+
+#include <algorithm>
+
+TokenBucket::TokenBucket() :
+  rate(0.f),
+  burst(0.f),
+  tokens(0.f),
+  lastTime(sf::Time::Zero)
+{
+}
+
+TokenBucket::TokenBucket(float rate, float burst) :
+  rate(rate),
+  burst(burst),
+  tokens(burst),
+  lastTime(sf::Time::Zero)
+{
+}
+
+bool TokenBucket::consume(sf::Time now)
+{
+  if(rate <= 0.f)
+    return true;
+
+  // Refill for the time elapsed since the last call, up to the burst size
+  tokens = std::min(burst, tokens + (now - lastTime).asSeconds() * rate);
+  lastTime = now;
+
+  if(tokens < 1.f)
+    return false;
+
+  tokens -= 1.f;
+  return true;
+}
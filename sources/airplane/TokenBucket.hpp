@@ -0,0 +1,23 @@
+#ifndef SOURCES_SCOUT_TOKENBUCKET_HPP_
+#define SOURCES_SCOUT_TOKENBUCKET_HPP_
+
+#include <SFML/System/Time.hpp>
+
+// Allows rate events per second on average and bursts of up to burst events.
+// A rate of zero means unlimited.
+class TokenBucket
+{
+  public:
+    TokenBucket();
+    TokenBucket(float rate, float burst);
+
+    bool consume(sf::Time now);
+
+  private:
+    float rate;
+    float burst;
+    float tokens;
+    sf::Time lastTime;
+};
+
+#endif
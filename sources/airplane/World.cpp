@@ -5,6 +5,7 @@
 #include "Projectile.hpp"
 #include "SoundNode.hpp"
 #include "TextNode.hpp"
+#include "TextureAtlas.hpp"
 
 #include <SFML/Graphics/RenderTarget.hpp>
 
@@ -12,6 +13,28 @@
 #include <cmath>
 #include <limits>
 
+namespace
+{
+  struct TextureFile
+  {
+    Textures::ID id;
+    const char* filename;
+  };
+
+  const TextureFile WorldTextures[] =
+  {
+    { Textures::Entities, "assets/textures/Entities.png" },
+    { Textures::Jungle, "assets/textures/Jungle.png" },
+    { Textures::Explosion, "assets/textures/Explosion.png" },
+    { Textures::Particle, "assets/textures/Particle.png" },
+    { Textures::FinishLine, "assets/textures/FinishLine.png" }
+  };
+
+  const std::size_t WorldTextureCount = sizeof(WorldTextures) / sizeof(WorldTextures[0]);
+
+  const std::string MissionFile = "assets/missions/Mission1.mission";
+}
+
 World::World(sf::RenderTarget& outputTarget, FontHolder& fonts, SoundPlayer& sounds, bool networked) :
     target(outputTarget),
     sceneTexture(),
@@ -24,33 +47,53 @@ World::World(sf::RenderTarget& outputTarget, FontHolder& fonts, SoundPlayer& sou
     commandQueue(),
     worldBounds(0.f, 0.f, worldView.getSize().x, 5000.f),
     spawnPosition(worldView.getSize().x / 2.f, worldBounds.height - worldView.getSize().y / 2.f),
-    scrollSpeed(-50.f),
-    scrollSpeedCompensation(1.f),
+    scrollSpeed(battleFieldScrollSpeed),
     playerAircrafts(),
     enemySpawnPoints(),
+    scheduledSpawnPoints(0),
     activeEnemies(),
+    mission(),
+    nextBackground(0),
+    backgroundNodes(),
+    finishLineY(0.f),
     bloomEffect(),
     networkedWorld(networked),
     networkNode(nullptr)
 {
   sceneTexture.create(target.getSize().x, target.getSize().y);
 
+  // Networked worlds play what the server sends
+  if(!networkedWorld)
+    loadMission(MissionFile);
+
   loadTextures();
+  prefetchSounds();
   buildScene();
 
   // Prepare the view
   worldView.setCenter(spawnPosition);
+  streamBackgrounds();
+}
+
+World::~World()
+{
+  // What this World holds stays retained for the next one, resources
+  // retained by states gone since are dropped
+  ResourceCache<sf::Texture>::getInstance().purge();
+  ResourceCache<sf::Shader>::getInstance().purge();
 }
 
-void World::setWorldScrollCompensation(float compensation)
+void World::setBattleFieldTime(sf::Time serverTime)
 {
-  scrollSpeedCompensation = compensation;
+  // Same formula as the server, so every client shows the same battlefield
+  setCurrentBattleFieldPosition(worldBounds.height + scrollSpeed * serverTime.asSeconds());
 }
 
 void World::update(sf::Time dt)
 {
-  // Scroll the world
-  worldView.move(0.f, scrollSpeed * dt.asSeconds() * scrollSpeedCompensation);
+  // Scroll the world (networked worlds are positioned from the server clock)
+  if(!networkedWorld)
+    worldView.move(0.f, scrollSpeed * dt.asSeconds());
 
   FOREACH(Aircraft* a, playerAircrafts)
     a->setVelocity(0.f, 0.f);
@@ -75,6 +118,7 @@ void World::update(sf::Time dt)
 
   // Remove all destroyed entities, create new ones
   sceneGraph.removeWrecks();
+  streamBackgrounds();
   spawnEnemies();
 
   // Regular update step, adapt position (correct if outside view)
@@ -170,20 +214,52 @@ bool World::hasPlayerReachedEnd() const
   if(Aircraft* aircraft = getAircraft(1))
   {
     sf::Vector2f position = aircraft->getPosition();
-    bool contained = worldBounds.contains(position);
-    return !contained;
+    return position.y < finishLineY;
   }
   else
     return false;
 }
 
+void World::prefetchResources()
+{
+  // Retained by the cache, the World built later finds them there
+  for(std::size_t i=0; i<WorldTextureCount; ++i)
+  {
+    std::string filename = TextureAtlas::getInstance().bind(WorldTextures[i].id, WorldTextures[i].filename);
+    ResourceCache<sf::Texture>::getInstance().acquireAsync(filename, true);
+  }
+
+  BloomEffect::prefetchShaders();
+}
+
+void World::loadMission(const std::string& filename)
+{
+  if(!mission.loadFromFile(filename))
+    throw std::runtime_error("World::loadMission - Failed to load " + filename);
+
+  worldBounds.height = mission.getHeight();
+  spawnPosition.y = worldBounds.height - worldView.getSize().y / 2.f;
+  finishLineY = spawnPosition.y - mission.getFinish();
+}
+
 void World::loadTextures()
 {
-  textures.load(Textures::Entities, "assets/textures/Entities.png");
-  textures.load(Textures::Jungle, "assets/textures/Jungle.png");
-  textures.load(Textures::Explosion, "assets/textures/Explosion.png");
-  textures.load(Textures::Particle, "assets/textures/Particle.png");
-  textures.load(Textures::FinishLine, "assets/textures/FinishLine.png");
+  // Textures packed in the same atlas are loaded once, the cache hands
+  // out the same texture for each of their IDs
+  for(std::size_t i=0; i<WorldTextureCount; ++i)
+    textures.load(WorldTextures[i].id, TextureAtlas::getInstance().bind(WorldTextures[i].id, WorldTextures[i].filename));
+}
+
+void World::prefetchSounds()
+{
+  // Decoded in the background while the scene is built, the menu evicts
+  // them again
+  sounds.prefetch(SoundEffect::AlliedGunfire);
+  sounds.prefetch(SoundEffect::EnemyGunfire);
+  sounds.prefetch(SoundEffect::Explosion1);
+  sounds.prefetch(SoundEffect::Explosion2);
+  sounds.prefetch(SoundEffect::LaunchMissile);
+  sounds.prefetch(SoundEffect::CollectPickup);
 }
 
 void World::adaptPlayerPosition()
@@ -317,24 +393,27 @@ void World::buildScene()
     sceneGraph.attachChild(std::move(layer));
   }
 
-  // Prepare the tiled background
-  sf::Texture& jungleTexture = textures.get(Textures::Jungle);
-  jungleTexture.setRepeated(true);
+  // Without a mission, the tiled background covers the whole world
+  if(!mission.isLoaded())
+  {
+    sf::Texture& jungleTexture = textures.get(Textures::Jungle);
+    jungleTexture.setRepeated(true);
 
-  float viewHeight = worldView.getSize().y;
-  sf::IntRect textureRect(worldBounds);
-  textureRect.height += static_cast<int>(viewHeight);
+    float viewHeight = worldView.getSize().y;
+    sf::IntRect textureRect(worldBounds);
+    textureRect.height += static_cast<int>(viewHeight);
 
-  // Add the background sprite to the scene
-  std::unique_ptr<SceneNode> jungleSprite(new SpriteNode(jungleTexture, textureRect));
-  jungleSprite->setPosition(worldBounds.left, worldBounds.top - viewHeight);
-  sceneLayers[Background]->attachChild(std::move(jungleSprite));
+    std::unique_ptr<SceneNode> jungleSprite(new SpriteNode(jungleTexture, textureRect));
+    jungleSprite->setPosition(worldBounds.left, worldBounds.top - viewHeight);
+    sceneLayers[Background]->attachChild(std::move(jungleSprite));
+  }
 
   // Add the finish line to the scene
   sf::Texture& finishTexture = textures.get(Textures::FinishLine);
-  std::unique_ptr<SpriteNode> finishSprite(new SpriteNode(finishTexture));
-  finishSprite->setPosition(0.f, -76.f);
-  sceneLayers[Background]->attachChild(std::move(finishSprite));
+  sf::IntRect finishRect = TextureAtlas::getInstance().getArea(Textures::FinishLine, finishTexture);
+  std::unique_ptr<SpriteNode> finishSprite(new SpriteNode(finishTexture, finishRect));
+  finishSprite->setPosition(0.f, finishLineY - finishRect.height);
+  sceneLayers[Ground]->attachChild(std::move(finishSprite));
 
   // Add smoke particle node to the scene
   std::unique_ptr<ParticleNode> smokeNode(new ParticleNode(Particle::Smoke, textures));
@@ -355,54 +434,47 @@ void World::buildScene()
     this->networkNode = networkNode.get();
     sceneGraph.attachChild(std::move(networkNode));
   }
-
-  // Add enemy aircraft
-  addEnemies();
 }
 
-void World::addEnemies()
+void World::streamBackgrounds()
 {
-  if(networkedWorld)
-    return;
+  // Segments are attached as the battlefield reaches them
+  float reached = spawnPosition.y - getBattlefieldBounds().top;
+  const std::vector<Mission::Background>& backgrounds = mission.getBackgrounds();
+  while(nextBackground < backgrounds.size() && backgrounds[nextBackground].distance <= reached)
+  {
+    const Mission::Background& background = backgrounds[nextBackground++];
+    sf::Texture& texture = textures.get(background.texture);
+    texture.setRepeated(true);
+
+    BackgroundNode attached;
+    attached.top = spawnPosition.y - background.distance - background.length;
+
+    // Texture rect in world coordinates, so neighbouring segments tile on
+    sf::IntRect textureRect(0, static_cast<int>(attached.top),
+        static_cast<int>(worldBounds.width), static_cast<int>(background.length));
+    std::unique_ptr<SceneNode> sprite(new SpriteNode(texture, textureRect));
+    sprite->setPosition(worldBounds.left, attached.top);
+    attached.node = sprite.get();
+
+    sceneLayers[Background]->attachChild(std::move(sprite));
+    backgroundNodes.push_back(attached);
+  }
 
-  addEnemy(Aircraft::Raptor, 0.f, 500.f);
-  addEnemy(Aircraft::Raptor, 0.f, 1000.f);
-  addEnemy(Aircraft::Raptor, 100.f, 1100.f);
-  addEnemy(Aircraft::Raptor, -100.f, 1100.f);
-  addEnemy(Aircraft::Avenger, 70.f, 1500.f);
-  addEnemy(Aircraft::Avenger, -70.f, 1500.f);
-  addEnemy(Aircraft::Avenger, 70.f, 1710.f);
-  addEnemy(Aircraft::Avenger, -70.f, 1710.f);
-  addEnemy(Aircraft::Avenger, 30.f, 1850.f);
-  addEnemy(Aircraft::Raptor, 300.f, 2200.f);
-  addEnemy(Aircraft::Raptor, -300.f, 2200.f);
-  addEnemy(Aircraft::Raptor, 0.f, 2200.f);
-  addEnemy(Aircraft::Raptor, 0.f, 2500.f);
-  addEnemy(Aircraft::Avenger, -300.f, 2700.f);
-  addEnemy(Aircraft::Avenger, -300.f, 2700.f);
-  addEnemy(Aircraft::Raptor, 0.f, 3000.f);
-  addEnemy(Aircraft::Raptor, 250.f, 3250.f);
-  addEnemy(Aircraft::Raptor, -250.f, 3250.f);
-  addEnemy(Aircraft::Avenger, 0.f, 3500.f);
-  addEnemy(Aircraft::Avenger, 0.f, 3700.f);
-  addEnemy(Aircraft::Raptor, 0.f, 3800.f);
-  addEnemy(Aircraft::Avenger, 0.f, 4000.f);
-  addEnemy(Aircraft::Avenger, -200.f, 4200.f);
-  addEnemy(Aircraft::Raptor, 200.f, 4200.f);
-  addEnemy(Aircraft::Raptor, 0.f, 4400.f);
-
-  sortEnemies();
-}
-
-void World::sortEnemies()
-{
-  // Sort all enemies according to their y value, such that lower enemies are
-  // checked first for spawning
-  std::sort(enemySpawnPoints.begin(), enemySpawnPoints.end(),
-      [] (SpawnPoint lhs, SpawnPoint rhs)
+  // And detached once the view is past them
+  sf::FloatRect viewBounds = getViewBounds();
+  for(auto itr = backgroundNodes.begin(); itr != backgroundNodes.end(); )
+  {
+    if(itr->top > viewBounds.top + viewBounds.height)
+    {
+      sceneLayers[Background]->detachChild(*itr->node);
+      itr = backgroundNodes.erase(itr);
+    }
+    else
     {
-      return lhs.y < rhs.y;
-    });
+      ++itr;
+    }
+  }
 }
 
 void World::addEnemy(Aircraft::Type type, float relX, float relY)
@@ -411,27 +483,60 @@ void World::addEnemy(Aircraft::Type type, float relX, float relY)
   enemySpawnPoints.push_back(spawn);
 }
 
-void World::spawnEnemies()
+void World::scheduleSpawnPoints()
 {
-  // Spawn all enemies entering the view area (including distance) this frame
-  while(!enemySpawnPoints.empty() &&
-      enemySpawnPoints.back().y > getBattlefieldBounds().top)
+  std::size_t added = enemySpawnPoints.size() - scheduledSpawnPoints;
+  if(added == 0)
+    return;
+
+  // Many at once (a wave, a join): rebuilding the heap is linear, cheaper
+  // than pushing them one by one
+  if(added > scheduledSpawnPoints / 8)
   {
-    SpawnPoint spawn = enemySpawnPoints.back();
+    std::make_heap(enemySpawnPoints.begin(), enemySpawnPoints.end(), &SpawnPoint::spawnsLater);
+  }
+  else
+  {
+    for(std::size_t i=scheduledSpawnPoints; i<enemySpawnPoints.size(); ++i)
+      std::push_heap(enemySpawnPoints.begin(), enemySpawnPoints.begin() + i + 1, &SpawnPoint::spawnsLater);
+  }
+
+  scheduledSpawnPoints = enemySpawnPoints.size();
+}
+
+void World::spawnEnemies()
+{
+  float battlefieldTop = getBattlefieldBounds().top;
 
-    std::unique_ptr<Aircraft> enemy(new Aircraft(spawn.type, textures, fonts));
-    enemy->setPosition(spawn.x, spawn.y);
-    enemy->setRotation(180.f);
-    if(networkedWorld)
-      enemy->disablePickups();
+  // Mission spawns are read in as the battlefield reaches them
+  Mission::Spawn spawn;
+  while(mission.pollSpawn(spawnPosition.y - battlefieldTop, spawn))
+    spawnEnemy(SpawnPoint(spawn.type, spawnPosition.x + spawn.x, spawnPosition.y - spawn.distance));
 
-    sceneLayers[UpperAir]->attachChild(std::move(enemy));
+  // Spawn all enemies entering the view area (including distance) this frame
+  scheduleSpawnPoints();
+  while(!enemySpawnPoints.empty() && enemySpawnPoints.front().y > battlefieldTop)
+  {
+    spawnEnemy(enemySpawnPoints.front());
 
     // Enemy is spawned, remove from the list to spawn
+    std::pop_heap(enemySpawnPoints.begin(), enemySpawnPoints.end(), &SpawnPoint::spawnsLater);
     enemySpawnPoints.pop_back();
+    --scheduledSpawnPoints;
   }
 }
 
+void World::spawnEnemy(const SpawnPoint& spawn)
+{
+  std::unique_ptr<Aircraft> enemy(new Aircraft(spawn.type, textures, fonts));
+  enemy->setPosition(spawn.x, spawn.y);
+  enemy->setRotation(180.f);
+  if(networkedWorld)
+    enemy->disablePickups();
+
+  sceneLayers[UpperAir]->attachChild(std::move(enemy));
+}
+
 void World::destroyEntitiesOutsideView()
 {
   Command command;
@@ -5,6 +5,7 @@
 #include "BloomEffect.hpp"
 #include "Command.hpp"
 #include "CommandQueue.hpp"
+#include "Mission.hpp"
 #include "NetworkProtocol.hpp"
 #include "Pickup.hpp"
 #include "ResourceHolder.hpp"
@@ -19,6 +20,7 @@
 
 #include <array>
 #include <queue>
+#include <string>
 #include <vector>
 
 // Forward declaration of SFML classes
@@ -34,6 +36,11 @@ class World : private sf::NonCopyable
   public:
     explicit World(sf::RenderTarget& outputTarget, FontHolder& fonts,
         SoundPlayer& sounds, bool networked = false);
+    ~World();
+
+    // Starts loading what a World needs in the background, so constructing
+    // one later does not stall
+    static void prefetchResources();
 
     void update(sf::Time dt);
     void draw();
@@ -45,13 +52,14 @@ class World : private sf::NonCopyable
     void setCurrentBattleFieldPosition(float lineY);
     void setWorldHeight(float height);
 
+    // Cheap to call for many enemies in a row, they are put in spawn order
+    // together on the next update
     void addEnemy(Aircraft::Type type, float relX, float relY);
-    void sortEnemies();
 
     bool hasAlivePlayer() const;
     bool hasPlayerReachedEnd() const;
 
-    void setWorldScrollCompensation(float compensation);
+    void setBattleFieldTime(sf::Time serverTime);
 
     Aircraft* getAircraft(int identifier) const;
     sf::FloatRect getBattlefieldBounds() const;
@@ -63,6 +71,7 @@ class World : private sf::NonCopyable
     enum Layer
     {
       Background,
+      Ground,
       LowerAir,
       UpperAir,
       LayerCount
@@ -80,6 +89,19 @@ class World : private sf::NonCopyable
       Aircraft::Type type;
       float x;
       float y;
+
+      // Heap order, the lowest spawn point comes first
+      static bool spawnsLater(const SpawnPoint& lhs, const SpawnPoint& rhs)
+      {
+        return lhs.y < rhs.y;
+      }
+    };
+
+    // Attached background segment, detached once the view has passed it
+    struct BackgroundNode
+    {
+      SceneNode* node;
+      float top;
     };
 
     sf::RenderTarget& target;
@@ -96,26 +118,36 @@ class World : private sf::NonCopyable
     sf::FloatRect worldBounds;
     sf::Vector2f spawnPosition;
     float scrollSpeed;
-    float scrollSpeedCompensation;
     std::vector<Aircraft*> playerAircrafts;
 
+    // Heap up to scheduledSpawnPoints, added ones after it
     std::vector<SpawnPoint> enemySpawnPoints;
+    std::size_t scheduledSpawnPoints;
     std::vector<Aircraft*> activeEnemies;
 
+    Mission mission;
+    std::size_t nextBackground;
+    std::vector<BackgroundNode> backgroundNodes;
+    float finishLineY;
+
     BloomEffect bloomEffect;
 
     bool networkedWorld;
     NetworkNode* networkNode;
 
     void loadTextures();
+    void prefetchSounds();
     void adaptPlayerPosition();
     void adaptPlayerVelocity();
     void handleCollisions();
     void updateSounds();
 
+    void loadMission(const std::string& filename);
     void buildScene();
-    void addEnemies();
+    void streamBackgrounds();
+    void scheduleSpawnPoints();
     void spawnEnemies();
+    void spawnEnemy(const SpawnPoint& spawn);
     void destroyEntitiesOutsideView();
     void guideMissiles();
 
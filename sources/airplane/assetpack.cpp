@@ -0,0 +1,160 @@
+#include "AssetPack.hpp"
+#include "Compression.hpp"
+#include "Foreach.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Builds the archive AssetPack maps at startup from a list of files, stored
+// under the names given on the command line. From the game directory:
+//   assetpack assets.pack assets/*/*
+namespace
+{
+  struct PackedFile
+  {
+    PackedFile() :
+      name(),
+      data(),
+      rawSize(0),
+      offset(0),
+      compressed(false)
+    {
+    }
+
+    std::string name;
+    std::vector<char> data;
+    std::size_t rawSize;
+    std::size_t offset;
+    bool compressed;
+  };
+
+  void printUsage()
+  {
+    std::cout << "usage: assetpack <output> [--store] file...\n"
+              << "  --store  never compress, every entry is loaded straight from the mapping\n"
+              << "  files are stored under the path given, run from the game directory\n";
+  }
+
+  void write(std::vector<char>& output, sf::Uint32 value, std::size_t bytes)
+  {
+    for(std::size_t i=0; i<bytes; ++i)
+      output.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+
+  bool readFile(const std::string& filename, std::vector<char>& contents)
+  {
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if(!file)
+      return false;
+
+    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+  }
+
+  // Compressed only when it pays: PNG and OGG files are compressed already
+  // and are better left in place for zero-copy loading
+  void pack(PackedFile& file, bool allowCompression)
+  {
+    file.rawSize = file.data.size();
+    file.compressed = false;
+    if(!allowCompression)
+      return;
+
+    std::vector<char> compressed = Compression::compress(file.data.data(), file.data.size());
+    if(compressed.size() < file.rawSize - file.rawSize / 8)
+    {
+      file.data.swap(compressed);
+      file.compressed = true;
+    }
+  }
+
+  std::size_t align(std::size_t offset)
+  {
+    const std::size_t alignment = AssetPack::Alignment;
+    return (offset + alignment - 1) / alignment * alignment;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if(argc < 3)
+  {
+    printUsage();
+    return 1;
+  }
+
+  std::string output = argv[1];
+  bool allowCompression = true;
+  std::vector<PackedFile> files;
+
+  for(int i=2; i<argc; ++i)
+  {
+    std::string argument = argv[i];
+    if(argument == "--store")
+    {
+      allowCompression = false;
+      continue;
+    }
+
+    PackedFile file;
+    file.name = argument;
+    if(!readFile(argument, file.data))
+    {
+      std::cout << "Could not read " << argument << std::endl;
+      return 1;
+    }
+    files.push_back(file);
+  }
+
+  // Index size first, the entry offsets depend on it
+  std::size_t indexSize = sizeof(AssetPack::Magic) + 1 + 4;
+  FOREACH(PackedFile& file, files)
+  {
+    pack(file, allowCompression);
+    indexSize += 2 + file.name.size() + 4 + 4 + 4 + 1;
+  }
+
+  std::size_t offset = align(indexSize);
+  FOREACH(PackedFile& file, files)
+  {
+    file.offset = offset;
+    offset = align(offset + file.data.size());
+  }
+
+  std::vector<char> contents(AssetPack::Magic, AssetPack::Magic + sizeof(AssetPack::Magic));
+  write(contents, AssetPack::Version, 1);
+  write(contents, static_cast<sf::Uint32>(files.size()), 4);
+  FOREACH(const PackedFile& file, files)
+  {
+    write(contents, static_cast<sf::Uint32>(file.name.size()), 2);
+    contents.insert(contents.end(), file.name.begin(), file.name.end());
+    write(contents, static_cast<sf::Uint32>(file.offset), 4);
+    write(contents, static_cast<sf::Uint32>(file.data.size()), 4);
+    write(contents, static_cast<sf::Uint32>(file.rawSize), 4);
+    write(contents, file.compressed ? AssetPack::Compressed : 0, 1);
+  }
+
+  FOREACH(const PackedFile& file, files)
+  {
+    contents.resize(file.offset, 0);
+    contents.insert(contents.end(), file.data.begin(), file.data.end());
+
+    std::cout << file.name << ": " << file.rawSize << " bytes";
+    if(file.compressed)
+      std::cout << ", compressed to " << file.data.size();
+    std::cout << "\n";
+  }
+
+  std::ofstream stream(output.c_str(), std::ios::binary);
+  if(!stream.write(contents.data(), contents.size()))
+  {
+    std::cout << "Could not write " << output << std::endl;
+    return 1;
+  }
+
+  std::cout << files.size() << " files, " << contents.size() << " bytes written to " << output << std::endl;
+  return 0;
+}
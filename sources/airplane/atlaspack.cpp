@@ -0,0 +1,236 @@
+#include "Foreach.hpp"
+
+#include <SFML/Graphics/Image.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Packs textures into as few atlases as fit, and writes the remap table
+// TextureAtlas reads to find them there. Run from the game directory, so
+// the table holds the paths the game loads:
+//   atlaspack assets/textures/Atlas.txt assets/textures/Atlas
+//     assets/textures/{Entities,Explosion,Particle,FinishLine}.png
+// writes the table and assets/textures/Atlas0.png, Atlas1.png, ...
+//
+// Textures are packed whole: animations and roll frames are laid out
+// inside their texture, only the texture as a unit can move. Textures
+// drawn repeated (the jungle) cannot be packed at all.
+namespace
+{
+  struct Options
+  {
+    Options() :
+      tableFile(),
+      atlasPrefix(),
+      textureFiles(),
+      maxSize(2048),
+      padding(2)
+    {
+    }
+
+    std::string tableFile;
+    std::string atlasPrefix;
+    std::vector<std::string> textureFiles;
+    unsigned int maxSize;
+    unsigned int padding;
+  };
+
+  struct Item
+  {
+    std::string filename;
+    sf::Image image;
+    std::size_t atlas;
+    unsigned int left;
+    unsigned int top;
+  };
+
+  // Row of items as high as the first (highest) one placed in it
+  struct Shelf
+  {
+    unsigned int top;
+    unsigned int height;
+    unsigned int used;
+  };
+
+  struct Atlas
+  {
+    Atlas() :
+      shelves(),
+      width(0),
+      height(0)
+    {
+    }
+
+    std::vector<Shelf> shelves;
+    unsigned int width;
+    unsigned int height;
+  };
+
+  void printUsage()
+  {
+    std::cout << "usage: atlaspack [--size n] [--padding n] <table> <atlas prefix> texture...\n"
+              << "  --size     largest atlas side in pixels (default 2048)\n"
+              << "  --padding  transparent pixels between two textures (default 2)\n";
+  }
+
+  bool parseOptions(int argc, char* argv[], Options& options)
+  {
+    std::vector<std::string> positional;
+    for(int i=1; i<argc; ++i)
+    {
+      std::string argument = argv[i];
+      if(argument == "--size" && i + 1 < argc)
+        options.maxSize = static_cast<unsigned int>(std::atoi(argv[++i]));
+      else if(argument == "--padding" && i + 1 < argc)
+        options.padding = static_cast<unsigned int>(std::atoi(argv[++i]));
+      else
+        positional.push_back(argument);
+    }
+
+    if(positional.size() < 3 || options.maxSize == 0)
+      return false;
+
+    options.tableFile = positional[0];
+    options.atlasPrefix = positional[1];
+    options.textureFiles.assign(positional.begin() + 2, positional.end());
+    return true;
+  }
+
+  // First shelf with room, else a new shelf, else false
+  bool place(Atlas& atlas, Item& item, const Options& options)
+  {
+    sf::Vector2u size = item.image.getSize();
+    unsigned int width = size.x + options.padding;
+    unsigned int height = size.y + options.padding;
+
+    FOREACH(Shelf& shelf, atlas.shelves)
+    {
+      if(height <= shelf.height && shelf.used + size.x <= options.maxSize)
+      {
+        item.left = shelf.used;
+        item.top = shelf.top;
+        shelf.used += width;
+        atlas.width = std::max(atlas.width, item.left + size.x);
+        return true;
+      }
+    }
+
+    unsigned int top = atlas.shelves.empty() ? 0 : atlas.shelves.back().top + atlas.shelves.back().height;
+    if(top + size.y > options.maxSize || size.x > options.maxSize)
+      return false;
+
+    Shelf shelf;
+    shelf.top = top;
+    shelf.height = height;
+    shelf.used = width;
+    atlas.shelves.push_back(shelf);
+
+    item.left = 0;
+    item.top = top;
+    atlas.width = std::max(atlas.width, size.x);
+    atlas.height = std::max(atlas.height, top + size.y);
+    return true;
+  }
+
+  std::string atlasFile(const Options& options, std::size_t index)
+  {
+    return options.atlasPrefix + std::to_string(index) + ".png";
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  Options options;
+  if(!parseOptions(argc, argv, options))
+  {
+    printUsage();
+    return 1;
+  }
+
+  std::vector<Item> items(options.textureFiles.size());
+  for(std::size_t i=0; i<items.size(); ++i)
+  {
+    items[i].filename = options.textureFiles[i];
+    if(!items[i].image.loadFromFile(items[i].filename))
+    {
+      std::cout << "Could not load " << items[i].filename << std::endl;
+      return 1;
+    }
+  }
+
+  // Highest first keeps the shelves full
+  std::vector<Item*> order;
+  FOREACH(Item& item, items)
+    order.push_back(&item);
+  std::stable_sort(order.begin(), order.end(), [] (const Item* a, const Item* b)
+  {
+    return a->image.getSize().y > b->image.getSize().y;
+  });
+
+  std::vector<Atlas> atlases;
+  FOREACH(Item* item, order)
+  {
+    bool placed = false;
+    for(std::size_t i=0; i<atlases.size() && !placed; ++i)
+    {
+      if(place(atlases[i], *item, options))
+      {
+        item->atlas = i;
+        placed = true;
+      }
+    }
+
+    if(!placed)
+    {
+      atlases.push_back(Atlas());
+      item->atlas = atlases.size() - 1;
+
+      if(!place(atlases.back(), *item, options))
+      {
+        std::cout << item->filename << " is larger than " << options.maxSize << " pixels" << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  std::ofstream table(options.tableFile.c_str());
+  table << "# texture atlas left top width height\n";
+
+  for(std::size_t i=0; i<atlases.size(); ++i)
+  {
+    sf::Image image;
+    image.create(atlases[i].width, atlases[i].height, sf::Color::Transparent);
+
+    FOREACH(const Item& item, items)
+    {
+      if(item.atlas != i)
+        continue;
+
+      image.copy(item.image, item.left, item.top);
+      sf::Vector2u size = item.image.getSize();
+      table << item.filename << " " << atlasFile(options, i) << " "
+            << item.left << " " << item.top << " " << size.x << " " << size.y << "\n";
+    }
+
+    if(!image.saveToFile(atlasFile(options, i)))
+    {
+      std::cout << "Could not write " << atlasFile(options, i) << std::endl;
+      return 1;
+    }
+
+    std::cout << atlasFile(options, i) << ": " << atlases[i].width << "x" << atlases[i].height << "\n";
+  }
+
+  if(!table)
+  {
+    std::cout << "Could not write " << options.tableFile << std::endl;
+    return 1;
+  }
+
+  std::cout << items.size() << " textures packed into " << atlases.size() << " atlases" << std::endl;
+  return 0;
+}
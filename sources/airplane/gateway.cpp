@@ -0,0 +1,287 @@
+#include "NetworkProtocol.hpp"
+
+#include <SFML/Network/IpAddress.hpp>
+#include <SFML/Network/Packet.hpp>
+#include <SFML/Network/TcpListener.hpp>
+#include <SFML/Network/TcpSocket.hpp>
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Sleep.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Front door for several game server processes: clients connect here on the
+// game port and are redirected to the least loaded server, which they then
+// talk to directly, so the gateway never relays game traffic. Servers started
+// with --gateway register themselves and report their load every second.
+//
+// Everything on one machine:
+//   gateway
+//   server --port 5010 --spectator-port 5011 --gateway 127.0.0.1
+//   server --port 5020 --spectator-port 5021 --gateway 127.0.0.1
+namespace
+{
+  // A server that stops reporting is considered gone
+  const sf::Time ReportTimeout = sf::seconds(5.f);
+
+  // Clients are left to close the connection after a redirect, closing it
+  // first could reset it before the client read the redirect
+  const sf::Time RedirectLingerTime = sf::seconds(10.f);
+
+  struct Settings
+  {
+    Settings() :
+      clientPort(serverPort),
+      backendPort(gatewayPort)
+    {
+    }
+
+    unsigned short clientPort;
+    unsigned short backendPort;
+  };
+
+  struct BackendServer
+  {
+    BackendServer() :
+      socket(new sf::TcpSocket()),
+      port(0),
+      players(0),
+      maxPlayers(0),
+      assigned(0),
+      lastReportTime(sf::Time::Zero)
+    {
+    }
+
+    // Clients redirected since the last report count as well, so a burst
+    // of connections is spread instead of piling onto one server
+    float getLoad() const
+    {
+      return static_cast<float>(players + assigned) / static_cast<float>(maxPlayers);
+    }
+
+    bool isAvailable() const
+    {
+      return port != 0 && players + assigned < maxPlayers;
+    }
+
+    std::unique_ptr<sf::TcpSocket> socket;
+    unsigned short port;
+    sf::Uint32 players;
+    sf::Uint32 maxPlayers;
+    sf::Uint32 assigned;
+    sf::Time lastReportTime;
+  };
+
+  struct RedirectedClient
+  {
+    std::unique_ptr<sf::TcpSocket> socket;
+    sf::Time redirectTime;
+  };
+
+  typedef std::unique_ptr<BackendServer> BackendPtr;
+
+  void printUsage()
+  {
+    std::cout << "usage: gateway [--port n] [--backend-port n]\n"
+              << "  --port          port clients connect to (default 5000)\n"
+              << "  --backend-port  port game servers report their load to (default 5003)\n";
+  }
+
+  bool parseOptions(int argc, char* argv[], Settings& settings)
+  {
+    for(int i=1; i<argc; ++i)
+    {
+      std::string argument = argv[i];
+      if(i + 1 >= argc)
+        return false;
+
+      const char* value = argv[++i];
+      if(argument == "--port")
+        settings.clientPort = static_cast<unsigned short>(std::atoi(value));
+      else if(argument == "--backend-port")
+        settings.backendPort = static_cast<unsigned short>(std::atoi(value));
+      else
+        return false;
+    }
+
+    return settings.clientPort != 0 && settings.backendPort != 0;
+  }
+
+  std::string describe(const BackendServer& backend)
+  {
+    return backend.socket->getRemoteAddress().toString() + ":" + std::to_string(backend.port);
+  }
+
+  // Reads the pending load reports, false once the server is gone
+  bool readReports(BackendServer& backend, sf::Time now)
+  {
+    sf::Packet packet;
+    sf::Socket::Status status;
+    while((status = backend.socket->receive(packet)) == sf::Socket::Done)
+    {
+      sf::Int32 packetType;
+      sf::Uint16 port;
+      sf::Uint32 players;
+      sf::Uint32 maxPlayers;
+      packet >> packetType >> port >> players >> maxPlayers;
+
+      if(packet && packetType == Backend::LoadReport && maxPlayers > 0)
+      {
+        if(backend.port == 0)
+          std::cout << "Server " << backend.socket->getRemoteAddress().toString() << ":" << port
+                    << " registered, " << maxPlayers << " players" << std::endl;
+
+        backend.port = port;
+        backend.players = players;
+        backend.maxPlayers = maxPlayers;
+        backend.assigned = 0;
+        backend.lastReportTime = now;
+      }
+      packet.clear();
+    }
+
+    return status != sf::Socket::Disconnected && status != sf::Socket::Error &&
+      now < backend.lastReportTime + ReportTimeout;
+  }
+
+  BackendServer* findLeastLoaded(std::vector<BackendPtr>& backends)
+  {
+    BackendServer* best = nullptr;
+    for(std::size_t i=0; i<backends.size(); ++i)
+    {
+      BackendServer& backend = *backends[i];
+      if(backend.isAvailable() && (!best || backend.getLoad() < best->getLoad()))
+        best = &backend;
+    }
+    return best;
+  }
+
+  bool redirect(sf::TcpSocket& client, const BackendServer& backend)
+  {
+    // A server on the gateway machine is reached on the address the client
+    // used for the gateway, its loopback address means nothing to the client
+    sf::IpAddress address = backend.socket->getRemoteAddress();
+    std::string redirectAddress = (address == sf::IpAddress::LocalHost) ? std::string() : address.toString();
+
+    sf::Packet packet;
+    packet << static_cast<sf::Int32>(Server::Redirect);
+    packet << redirectAddress;
+    packet << static_cast<sf::Uint16>(backend.port);
+
+    // Still blocking, the message is tiny and the socket fresh
+    return client.send(packet) == sf::Socket::Done;
+  }
+
+  // The client shows the reason instead of retrying a silent disconnect
+  void reject(sf::TcpSocket& client, const std::string& reason)
+  {
+    sf::Packet packet;
+    packet << static_cast<sf::Int32>(Server::Reject);
+    packet << reason;
+
+    client.send(packet);
+    client.disconnect();
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  Settings settings;
+  if(!parseOptions(argc, argv, settings))
+  {
+    printUsage();
+    return 1;
+  }
+
+  sf::TcpListener clientListener;
+  sf::TcpListener backendListener;
+  if(clientListener.listen(settings.clientPort) != sf::Socket::Done ||
+      backendListener.listen(settings.backendPort) != sf::Socket::Done)
+  {
+    std::cout << "Could not listen on ports " << settings.clientPort
+              << " and " << settings.backendPort << std::endl;
+    return 1;
+  }
+  clientListener.setBlocking(false);
+  backendListener.setBlocking(false);
+
+  std::cout << "Gateway taking clients on port " << settings.clientPort
+            << ", servers on port " << settings.backendPort << std::endl;
+
+  std::vector<BackendPtr> backends;
+  std::vector<RedirectedClient> clients;
+  BackendPtr pendingBackend(new BackendServer());
+  std::unique_ptr<sf::TcpSocket> pendingClient(new sf::TcpSocket());
+  sf::Clock clock;
+
+  while(true)
+  {
+    sf::Time now = clock.getElapsedTime();
+
+    // New servers, they count once their first report arrives
+    if(backendListener.accept(*pendingBackend->socket) == sf::Socket::Done)
+    {
+      pendingBackend->socket->setBlocking(false);
+      pendingBackend->lastReportTime = now;
+      backends.push_back(std::move(pendingBackend));
+      pendingBackend.reset(new BackendServer());
+    }
+
+    for(auto itr = backends.begin(); itr != backends.end();)
+    {
+      if(readReports(**itr, now))
+      {
+        ++itr;
+        continue;
+      }
+
+      if((*itr)->port != 0)
+        std::cout << "Server " << describe(**itr) << " is gone" << std::endl;
+      itr = backends.erase(itr);
+    }
+
+    // New clients are sent on right away
+    if(clientListener.accept(*pendingClient) == sf::Socket::Done)
+    {
+      BackendServer* backend = findLeastLoaded(backends);
+      if(backend && redirect(*pendingClient, *backend))
+      {
+        backend->assigned++;
+        pendingClient->setBlocking(false);
+
+        RedirectedClient client;
+        client.socket = std::move(pendingClient);
+        client.redirectTime = now;
+        clients.push_back(std::move(client));
+      }
+      else
+      {
+        std::cout << "No server available, rejecting client" << std::endl;
+        reject(*pendingClient, "No game server available");
+      }
+      pendingClient.reset(new sf::TcpSocket());
+    }
+
+    // Whatever a client sends before it follows the redirect is discarded
+    for(auto itr = clients.begin(); itr != clients.end();)
+    {
+      sf::Packet packet;
+      sf::Socket::Status status;
+      while((status = itr->socket->receive(packet)) == sf::Socket::Done)
+        packet.clear();
+
+      if(status == sf::Socket::Disconnected || status == sf::Socket::Error ||
+          now >= itr->redirectTime + RedirectLingerTime)
+        itr = clients.erase(itr);
+      else
+        ++itr;
+    }
+
+    sf::sleep(sf::milliseconds(10));
+  }
+
+  return 0;
+}
@@ -0,0 +1,178 @@
+#include "Mission.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Compiles a mission source into the file World streams its level from.
+// From the game directory:
+//   missionc assets/missions/Mission1.txt assets/missions/Mission1.mission
+//
+// The source has one statement per line, '#' starts a comment:
+//   height <world height>
+//   finish <distance>
+//   background <texture> <distance> <length>
+//   enemy <type> <x> <distance>
+// Distances count up from the player spawn position, x from the middle of
+// the world. Statements may come in any order, the compiler sorts them.
+namespace
+{
+  struct Name
+  {
+    const char* name;
+    unsigned int value;
+  };
+
+  // Textures drawn repeated, the only ones a background can use
+  const Name BackgroundTextures[] =
+  {
+    { "Jungle", Textures::Jungle }
+  };
+
+  const Name EnemyTypes[] =
+  {
+    { "Raptor", Aircraft::Raptor },
+    { "Avenger", Aircraft::Avenger }
+  };
+
+  template <std::size_t Count>
+  bool lookup(const Name (&names)[Count], const std::string& name, unsigned int& value)
+  {
+    for(std::size_t i=0; i<Count; ++i)
+    {
+      if(name == names[i].name)
+      {
+        value = names[i].value;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  struct Source
+  {
+    Source() :
+      height(0.f),
+      finish(0.f),
+      backgrounds(),
+      spawns()
+    {
+    }
+
+    float height;
+    float finish;
+    std::vector<Mission::Background> backgrounds;
+    std::vector<Mission::Spawn> spawns;
+  };
+
+  void printUsage()
+  {
+    std::cout << "usage: missionc <source> <output>\n"
+              << "  compiles a mission source, see missionc.cpp for its statements\n";
+  }
+
+  bool fail(const std::string& filename, std::size_t line, const std::string& message)
+  {
+    std::cout << filename << ":" << line << ": " << message << std::endl;
+    return false;
+  }
+
+  bool parse(const std::string& filename, Source& source)
+  {
+    std::ifstream file(filename.c_str());
+    if(!file)
+    {
+      std::cout << "Could not read " << filename << std::endl;
+      return false;
+    }
+
+    bool hasHeight = false;
+    bool hasFinish = false;
+    std::string text;
+    for(std::size_t line=1; std::getline(file, text); ++line)
+    {
+      std::istringstream statement(text.substr(0, text.find('#')));
+      std::string keyword;
+      if(!(statement >> keyword))
+        continue;
+
+      std::string name;
+      unsigned int value;
+      if(keyword == "height" && statement >> source.height)
+      {
+        hasHeight = true;
+      }
+      else if(keyword == "finish" && statement >> source.finish)
+      {
+        hasFinish = true;
+      }
+      else if(keyword == "background" && statement >> name)
+      {
+        Mission::Background background;
+        if(!lookup(BackgroundTextures, name, value))
+          return fail(filename, line, "no repeated texture " + name);
+        if(!(statement >> background.distance >> background.length) || background.length <= 0.f)
+          return fail(filename, line, "expected background <texture> <distance> <length>");
+
+        background.texture = static_cast<Textures::ID>(value);
+        source.backgrounds.push_back(background);
+      }
+      else if(keyword == "enemy" && statement >> name)
+      {
+        Mission::Spawn spawn;
+        if(!lookup(EnemyTypes, name, value))
+          return fail(filename, line, "no enemy type " + name);
+        if(!(statement >> spawn.x >> spawn.distance))
+          return fail(filename, line, "expected enemy <type> <x> <distance>");
+
+        spawn.type = static_cast<Aircraft::Type>(value);
+        source.spawns.push_back(spawn);
+      }
+      else
+      {
+        return fail(filename, line, "cannot read '" + text + "'");
+      }
+
+      std::string rest;
+      if(statement >> rest)
+        return fail(filename, line, "unexpected '" + rest + "'");
+    }
+
+    if(!hasHeight || !hasFinish)
+      return fail(filename, 0, "height and finish are required");
+
+    return true;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if(argc != 3)
+  {
+    printUsage();
+    return 1;
+  }
+
+  Source source;
+  if(!parse(argv[1], source))
+    return 1;
+
+  std::vector<char> contents;
+  Mission::encode(source.height, source.finish, source.backgrounds, source.spawns, contents);
+
+  std::ofstream stream(argv[2], std::ios::binary);
+  if(!stream.write(contents.data(), contents.size()))
+  {
+    std::cout << "Could not write " << argv[2] << std::endl;
+    return 1;
+  }
+
+  const std::size_t chunkSize = Mission::ChunkSize;
+  std::size_t chunkCount = (source.spawns.size() + chunkSize - 1) / chunkSize;
+  std::cout << source.spawns.size() << " spawns in " << chunkCount << " chunks, "
+            << source.backgrounds.size() << " backgrounds, " << contents.size()
+            << " bytes written to " << argv[2] << std::endl;
+  return 0;
+}
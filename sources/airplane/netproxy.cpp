@@ -0,0 +1,420 @@
+#include "NetworkProtocol.hpp"
+
+#include <SFML/Network/IpAddress.hpp>
+#include <SFML/Network/TcpListener.hpp>
+#include <SFML/Network/TcpSocket.hpp>
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Sleep.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Relay between game clients and a GameServer that impairs the traffic:
+// latency, jitter, bandwidth cap, reordering and loss. The game speaks TCP,
+// so impairments are applied per message (SFML packet frame) instead of per
+// IP packet. Timing statistics are written as CSV for automated scoring.
+namespace
+{
+  // Time the server has to accept the relayed connection of a new client
+  const sf::Time ConnectTimeout = sf::seconds(5.f);
+
+  struct Settings
+  {
+    Settings() :
+      listenPort(serverPort + 1),
+      targetAddress("127.0.0.1"),
+      targetPort(serverPort),
+      latency(sf::Time::Zero),
+      jitter(sf::Time::Zero),
+      bandwidth(0.f),
+      loss(0.f),
+      reorder(0.f),
+      statsInterval(sf::seconds(1.f)),
+      csvFile(),
+      seed(static_cast<unsigned int>(std::time(nullptr)))
+    {
+    }
+
+    unsigned short listenPort;
+    std::string targetAddress;
+    unsigned short targetPort;
+    sf::Time latency;
+    sf::Time jitter;
+    float bandwidth;
+    float loss;
+    float reorder;
+    sf::Time statsInterval;
+    std::string csvFile;
+    unsigned int seed;
+  };
+
+  // Timing statistics of one direction over one reporting interval
+  struct DirectionStats
+  {
+    DirectionStats() :
+      messages(0),
+      bytes(0),
+      dropped(0),
+      reordered(0),
+      delaySum(0.0),
+      delaySquareSum(0.0),
+      minDelay(0.0),
+      maxDelay(0.0)
+    {
+    }
+
+    void recordDelivery(std::size_t size, sf::Time delay)
+    {
+      double milliseconds = delay.asMicroseconds() / 1000.0;
+      minDelay = (messages == 0) ? milliseconds : std::min(minDelay, milliseconds);
+      maxDelay = std::max(maxDelay, milliseconds);
+      delaySum += milliseconds;
+      delaySquareSum += milliseconds * milliseconds;
+      messages++;
+      bytes += size;
+    }
+
+    sf::Uint64 messages;
+    sf::Uint64 bytes;
+    sf::Uint64 dropped;
+    sf::Uint64 reordered;
+    double delaySum;
+    double delaySquareSum;
+    double minDelay;
+    double maxDelay;
+  };
+
+  // A message waiting in the impaired link
+  struct Frame
+  {
+    sf::Time receiveTime;
+    std::vector<char> bytes;
+  };
+
+  // One direction of a relayed connection
+  class Pipe : private sf::NonCopyable
+  {
+    public:
+      Pipe(const Settings& settings, std::mt19937& random, DirectionStats& stats) :
+        settings(settings),
+        random(random),
+        stats(stats),
+        inBuffer(),
+        scheduled(),
+        outBuffer(),
+        lastInOrderTime(sf::Time::Zero),
+        linkFreeTime(sf::Time::Zero)
+      {
+      }
+
+      // Returns false once the source has disconnected
+      bool receive(sf::TcpSocket& source, sf::Time now)
+      {
+        char buffer[4096];
+        std::size_t received = 0;
+        sf::Socket::Status status;
+        while((status = source.receive(buffer, sizeof(buffer), received)) == sf::Socket::Done)
+          inBuffer.insert(inBuffer.end(), buffer, buffer + received);
+
+        // Cut complete frames: [Uint32 big endian size] [data]
+        while(inBuffer.size() >= 4)
+        {
+          const unsigned char* header = reinterpret_cast<const unsigned char*>(&inBuffer[0]);
+          std::size_t size = 4 + ((static_cast<std::size_t>(header[0]) << 24) |
+              (static_cast<std::size_t>(header[1]) << 16) |
+              (static_cast<std::size_t>(header[2]) << 8) |
+              static_cast<std::size_t>(header[3]));
+          if(inBuffer.size() < size)
+            break;
+
+          Frame frame;
+          frame.receiveTime = now;
+          frame.bytes.assign(inBuffer.begin(), inBuffer.begin() + size);
+          inBuffer.erase(inBuffer.begin(), inBuffer.begin() + size);
+          schedule(frame, now);
+        }
+
+        return status != sf::Socket::Disconnected && status != sf::Socket::Error;
+      }
+
+      // Returns false once the destination has disconnected
+      bool deliver(sf::TcpSocket& destination, sf::Time now)
+      {
+        while(!scheduled.empty() && scheduled.begin()->first <= now)
+        {
+          const Frame& frame = scheduled.begin()->second;
+          outBuffer.insert(outBuffer.end(), frame.bytes.begin(), frame.bytes.end());
+          stats.recordDelivery(frame.bytes.size(), now - frame.receiveTime);
+          scheduled.erase(scheduled.begin());
+        }
+
+        if(outBuffer.empty())
+          return true;
+
+        std::size_t sent = 0;
+        sf::Socket::Status status = destination.send(&outBuffer[0], outBuffer.size(), sent);
+        outBuffer.erase(outBuffer.begin(), outBuffer.begin() + sent);
+
+        return status != sf::Socket::Disconnected && status != sf::Socket::Error;
+      }
+
+    private:
+      const Settings& settings;
+      std::mt19937& random;
+      DirectionStats& stats;
+
+      std::vector<char> inBuffer;
+      std::multimap<sf::Time, Frame> scheduled;
+      std::vector<char> outBuffer;
+      sf::Time lastInOrderTime;
+      sf::Time linkFreeTime;
+
+      float chance()
+      {
+        return std::uniform_real_distribution<float>(0.f, 1.f)(random);
+      }
+
+      void schedule(const Frame& frame, sf::Time now)
+      {
+        if(chance() < settings.loss)
+        {
+          stats.dropped++;
+          return;
+        }
+
+        // Base latency plus uniform jitter
+        float jitter = std::uniform_real_distribution<float>(-1.f, 1.f)(random);
+        sf::Time delivery = now + settings.latency + settings.jitter * jitter;
+        if(delivery < now)
+          delivery = now;
+
+        // Bandwidth cap: the message occupies the link for size / bandwidth
+        if(settings.bandwidth > 0.f)
+        {
+          sf::Time start = std::max(now, linkFreeTime);
+          linkFreeTime = start + sf::seconds(frame.bytes.size() / settings.bandwidth);
+          delivery = std::max(delivery, linkFreeTime);
+        }
+
+        // Reordered messages are held back so later ones overtake them, all
+        // others keep their order like on a real TCP stream
+        if(chance() < settings.reorder)
+        {
+          delivery += std::max(settings.jitter * 2.f, sf::milliseconds(20));
+          stats.reordered++;
+        }
+        else
+        {
+          delivery = std::max(delivery, lastInOrderTime);
+          lastInOrderTime = delivery;
+        }
+
+        scheduled.insert(std::make_pair(delivery, frame));
+      }
+  };
+
+  // A client connection and its counterpart to the server
+  struct Link : private sf::NonCopyable
+  {
+    Link(const Settings& settings, std::mt19937& random, DirectionStats& upStats, DirectionStats& downStats) :
+      client(),
+      server(),
+      connectDeadline(sf::Time::Zero),
+      upstream(settings, random, upStats),
+      downstream(settings, random, downStats)
+    {
+    }
+
+    sf::TcpSocket client;
+    sf::TcpSocket server;
+    sf::Time connectDeadline;
+    Pipe upstream;
+    Pipe downstream;
+  };
+
+  void printUsage()
+  {
+    std::cout << "usage: netproxy [--listen port] [--target ip:port] [--latency ms]\n"
+              << "                [--jitter ms] [--bandwidth bytes/s] [--loss ratio]\n"
+              << "                [--reorder ratio] [--interval s] [--csv file] [--seed n]\n"
+              << "Point clients at the listen port (assets/config/ip.txt accepts ip:port).\n";
+  }
+
+  bool parseOptions(int argc, char* argv[], Settings& settings)
+  {
+    for(int i=1; i<argc; ++i)
+    {
+      std::string argument = argv[i];
+      if(i + 1 >= argc)
+        return false;
+
+      std::string value = argv[++i];
+      if(argument == "--listen")
+        settings.listenPort = static_cast<unsigned short>(std::atoi(value.c_str()));
+      else if(argument == "--target")
+      {
+        std::string::size_type separator = value.find(':');
+        settings.targetAddress = value.substr(0, separator);
+        if(separator != std::string::npos)
+          settings.targetPort = static_cast<unsigned short>(std::atoi(value.c_str() + separator + 1));
+      }
+      else if(argument == "--latency")
+        settings.latency = sf::milliseconds(std::atoi(value.c_str()));
+      else if(argument == "--jitter")
+        settings.jitter = sf::milliseconds(std::atoi(value.c_str()));
+      else if(argument == "--bandwidth")
+        settings.bandwidth = static_cast<float>(std::atof(value.c_str()));
+      else if(argument == "--loss")
+        settings.loss = static_cast<float>(std::atof(value.c_str()));
+      else if(argument == "--reorder")
+        settings.reorder = static_cast<float>(std::atof(value.c_str()));
+      else if(argument == "--interval")
+        settings.statsInterval = sf::seconds(static_cast<float>(std::atof(value.c_str())));
+      else if(argument == "--csv")
+        settings.csvFile = value;
+      else if(argument == "--seed")
+        settings.seed = static_cast<unsigned int>(std::atoi(value.c_str()));
+      else
+        return false;
+    }
+
+    return settings.statsInterval > sf::Time::Zero;
+  }
+
+  void writeStats(std::ostream& out, sf::Time now, const char* direction, const DirectionStats& stats)
+  {
+    double mean = (stats.messages > 0) ? stats.delaySum / stats.messages : 0.0;
+    double variance = (stats.messages > 0) ? stats.delaySquareSum / stats.messages - mean * mean : 0.0;
+
+    out << now.asSeconds() << "," << direction << ","
+        << stats.messages << "," << stats.bytes << ","
+        << stats.dropped << "," << stats.reordered << ","
+        << mean << "," << stats.minDelay << "," << stats.maxDelay << ","
+        << std::sqrt(std::max(variance, 0.0)) << std::endl;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  Settings settings;
+  if(!parseOptions(argc, argv, settings))
+  {
+    printUsage();
+    return 1;
+  }
+
+  sf::TcpListener listener;
+  if(listener.listen(settings.listenPort) != sf::Socket::Done)
+  {
+    std::cout << "Could not listen on port " << settings.listenPort << std::endl;
+    return 1;
+  }
+  listener.setBlocking(false);
+
+  // Statistics go to the CSV file if given, to the console otherwise
+  std::ofstream csvFile;
+  if(!settings.csvFile.empty())
+    csvFile.open(settings.csvFile.c_str());
+  std::ostream& statsOutput = csvFile.is_open() ? csvFile : std::cout;
+  statsOutput << "time,direction,messages,bytes,dropped,reordered,"
+              << "meanDelayMs,minDelayMs,maxDelayMs,jitterMs" << std::endl;
+
+  std::cout << "Relaying port " << settings.listenPort << " to "
+            << settings.targetAddress << ":" << settings.targetPort << std::endl;
+
+  std::mt19937 random(settings.seed);
+  DirectionStats upStats;
+  DirectionStats downStats;
+  std::vector<std::unique_ptr<Link> > links;
+  std::vector<std::unique_ptr<Link> > connectingLinks;
+  std::unique_ptr<Link> pendingLink;
+  sf::Clock clock;
+  sf::Time lastStatsTime = sf::Time::Zero;
+
+  while(true)
+  {
+    sf::Time now = clock.getElapsedTime();
+
+    // Accept new clients and start their connection to the server;
+    // non-blocking, so a slow server does not stall the other links
+    if(!pendingLink)
+      pendingLink.reset(new Link(settings, random, upStats, downStats));
+
+    if(listener.accept(pendingLink->client) == sf::Socket::Done)
+    {
+      pendingLink->client.setBlocking(false);
+      pendingLink->server.setBlocking(false);
+      pendingLink->server.connect(settings.targetAddress, settings.targetPort);
+      pendingLink->connectDeadline = now + ConnectTimeout;
+      connectingLinks.push_back(std::move(pendingLink));
+    }
+
+    // A connection is done once the socket has a peer
+    for(auto itr = connectingLinks.begin(); itr != connectingLinks.end();)
+    {
+      Link& link = **itr;
+      if(link.server.getRemotePort() != 0)
+      {
+        links.push_back(std::move(*itr));
+        itr = connectingLinks.erase(itr);
+        std::cout << "Client connected (" << links.size() << " active)" << std::endl;
+      }
+      else if(now >= link.connectDeadline)
+      {
+        std::cout << "Could not reach the server, dropping client" << std::endl;
+        link.client.disconnect();
+        link.server.disconnect();
+        itr = connectingLinks.erase(itr);
+      }
+      else
+      {
+        ++itr;
+      }
+    }
+
+    // Pump both directions of every link
+    for(auto itr = links.begin(); itr != links.end();)
+    {
+      Link& link = **itr;
+      bool alive = link.upstream.receive(link.client, now);
+      alive = link.downstream.receive(link.server, now) && alive;
+      alive = link.upstream.deliver(link.server, now) && alive;
+      alive = link.downstream.deliver(link.client, now) && alive;
+
+      if(alive)
+      {
+        ++itr;
+      }
+      else
+      {
+        link.client.disconnect();
+        link.server.disconnect();
+        itr = links.erase(itr);
+        std::cout << "Client disconnected (" << links.size() << " active)" << std::endl;
+      }
+    }
+
+    if(now >= lastStatsTime + settings.statsInterval)
+    {
+      writeStats(statsOutput, now, "up", upStats);
+      writeStats(statsOutput, now, "down", downStats);
+      upStats = DirectionStats();
+      downStats = DirectionStats();
+      lastStatsTime = now;
+    }
+
+    sf::sleep(sf::milliseconds(1));
+  }
+
+  return 0;
+}
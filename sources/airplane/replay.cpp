@@ -0,0 +1,494 @@
+#include "Foreach.hpp"
+#include "GameServer.hpp"
+#include "NetworkProtocol.hpp"
+#include "NetworkStats.hpp"
+#include "PacketLog.hpp"
+
+#include <SFML/Network/IpAddress.hpp>
+#include <SFML/Network/Packet.hpp>
+#include <SFML/Network/SocketSelector.hpp>
+#include <SFML/Network/TcpListener.hpp>
+#include <SFML/Network/TcpSocket.hpp>
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Sleep.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+
+// Feeds a capture written by GameServer or MultiplayerGameState back into a
+// server (the client side of the conversation) or into a client (the server
+// side), at the recorded pace or as fast as possible.
+//
+// The client side is replayed into a real game client connecting to this
+// tool: the client state needs a window, its fonts and textures to build its
+// World, so there is no headless client to feed the messages to directly.
+//
+// The tool speaks the handshake itself, a hello to the server or a welcome
+// to the client, and skips the recorded one: a server capture starts after
+// it, a client capture holds only one side of it.
+namespace
+{
+  // Time a server has to announce an aircraft the capture spawned
+  const sf::Time SpawnTimeout = sf::seconds(5.f);
+
+  enum Mode
+  {
+    ToServer,
+    ToClient,
+    Summary
+  };
+
+  struct Options
+  {
+    Options() :
+      mode(ToServer),
+      filename(),
+      address(),
+      maxSpeed(false),
+      channel(0),
+      hasChannel(false)
+    {
+    }
+
+    Mode mode;
+    std::string filename;
+    std::string address;
+    bool maxSpeed;
+    sf::Uint32 channel;
+    bool hasChannel;
+  };
+
+  struct Totals
+  {
+    Totals() :
+      sentMessages(0),
+      sentBytes(0),
+      receivedMessages(0),
+      receivedBytes(0)
+    {
+    }
+
+    sf::Uint64 sentMessages;
+    sf::Uint64 sentBytes;
+    sf::Uint64 receivedMessages;
+    sf::Uint64 receivedBytes;
+  };
+
+  typedef std::unique_ptr<sf::TcpSocket> SocketPtr;
+
+  struct Peer
+  {
+    Peer() :
+      socket(),
+      spawned(),
+      identifiers()
+    {
+    }
+
+    SocketPtr socket;
+
+    // Aircraft the live server gave this peer, not yet paired with the
+    // recorded ones, and recorded identifiers -> live identifiers
+    std::deque<sf::Int32> spawned;
+    std::map<sf::Int32, sf::Int32> identifiers;
+  };
+
+  void printUsage()
+  {
+    std::cout << "usage: replay <capture> [--server | --client | --summary]\n"
+              << "              [--address ip] [--channel n] [--max-speed]\n"
+              << "  --server     send the client messages to a server (default),\n"
+              << "               an in-process server is started without --address\n"
+              << "  --client     act as the server and send its messages to the\n"
+              << "               first client connecting on the game port\n"
+              << "  --summary    print message counts per channel and type\n"
+              << "  --channel n  only replay one peer of a server capture\n"
+              << "  --max-speed  ignore recorded timestamps\n";
+  }
+
+  bool parseOptions(int argc, char* argv[], Options& options)
+  {
+    for(int i=1; i<argc; ++i)
+    {
+      std::string argument = argv[i];
+      if(argument == "--server")
+        options.mode = ToServer;
+      else if(argument == "--client")
+        options.mode = ToClient;
+      else if(argument == "--summary")
+        options.mode = Summary;
+      else if(argument == "--max-speed")
+        options.maxSpeed = true;
+      else if(argument == "--address" && i + 1 < argc)
+        options.address = argv[++i];
+      else if(argument == "--channel" && i + 1 < argc)
+      {
+        options.channel = static_cast<sf::Uint32>(std::atoi(argv[++i]));
+        options.hasChannel = true;
+      }
+      else if(options.filename.empty() && argument[0] != '-')
+        options.filename = argument;
+      else
+        return false;
+    }
+
+    return !options.filename.empty();
+  }
+
+  void waitFor(const sf::Clock& clock, sf::Time time, const Options& options)
+  {
+    sf::Time elapsed = clock.getElapsedTime();
+    if(!options.maxSpeed && time > elapsed)
+      sf::sleep(time - elapsed);
+  }
+
+  // Packets sent by a server that give a client one of its aircraft
+  bool isSpawn(sf::Packet& packet, sf::Int32& aircraftIdentifier)
+  {
+    sf::Int32 packetType;
+    packet >> packetType >> aircraftIdentifier;
+    return packet && (packetType == Server::SpawnSelf || packetType == Server::AcceptCoopPartner);
+  }
+
+  // Read whatever the other side sends, so its send buffer never fills up;
+  // a server's spawns are kept to map the recorded aircraft identifiers
+  void drain(sf::SocketSelector& selector, std::map<sf::Uint32, Peer>& peers, Totals& totals, bool fromServer)
+  {
+    while(selector.wait(sf::microseconds(1)))
+    {
+      bool receivedAny = false;
+      FOREACH(auto& pair, peers)
+      {
+        Peer& peer = pair.second;
+        sf::Packet packet;
+        if(peer.socket && selector.isReady(*peer.socket) && peer.socket->receive(packet) == sf::Socket::Done)
+        {
+          totals.receivedMessages++;
+          totals.receivedBytes += packet.getDataSize();
+          receivedAny = true;
+
+          sf::Int32 aircraftIdentifier;
+          if(fromServer && isSpawn(packet, aircraftIdentifier))
+            peer.spawned.push_back(aircraftIdentifier);
+        }
+      }
+
+      if(!receivedAny)
+        break;
+    }
+  }
+
+  // The server picks its own aircraft identifiers: both sides announce a
+  // peer's aircraft in the same order, so the n-th recorded spawn is the
+  // n-th live one
+  bool mapSpawn(sf::Int32 recordedIdentifier, Peer& peer, sf::SocketSelector& selector,
+      std::map<sf::Uint32, Peer>& peers, Totals& totals)
+  {
+    sf::Clock clock;
+    while(peer.spawned.empty())
+    {
+      if(clock.getElapsedTime() > SpawnTimeout)
+        return false;
+
+      selector.wait(sf::milliseconds(10));
+      drain(selector, peers, totals, true);
+    }
+
+    peer.identifiers[recordedIdentifier] = peer.spawned.front();
+    peer.spawned.pop_front();
+    return true;
+  }
+
+  sf::Int32 readInt32(const std::vector<char>& data, std::size_t offset)
+  {
+    sf::Uint32 value = 0;
+    for(std::size_t i=0; i<4; ++i)
+      value = (value << 8) | static_cast<unsigned char>(data[offset + i]);
+    return static_cast<sf::Int32>(value);
+  }
+
+  void writeInt32(std::vector<char>& data, std::size_t offset, sf::Int32 value)
+  {
+    for(std::size_t i=0; i<4; ++i)
+      data[offset + i] = static_cast<char>((static_cast<sf::Uint32>(value) >> (8 * (3 - i))) & 0xff);
+  }
+
+  void remapIdentifier(std::vector<char>& data, std::size_t offset, const Peer& peer)
+  {
+    if(offset + 4 > data.size())
+      return;
+
+    auto found = peer.identifiers.find(readInt32(data, offset));
+    if(found != peer.identifiers.end())
+      writeInt32(data, offset, found->second);
+  }
+
+  // Client messages naming an aircraft get the live server's identifier
+  void remapIdentifiers(std::vector<char>& data, const Peer& peer)
+  {
+    if(data.size() < 4)
+      return;
+
+    switch(readInt32(data, 0))
+    {
+      case Client::PlayerEvent:
+      case Client::PlayerRealtimeChange:
+        remapIdentifier(data, 4, peer);
+        break;
+
+      // [count] count x ([id] [x] [y] [hitpoints] [missiles])
+      case Client::PositionUpdate:
+        for(std::size_t offset = 8; offset + 20 <= data.size(); offset += 20)
+          remapIdentifier(data, offset, peer);
+        break;
+    }
+  }
+
+  // Opens or answers a connection, replayed messages never do
+  bool isHandshake(const std::vector<char>& data, bool clientMessage)
+  {
+    if(data.size() < 4)
+      return false;
+
+    sf::Int32 packetType = readInt32(data, 0);
+    if(clientMessage)
+      return packetType == Client::Hello || packetType == Client::Resume;
+    return packetType == Server::Welcome || packetType == Server::ResumeAccepted;
+  }
+
+  void printTotals(const Totals& totals, sf::Time elapsed)
+  {
+    float seconds = std::max(elapsed.asSeconds(), 0.001f);
+    std::cout << "sent " << totals.sentMessages << " msgs / " << totals.sentBytes << " bytes, "
+              << "received " << totals.receivedMessages << " msgs / " << totals.receivedBytes << " bytes "
+              << "in " << seconds << "s (" << totals.sentMessages / seconds << " msgs/s, "
+              << totals.sentBytes / seconds << " B/s sent)" << std::endl;
+  }
+
+  int summarize(PacketLogReader& reader)
+  {
+    // channel -> direction -> type -> count
+    std::map<sf::Uint32, std::map<int, std::map<sf::Int32, sf::Uint64> > > counts;
+    PacketLog::Record record;
+    sf::Time duration = sf::Time::Zero;
+
+    while(reader.next(record))
+    {
+      sf::Packet packet;
+      if(!record.data.empty())
+        packet.append(&record.data[0], record.data.size());
+
+      counts[record.channel][record.direction][NetworkStats::getPacketType(packet)]++;
+      duration = record.time;
+    }
+
+    std::cout << ((reader.getRole() == PacketLog::ServerSide) ? "server" : "client")
+              << " capture, " << duration.asSeconds() << "s\n";
+    FOREACH(auto& channel, counts)
+    {
+      std::cout << "channel " << channel.first << "\n";
+      FOREACH(auto& direction, channel.second)
+      {
+        std::cout << "  " << ((direction.first == NetworkStats::Incoming) ? "in" : "out") << ":";
+        FOREACH(auto& type, direction.second)
+          std::cout << " [" << type.first << "]=" << type.second;
+        std::cout << "\n";
+      }
+    }
+
+    return 0;
+  }
+
+  int replayToServer(PacketLogReader& reader, const Options& options)
+  {
+    // Without an address, replay against a fresh headless server
+    std::unique_ptr<GameServer> server;
+    sf::IpAddress address = options.address.empty() ? sf::IpAddress("127.0.0.1") : sf::IpAddress(options.address);
+    if(options.address.empty())
+      server.reset(new GameServer(GameServer::Settings()));
+
+    std::map<sf::Uint32, Peer> peers;
+    sf::SocketSelector selector;
+    Totals totals;
+    PacketLog::Record record;
+    sf::Clock clock;
+
+    while(reader.next(record))
+    {
+      if(record.data.empty() ||
+          (options.hasChannel && record.channel != options.channel))
+        continue;
+
+      // What the server answered is only needed for its spawns
+      if(!PacketLog::isClientMessage(reader.getRole(), record))
+      {
+        auto peer = peers.find(record.channel);
+        sf::Packet packet;
+        packet.append(&record.data[0], record.data.size());
+
+        sf::Int32 aircraftIdentifier;
+        if(peer != peers.end() && isSpawn(packet, aircraftIdentifier) &&
+            !mapSpawn(aircraftIdentifier, peer->second, selector, peers, totals))
+        {
+          std::cout << "Server did not spawn aircraft " << aircraftIdentifier << std::endl;
+          return 1;
+        }
+        continue;
+      }
+
+      if(isHandshake(record.data, true))
+        continue;
+
+      // One connection per recorded peer, opened when it first speaks
+      Peer& peer = peers[record.channel];
+      SocketPtr& socket = peer.socket;
+      if(!socket)
+      {
+        // Retry a little, an in-process server may not be listening yet
+        socket.reset(new sf::TcpSocket());
+        sf::Socket::Status status = sf::Socket::Error;
+        for(int attempt = 0; attempt < 10 && status != sf::Socket::Done; ++attempt)
+        {
+          status = socket->connect(address, serverPort, sf::seconds(5.f));
+          if(status != sf::Socket::Done)
+            sf::sleep(sf::milliseconds(200));
+        }
+
+        if(status != sf::Socket::Done)
+        {
+          std::cout << "Could not connect to " << address.toString() << std::endl;
+          return 1;
+        }
+        selector.add(*socket);
+
+        // The server turns away connections that do not start with a hello
+        sf::Packet hello;
+        hello << static_cast<sf::Int32>(Client::Hello);
+        hello << minimumProtocolVersion << protocolVersion;
+        if(socket->send(hello) != sf::Socket::Done)
+        {
+          std::cout << "Server closed the connection" << std::endl;
+          return 1;
+        }
+      }
+
+      waitFor(clock, record.time, options);
+      remapIdentifiers(record.data, peer);
+
+      sf::Packet packet;
+      packet.append(&record.data[0], record.data.size());
+      if(socket->send(packet) != sf::Socket::Done)
+      {
+        std::cout << "Server closed the connection" << std::endl;
+        break;
+      }
+
+      totals.sentMessages++;
+      totals.sentBytes += record.data.size();
+      drain(selector, peers, totals, true);
+    }
+
+    printTotals(totals, clock.getElapsedTime());
+    return 0;
+  }
+
+  int replayToClient(PacketLogReader& reader, const Options& options)
+  {
+    sf::TcpListener listener;
+    if(listener.listen(serverPort) != sf::Socket::Done)
+    {
+      std::cout << "Could not listen on port " << serverPort << std::endl;
+      return 1;
+    }
+
+    std::cout << "Waiting for a client on port " << serverPort << "..." << std::endl;
+    std::map<sf::Uint32, Peer> peers;
+    SocketPtr& client = peers[0].socket;
+    client.reset(new sf::TcpSocket());
+    if(listener.accept(*client) != sf::Socket::Done)
+      return 1;
+
+    sf::SocketSelector selector;
+    selector.add(*client);
+
+    // The client waits for the answer to its hello before anything else
+    sf::Packet welcome;
+    welcome << static_cast<sf::Int32>(Server::Welcome);
+    welcome << protocolVersion;
+    if(client->send(welcome) != sf::Socket::Done)
+      return 1;
+
+    Totals totals;
+    PacketLog::Record record;
+    sf::Clock clock;
+    bool hasChannel = options.hasChannel;
+    sf::Uint32 channel = options.channel;
+
+    while(reader.next(record))
+    {
+      if(record.data.empty() || PacketLog::isClientMessage(reader.getRole(), record) ||
+          isHandshake(record.data, false))
+        continue;
+
+      // A server capture holds several peers, follow only one of them
+      if(!hasChannel)
+      {
+        channel = record.channel;
+        hasChannel = true;
+      }
+      if(record.channel != channel)
+        continue;
+
+      waitFor(clock, record.time, options);
+
+      sf::Packet packet;
+      packet.append(&record.data[0], record.data.size());
+      if(client->send(packet) != sf::Socket::Done)
+      {
+        std::cout << "Client closed the connection" << std::endl;
+        break;
+      }
+
+      totals.sentMessages++;
+      totals.sentBytes += record.data.size();
+      drain(selector, peers, totals, false);
+    }
+
+    printTotals(totals, clock.getElapsedTime());
+    return 0;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  Options options;
+  if(!parseOptions(argc, argv, options))
+  {
+    printUsage();
+    return 1;
+  }
+
+  PacketLogReader reader;
+  if(!reader.open(options.filename))
+  {
+    std::cout << "Could not read capture " << options.filename << std::endl;
+    return 1;
+  }
+
+  switch(options.mode)
+  {
+    case ToServer:
+      return replayToServer(reader, options);
+    case ToClient:
+      return replayToClient(reader, options);
+    case Summary:
+      return summarize(reader);
+  }
+
+  return 0;
+}
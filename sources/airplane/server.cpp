@@ -0,0 +1,213 @@
+#include "GameServer.hpp"
+
+#include <SFML/System/Sleep.hpp>
+
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// Dedicated server: runs a GameServer without window, fonts, textures or
+// sounds, so it only needs the SFML system and network modules
+namespace
+{
+  // How long a resuming server waits for the checkpoint to appear
+  const sf::Time CheckpointWaitTime = sf::seconds(30.f);
+
+  volatile std::sig_atomic_t quitRequested = 0;
+  volatile std::sig_atomic_t migrationRequested = 0;
+
+  struct MigrationOptions
+  {
+    MigrationOptions() :
+      port(0),
+      checkpointFile("match.scck")
+    {
+    }
+
+    unsigned short port;
+    std::string checkpointFile;
+  };
+
+  void requestQuit(int)
+  {
+    quitRequested = 1;
+  }
+
+  void requestMigration(int)
+  {
+    migrationRequested = 1;
+  }
+
+  bool waitForFile(const std::string& filename, sf::Time timeout)
+  {
+    for(sf::Time waited = sf::Time::Zero; waited < timeout; waited += sf::milliseconds(100))
+    {
+      if(std::ifstream(filename.c_str()))
+        return true;
+      sf::sleep(sf::milliseconds(100));
+    }
+    return false;
+  }
+
+  void printUsage()
+  {
+    std::cout << "usage: server [--port n] [--players n] [--tick-rate hz] [--update-rate hz]\n"
+              << "              [--ping-rate hz] [--poll ms] [--timeout s] [--stats s]\n"
+              << "              [--join-budget bytes] [--state-budget bytes] [--peer-rate n] [--budget n]\n"
+              << "              [--spectator-port n] [--spectators n] [--capture file]\n"
+              << "              [--migrate-to port] [--checkpoint file] [--resume file]\n"
+              << "              [--gateway address] [--gateway-port n]\n"
+              << "  --port         listening port (default 5000)\n"
+              << "  --players      maximum number of connected clients (default 10)\n"
+              << "  --tick-rate    simulation ticks per second (default 20)\n"
+              << "  --update-rate  client state updates per second (default 20)\n"
+              << "  --ping-rate    pings per second (default 1)\n"
+              << "  --poll         sleep between two polls of the sockets (default 100)\n"
+              << "  --timeout      seconds of silence before a client is dropped (default 3)\n"
+              << "  --stats        print traffic statistics every s seconds\n"
+              << "  --join-budget  join state bytes sent per tick to a new client (default 4096)\n"
+              << "  --state-budget aircraft state bytes per update and client, 0 for all (default 1024)\n"
+              << "  --peer-rate    messages per second accepted from a client (default 200)\n"
+              << "  --budget       messages handled per poll over all clients (default 256)\n"
+              << "  --spectator-port  port for read-only spectators (default 5002)\n"
+              << "  --spectators   maximum number of spectators, 0 disables them (default 32)\n"
+              << "  --capture      record all traffic to a file for the replay tool\n"
+              << "  --migrate-to   on SIGUSR1, hand the match over to a server on that port\n"
+              << "  --checkpoint   file the match is handed over through (default match.scck)\n"
+              << "  --resume       wait for a checkpoint file and continue its match\n"
+              << "  --gateway      report the load to a gateway on this address\n"
+              << "  --gateway-port port of the gateway for servers (default 5003)\n";
+  }
+
+  sf::Time rateToInterval(const char* argument)
+  {
+    float rate = static_cast<float>(std::atof(argument));
+    return (rate > 0.f) ? sf::seconds(1.f / rate) : sf::Time::Zero;
+  }
+
+  bool parseOptions(int argc, char* argv[], GameServer::Settings& settings, MigrationOptions& migration)
+  {
+    for(int i=1; i<argc; ++i)
+    {
+      std::string argument = argv[i];
+      if(i + 1 >= argc)
+        return false;
+
+      const char* value = argv[++i];
+      if(argument == "--port")
+        settings.port = static_cast<unsigned short>(std::atoi(value));
+      else if(argument == "--players")
+        settings.maxPlayers = static_cast<std::size_t>(std::atoi(value));
+      else if(argument == "--tick-rate")
+        settings.tickInterval = rateToInterval(value);
+      else if(argument == "--update-rate")
+        settings.updateInterval = rateToInterval(value);
+      else if(argument == "--ping-rate")
+        settings.pingInterval = rateToInterval(value);
+      else if(argument == "--poll")
+        settings.idleTime = sf::milliseconds(std::atoi(value));
+      else if(argument == "--timeout")
+        settings.clientTimeout = sf::seconds(static_cast<float>(std::atof(value)));
+      else if(argument == "--stats")
+        settings.statsDumpInterval = sf::seconds(static_cast<float>(std::atof(value)));
+      else if(argument == "--join-budget")
+        settings.joinBytesPerTick = static_cast<std::size_t>(std::atoi(value));
+      else if(argument == "--state-budget")
+        settings.stateBytesPerUpdate = static_cast<std::size_t>(std::atoi(value));
+      else if(argument == "--peer-rate")
+      {
+        settings.peerMessageRate = static_cast<float>(std::atof(value));
+        settings.peerMessageBurst = std::max(1.f, settings.peerMessageRate / 2.f);
+      }
+      else if(argument == "--budget")
+        settings.messageBudget = static_cast<std::size_t>(std::atoi(value));
+      else if(argument == "--spectator-port")
+        settings.spectatorPort = static_cast<unsigned short>(std::atoi(value));
+      else if(argument == "--spectators")
+        settings.maxSpectators = static_cast<std::size_t>(std::atoi(value));
+      else if(argument == "--capture")
+        settings.captureFile = value;
+      else if(argument == "--migrate-to")
+        migration.port = static_cast<unsigned short>(std::atoi(value));
+      else if(argument == "--checkpoint")
+        migration.checkpointFile = value;
+      else if(argument == "--resume")
+        settings.resumeFile = value;
+      else if(argument == "--gateway")
+        settings.gatewayAddress = value;
+      else if(argument == "--gateway-port")
+        settings.gatewayPort = static_cast<unsigned short>(std::atoi(value));
+      else
+        return false;
+    }
+
+    return settings.port != 0 && settings.maxPlayers > 0 &&
+      settings.tickInterval != sf::Time::Zero &&
+      settings.updateInterval != sf::Time::Zero &&
+      settings.pingInterval != sf::Time::Zero &&
+      settings.joinBytesPerTick > 0 && settings.messageBudget > 0;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  GameServer::Settings settings;
+  MigrationOptions migration;
+  if(!parseOptions(argc, argv, settings, migration))
+  {
+    printUsage();
+    return 1;
+  }
+
+  std::signal(SIGINT, requestQuit);
+  std::signal(SIGTERM, requestQuit);
+#ifdef SIGUSR1
+  if(migration.port != 0)
+    std::signal(SIGUSR1, requestMigration);
+#endif
+
+  // Started ahead of a migration, the old server writes the file
+  if(!settings.resumeFile.empty())
+  {
+    std::cout << "Waiting for checkpoint " << settings.resumeFile << std::endl;
+    if(!waitForFile(settings.resumeFile, CheckpointWaitTime))
+    {
+      std::cout << "No checkpoint to resume from" << std::endl;
+      return 1;
+    }
+  }
+
+  try
+  {
+    GameServer server(settings);
+    std::cout << "Server running on port " << settings.port << " for up to "
+              << settings.maxPlayers << " players, press Ctrl+C to stop" << std::endl;
+
+    // All the work happens on the server thread
+    while(!quitRequested && !server.isMigrated())
+    {
+      if(migrationRequested)
+      {
+        migrationRequested = 0;
+        server.requestMigration(migration.checkpointFile, migration.port);
+      }
+      sf::sleep(sf::milliseconds(200));
+    }
+
+    // Leave the clients a moment to receive the migration order
+    if(server.isMigrated())
+      sf::sleep(sf::seconds(1.f));
+
+    std::cout << "Shutting down" << std::endl;
+  }
+  catch (std::exception& e)
+  {
+    std::cout << "\nEXCEPTION: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
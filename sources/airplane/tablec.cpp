@@ -0,0 +1,489 @@
+#include "Aircraft.hpp"
+#include "DataTables.hpp"
+#include "Particle.hpp"
+#include "Pickup.hpp"
+#include "Projectile.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Compiles a data tables source into the file DataTables loads, and reloads
+// while the game runs. From the game directory:
+//   tablec assets/data/Tables.txt assets/data/Tables.data
+// or, with --header, into the constants SCOUT_STATIC_TABLES builds use,
+// which the build generates itself:
+//   tablec --header assets/data/Tables.txt StaticTables.hpp
+//
+// The source has one statement per line, '#' starts a comment. An entry
+// line names the entity whose fields follow:
+//   aircraft <type>    hitpoints, speed, texture, rect, fireInterval,
+//                      direction <angle> <distance> (repeated),
+//                      rollAnimation <yes|no>
+//   projectile <type>  damage, speed, texture, rect
+//   pickup <type>      value, texture, rect
+//   particle <type>    color <r> <g> <b> [a], lifetime
+// rect is <left> <top> <width> <height>, times are in seconds. Entries and
+// fields left out keep their built-in values.
+namespace
+{
+  struct Name
+  {
+    const char* name;
+    unsigned int value;
+  };
+
+  const Name AircraftTypes[] =
+  {
+    { "Eagle", Aircraft::Eagle },
+    { "Raptor", Aircraft::Raptor },
+    { "Avenger", Aircraft::Avenger }
+  };
+
+  const Name ProjectileTypes[] =
+  {
+    { "AlliedBullet", Projectile::AlliedBullet },
+    { "EnemyBullet", Projectile::EnemyBullet },
+    { "Missile", Projectile::Missile }
+  };
+
+  const Name PickupTypes[] =
+  {
+    { "HealthRefill", Pickup::HealthRefill },
+    { "MissileRefill", Pickup::MissileRefill },
+    { "FireSpread", Pickup::FireSpread },
+    { "FireRate", Pickup::FireRate }
+  };
+
+  const Name ParticleTypes[] =
+  {
+    { "Propellant", Particle::Propellant },
+    { "Smoke", Particle::Smoke }
+  };
+
+  const Name TextureNames[] =
+  {
+    { "Entities", Textures::Entities },
+    { "Jungle", Textures::Jungle },
+    { "TitleScreen", Textures::TitleScreen },
+    { "Buttons", Textures::Buttons },
+    { "Explosion", Textures::Explosion },
+    { "Particle", Textures::Particle },
+    { "FinishLine", Textures::FinishLine }
+  };
+
+  template <std::size_t Count>
+  bool lookup(const Name (&names)[Count], const std::string& name, unsigned int& value)
+  {
+    for(std::size_t i=0; i<Count; ++i)
+    {
+      if(name == names[i].name)
+      {
+        value = names[i].value;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  enum Section
+  {
+    NoSection,
+    AircraftSection,
+    ProjectileSection,
+    PickupSection,
+    ParticleSection
+  };
+
+  void printUsage()
+  {
+    std::cout << "usage: tablec [--header] <source> <output>\n"
+              << "  compiles a data tables source, see tablec.cpp for its statements\n"
+              << "  --header  writes the StaticTables.hpp constants instead of a tables file\n";
+  }
+
+  bool readTexture(std::istream& statement, Textures::ID& texture)
+  {
+    std::string name;
+    unsigned int value;
+    if(!(statement >> name) || !lookup(TextureNames, name, value))
+      return false;
+
+    texture = static_cast<Textures::ID>(value);
+    return true;
+  }
+
+  bool readRect(std::istream& statement, sf::IntRect& rect)
+  {
+    return static_cast<bool>(statement >> rect.left >> rect.top >> rect.width >> rect.height);
+  }
+
+  bool readSeconds(std::istream& statement, sf::Time& time)
+  {
+    float seconds;
+    if(!(statement >> seconds) || seconds < 0.f)
+      return false;
+
+    time = sf::seconds(seconds);
+    return true;
+  }
+
+  bool readAircraftField(const std::string& field, std::istream& statement, AircraftData& data, bool& keepDirections)
+  {
+    if(field == "hitpoints")
+      return static_cast<bool>(statement >> data.hitpoints);
+    if(field == "speed")
+      return static_cast<bool>(statement >> data.speed);
+    if(field == "texture")
+      return readTexture(statement, data.texture);
+    if(field == "rect")
+      return readRect(statement, data.textureRect);
+    if(field == "fireInterval")
+      return readSeconds(statement, data.fireInterval);
+
+    if(field == "direction")
+    {
+      // The first direction of an entry replaces the built-in pattern
+      if(!keepDirections)
+        data.directions.clear();
+      keepDirections = true;
+
+      Direction direction(0.f, 0.f);
+      if(!(statement >> direction.angle >> direction.distance))
+        return false;
+      data.directions.push_back(direction);
+      return true;
+    }
+
+    if(field == "rollAnimation")
+    {
+      std::string value;
+      if(!(statement >> value) || (value != "yes" && value != "no"))
+        return false;
+      data.hasRollAnimation = (value == "yes");
+      return true;
+    }
+
+    return false;
+  }
+
+  bool readProjectileField(const std::string& field, std::istream& statement, ProjectileData& data)
+  {
+    if(field == "damage")
+      return static_cast<bool>(statement >> data.damage);
+    if(field == "speed")
+      return static_cast<bool>(statement >> data.speed);
+    if(field == "texture")
+      return readTexture(statement, data.texture);
+    if(field == "rect")
+      return readRect(statement, data.textureRect);
+    return false;
+  }
+
+  bool readPickupField(const std::string& field, std::istream& statement, PickupData& data)
+  {
+    if(field == "value")
+      return static_cast<bool>(statement >> data.value);
+    if(field == "texture")
+      return readTexture(statement, data.texture);
+    if(field == "rect")
+      return readRect(statement, data.textureRect);
+    return false;
+  }
+
+  bool readParticleField(const std::string& field, std::istream& statement, ParticleData& data)
+  {
+    if(field == "lifetime")
+      return readSeconds(statement, data.lifetime);
+
+    if(field == "color")
+    {
+      unsigned int r, g, b;
+      unsigned int a = 255;
+      if(!(statement >> r >> g >> b) || r > 255 || g > 255 || b > 255)
+        return false;
+      if(!(statement >> a))
+        statement.clear();
+      if(a > 255)
+        return false;
+
+      data.color = sf::Color(static_cast<sf::Uint8>(r), static_cast<sf::Uint8>(g),
+          static_cast<sf::Uint8>(b), static_cast<sf::Uint8>(a));
+      return true;
+    }
+
+    return false;
+  }
+
+  // Shortest literal reading back as the same float
+  std::string floatLiteral(float value)
+  {
+    std::string text;
+    for(int precision=6; precision<=9; ++precision)
+    {
+      std::ostringstream stream;
+      stream << std::setprecision(precision) << value;
+      text = stream.str();
+      if(std::strtof(text.c_str(), nullptr) == value)
+        break;
+    }
+
+    if(text.find_first_of(".e") == std::string::npos)
+      text += ".0";
+    return text + "f";
+  }
+
+  std::string rectLiteral(const sf::IntRect& rect)
+  {
+    std::ostringstream stream;
+    stream << "{ " << rect.left << ", " << rect.top << ", " << rect.width << ", " << rect.height << " }";
+    return stream.str();
+  }
+
+  void writeHeader(const GameTables& tables, std::ostream& output)
+  {
+    output << "#ifndef SOURCES_SCOUT_STATICTABLES_HPP_\n"
+           << "#define SOURCES_SCOUT_STATICTABLES_HPP_\n"
+           << "\n"
+           << "// Generated by tablec --header from assets/data/Tables.txt, do not edit.\n"
+           << "//\n"
+           << "// The data tables as compile-time constants, which SCOUT_STATIC_TABLES\n"
+           << "// builds read instead of loading DataTables files. Indexed by the entity\n"
+           << "// type enumerations; times are in seconds.\n"
+           << "namespace StaticTables\n"
+           << "{\n"
+           << "  struct AircraftEntry\n"
+           << "  {\n"
+           << "    int hitpoints;\n"
+           << "    float speed;\n"
+           << "    int texture;\n"
+           << "    int textureRect[4];\n"
+           << "    float fireInterval;\n"
+           << "    int firstDirection;\n"
+           << "    int directionCount;\n"
+           << "    bool hasRollAnimation;\n"
+           << "  };\n"
+           << "\n"
+           << "  struct DirectionEntry\n"
+           << "  {\n"
+           << "    float angle;\n"
+           << "    float distance;\n"
+           << "  };\n"
+           << "\n"
+           << "  struct ProjectileEntry\n"
+           << "  {\n"
+           << "    int damage;\n"
+           << "    float speed;\n"
+           << "    int texture;\n"
+           << "    int textureRect[4];\n"
+           << "  };\n"
+           << "\n"
+           << "  struct PickupEntry\n"
+           << "  {\n"
+           << "    int value;\n"
+           << "    int texture;\n"
+           << "    int textureRect[4];\n"
+           << "  };\n"
+           << "\n"
+           << "  struct ParticleEntry\n"
+           << "  {\n"
+           << "    int color[4];\n"
+           << "    float lifetime;\n"
+           << "  };\n"
+           << "\n";
+
+    std::vector<Direction> directions;
+    output << "  constexpr AircraftEntry AircraftTable[] =\n  {\n";
+    for(std::size_t i=0; i<tables.aircraft.size(); ++i)
+    {
+      const AircraftData& data = tables.aircraft[i];
+      output << "    { " << data.hitpoints << ", " << floatLiteral(data.speed) << ", " << data.texture << ", "
+             << rectLiteral(data.textureRect) << ", " << floatLiteral(data.fireInterval.asSeconds()) << ", "
+             << directions.size() << ", " << data.directions.size() << ", "
+             << (data.hasRollAnimation ? "true" : "false") << " }"
+             << (i + 1 < tables.aircraft.size() ? "," : "") << " // " << AircraftTypes[i].name << "\n";
+      directions.insert(directions.end(), data.directions.begin(), data.directions.end());
+    }
+    output << "  };\n\n";
+
+    // Never empty, an array of no elements is ill-formed
+    directions.push_back(Direction(0.f, 0.f));
+    output << "  constexpr DirectionEntry DirectionTable[] =\n  {\n";
+    for(std::size_t i=0; i<directions.size(); ++i)
+    {
+      output << "    { " << floatLiteral(directions[i].angle) << ", " << floatLiteral(directions[i].distance) << " }"
+             << (i + 1 < directions.size() ? "," : " // End") << "\n";
+    }
+    output << "  };\n\n";
+
+    output << "  constexpr ProjectileEntry ProjectileTable[] =\n  {\n";
+    for(std::size_t i=0; i<tables.projectiles.size(); ++i)
+    {
+      const ProjectileData& data = tables.projectiles[i];
+      output << "    { " << data.damage << ", " << floatLiteral(data.speed) << ", " << data.texture << ", "
+             << rectLiteral(data.textureRect) << " }"
+             << (i + 1 < tables.projectiles.size() ? "," : "") << " // " << ProjectileTypes[i].name << "\n";
+    }
+    output << "  };\n\n";
+
+    output << "  constexpr PickupEntry PickupTable[] =\n  {\n";
+    for(std::size_t i=0; i<tables.pickups.size(); ++i)
+    {
+      const PickupData& data = tables.pickups[i];
+      output << "    { " << data.value << ", " << data.texture << ", " << rectLiteral(data.textureRect) << " }"
+             << (i + 1 < tables.pickups.size() ? "," : "") << " // " << PickupTypes[i].name << "\n";
+    }
+    output << "  };\n\n";
+
+    output << "  constexpr ParticleEntry ParticleTable[] =\n  {\n";
+    for(std::size_t i=0; i<tables.particles.size(); ++i)
+    {
+      const ParticleData& data = tables.particles[i];
+      output << "    { { " << static_cast<int>(data.color.r) << ", " << static_cast<int>(data.color.g) << ", "
+             << static_cast<int>(data.color.b) << ", " << static_cast<int>(data.color.a) << " }, "
+             << floatLiteral(data.lifetime.asSeconds()) << " }"
+             << (i + 1 < tables.particles.size() ? "," : "") << " // " << ParticleTypes[i].name << "\n";
+    }
+    output << "  };\n"
+           << "}\n"
+           << "\n"
+           << "#endif\n";
+  }
+
+  bool parse(const std::string& filename, GameTables& tables)
+  {
+    std::ifstream file(filename.c_str());
+    if(!file)
+    {
+      std::cout << "Could not read " << filename << std::endl;
+      return false;
+    }
+
+    Section section = NoSection;
+    unsigned int entry = 0;
+    bool keepDirections = false;
+
+    std::string text;
+    for(std::size_t line=1; std::getline(file, text); ++line)
+    {
+      std::istringstream statement(text.substr(0, text.find('#')));
+      std::string keyword;
+      if(!(statement >> keyword))
+        continue;
+
+      std::string name;
+      bool valid = true;
+      if(keyword == "aircraft" || keyword == "projectile" || keyword == "pickup" || keyword == "particle")
+      {
+        statement >> name;
+        keepDirections = false;
+
+        if(keyword == "aircraft")
+        {
+          section = AircraftSection;
+          valid = lookup(AircraftTypes, name, entry);
+        }
+        else if(keyword == "projectile")
+        {
+          section = ProjectileSection;
+          valid = lookup(ProjectileTypes, name, entry);
+        }
+        else if(keyword == "pickup")
+        {
+          section = PickupSection;
+          valid = lookup(PickupTypes, name, entry);
+        }
+        else
+        {
+          section = ParticleSection;
+          valid = lookup(ParticleTypes, name, entry);
+        }
+
+        if(!valid)
+        {
+          std::cout << filename << ":" << line << ": no " << keyword << " type '" << name << "'" << std::endl;
+          return false;
+        }
+      }
+      else
+      {
+        switch(section)
+        {
+          case AircraftSection:
+            valid = readAircraftField(keyword, statement, tables.aircraft[entry], keepDirections);
+            break;
+          case ProjectileSection:
+            valid = readProjectileField(keyword, statement, tables.projectiles[entry]);
+            break;
+          case PickupSection:
+            valid = readPickupField(keyword, statement, tables.pickups[entry]);
+            break;
+          case ParticleSection:
+            valid = readParticleField(keyword, statement, tables.particles[entry]);
+            break;
+          default:
+            valid = false;
+            break;
+        }
+      }
+
+      std::string rest;
+      if(!valid || statement >> rest)
+      {
+        std::cout << filename << ":" << line << ": cannot read '" << text << "'" << std::endl;
+        return false;
+      }
+    }
+
+    return true;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  bool header = (argc == 4 && std::string(argv[1]) == "--header");
+  if(argc != 3 && !header)
+  {
+    printUsage();
+    return 1;
+  }
+
+  const char* sourceFile = argv[argc - 2];
+  const char* outputFile = argv[argc - 1];
+
+  GameTables tables;
+  tables.aircraft = initializeAircraftData();
+  tables.projectiles = initializeProjectileData();
+  tables.pickups = initializePickupData();
+  tables.particles = initializeParticleData();
+
+  if(!parse(sourceFile, tables))
+    return 1;
+
+  std::vector<char> contents;
+  if(header)
+  {
+    std::ostringstream text;
+    writeHeader(tables, text);
+    std::string generated = text.str();
+    contents.assign(generated.begin(), generated.end());
+  }
+  else
+  {
+    DataTables::encode(tables, contents);
+  }
+
+  std::ofstream stream(outputFile, std::ios::binary);
+  if(!stream.write(contents.data(), contents.size()))
+  {
+    std::cout << "Could not write " << outputFile << std::endl;
+    return 1;
+  }
+
+  std::cout << contents.size() << " bytes written to " << outputFile << std::endl;
+  return 0;
+}